@@ -0,0 +1,599 @@
+/**
+ * @file  : MPCSolver.h
+ * @author: Jon Woolfrey
+ * @date  : October 2026
+ * @brief : Header file for solving optimal control problems over a horizon of stages.
+ *
+ * This software is publicly available under the GNU General Public License V3.0. You are free to
+ * use it and modify it as you see fit. If you find it useful, please acknowledge it.
+ *
+ * @see https://github.com/Woolfrey/SimpleQPSolver
+ */
+
+#ifndef MPCSOLVER_H_
+#define MPCSOLVER_H_
+
+#include <QPSolver.h>
+
+/**
+ * Solves optimal control problems, such as those in model predictive control (MPC), of the form:
+ *
+ *     min  sum_k 0.5*x_k'*Q_k*x_k + x_k'*q_k + 0.5*u_k'*R_k*u_k + u_k'*r_k + u_k'*S_k*x_k
+ *     subject to: x_k+1 = A_k*x_k + B_k*u_k + c_k
+ *                 D_k*x_k + E_k*u_k <= e_k
+ *
+ * for k = 0, ..., T-1, plus a terminal cost and constraints on x_T. The initial state x_0 is given.
+ * The primal-dual interior point method is used, where each Newton step is solved with a Riccati
+ * recursion over the stages. The cost of each step grows linearly with the horizon T, rather than
+ * cubically as it would for the same problem passed to QPSolver as one large matrix.
+ * All the options of QPSolver can be set on this object too, except for the algorithm.
+ * @tparam DataType float or double.
+ */
+template <class DataType = float>
+class MPCSolver : public QPSolver<DataType>
+{
+	public:
+		typedef Matrix<DataType,Dynamic,Dynamic> MatrixX;
+		typedef Matrix<DataType,Dynamic,1>       VectorX;
+		
+		/**
+		 * The cost, dynamics and constraints for one stage. Empty vectors and matrices are treated
+		 * as zero, except for Q and R. For the terminal stage only Q, q, D and e are used.
+		 */
+		struct Stage
+		{
+			MatrixX Q;                                                                  ///< State cost, positive semi-definite
+			VectorX q;                                                                  ///< Linear state cost
+			MatrixX R;                                                                  ///< Control cost, positive definite
+			VectorX r;                                                                  ///< Linear control cost
+			MatrixX S;                                                                  ///< Cross term u'*S*x
+			MatrixX A;                                                                  ///< State transition matrix
+			MatrixX B;                                                                  ///< Control matrix
+			VectorX c;                                                                  ///< Constant term in the dynamics
+			MatrixX D;                                                                  ///< State constraint matrix
+			MatrixX E;                                                                  ///< Control constraint matrix
+			VectorX e;                                                                  ///< Constraint vector
+		};
+		
+		/**
+		 * Constructor.
+		 */
+		MPCSolver() {}
+		
+		/**
+		 * Solve the optimal control problem.
+		 * @param stages The T stages of the horizon, followed by the terminal stage.
+		 * @param x0 The initial state.
+		 * @return The trajectory [u_0; x_1; u_1; x_2; ... ; u_T-1; x_T].
+		 */
+		VectorX solve(const std::vector<Stage> &stages, const VectorX &x0);
+		
+		/**
+		 * @return The state x_k from the last solution, for k = 0, ..., T.
+		 */
+		const VectorX &state(const unsigned int &k) const { return this->stage.at(k).x; }
+		
+		/**
+		 * @return The control u_k from the last solution, for k = 0, ..., T-1.
+		 */
+		const VectorX &control(const unsigned int &k) const { return this->stage.at(k).u; }
+		
+		/**
+		 * @return The number of stages T in the last problem, not including the terminal stage.
+		 */
+		unsigned int horizon() const { return (this->stage.size() > 0) ? this->stage.size() - 1 : 0; }
+	
+	private:
+	
+		/**
+		 * Memory for one stage. Nothing is allocated unless the problem size changes.
+		 */
+		struct StageWorkspace
+		{
+			MatrixX Q, R, S, A, B, D, E;                                                ///< Copies of the problem, with zeros in place of empty arguments
+			VectorX q, r, c, e;                                                         ///< Copies of the problem, with zeros in place of empty arguments
+			
+			VectorX x;                                                                  ///< State
+			VectorX u;                                                                  ///< Control
+			VectorX s;                                                                  ///< Slack variables for the constraints
+			VectorX lambda;                                                             ///< Lagrange multipliers for the constraints
+			VectorX nu;                                                                 ///< Lagrange multipliers for the dynamics that lead to x
+			
+			VectorX gx, gu;                                                             ///< Gradient of the Lagrangian, without the dynamics
+			VectorX rp;                                                                 ///< Primal residual D*x + E*u + s - e
+			VectorX re;                                                                 ///< Dynamics residual A*x + B*u + c - x_k+1
+			VectorX rc;                                                                 ///< Complementarity residual
+			VectorX w;                                                                  ///< lambda./s
+			VectorX v;                                                                  ///< rc./s - w.*rp
+			
+			MatrixX Qt, Rt, St;                                                         ///< Hessian of the barrier problem
+			MatrixX P;                                                                  ///< Hessian of the cost-to-go
+			VectorX p;                                                                  ///< Gradient of the cost-to-go
+			MatrixX BP;                                                                 ///< B'*P from the next stage
+			MatrixX Sbar;                                                               ///< St + B'*P*A
+			MatrixX Rbar;                                                               ///< Rt + B'*P*B
+			MatrixX Acl;                                                                ///< A + B*K
+			MatrixX RK;                                                                 ///< 2*St + Rt*K
+			MatrixX K;                                                                  ///< Feedback gain du = K*dx + k
+			VectorX k;                                                                  ///< Feedforward du = K*dx + k
+			VectorX t;                                                                  ///< P*re + p from the next stage
+			LDLT<MatrixX> Rdecomp;                                                      ///< Decomposition of Rt + B'*P*B
+			
+			VectorX dx, du, ds, dlambda, nuNew;                                         ///< Newton step
+		};
+		
+		std::vector<StageWorkspace> stage;                                                  ///< One for each stage, plus the terminal stage
+		
+		/**
+		 * Copies the problem in to the workspace, and checks that the dimensions are sound.
+		 */
+		void copy_problem(const std::vector<Stage> &stages, const VectorX &x0);
+		
+		/**
+		 * Computes P, K and the decomposition of Rt + B'*P*B for every stage, which only depend on
+		 * the Hessian. They are used for both the predictor and corrector steps.
+		 * @return False if Rt + B'*P*B is not positive definite.
+		 */
+		bool riccati_factorisation();
+		
+		/**
+		 * Solves for the Newton step (dx, du) and the new multipliers for the dynamics, given the
+		 * linear terms gx and gu and the dynamics residual re.
+		 */
+		void riccati_solve();
+		
+		/**
+		 * Computes the step for the slack variables and multipliers, and the largest step size.
+		 */
+		DataType constraint_step();
+};                                                                                                  // Required after class declaration
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                      Solve the optimal control problem over the horizon                       //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType> inline
+typename MPCSolver<DataType>::VectorX
+MPCSolver<DataType>::solve(const std::vector<Stage> &stages, const VectorX &x0)
+{
+	// L = sum_k cost_k + lambda_k'*(D_k*x_k + E_k*u_k + s_k - e_k) + nu_k+1'*(A_k*x_k + B_k*u_k + c_k - x_k+1)
+	//
+	// The Newton step is the solution to an unconstrained linear-quadratic control problem with
+	// dynamics dx_k+1 = A_k*dx_k + B_k*du_k + re_k, which is solved backwards in time with a
+	// Riccati recursion, then forwards from dx_0 = 0.
+	
+	bool warm = this->warmStart and this->stage.size() == stages.size()
+	        and this->stage[0].x.size() == x0.size() and this->stage[0].u.size() == stages[0].B.cols();
+	
+	copy_problem(stages, x0);                                                                   // Also checks the dimensions
+	
+	unsigned int T = stages.size() - 1;                                                         // Number of stages
+	unsigned int n = x0.size();                                                                 // Dimension of the state
+	unsigned int p = this->stage[0].B.cols();                                                   // Dimension of the control
+	unsigned int numConstraints = 0;
+	
+	for(auto &ws : this->stage) numConstraints += ws.e.size();
+	
+	// Start from the last solution, or zero. The dynamics do not need to be satisfied, since rolling
+	// them out with u = 0 can leave the states far outside the constraints if the system is unstable.
+	for(unsigned int k = 0; k <= T; k++)
+	{
+		StageWorkspace &ws = this->stage[k];
+		
+		if(not warm)
+		{
+			if(k < T) ws.u.setZero(p);
+			
+			if(k > 0)
+			{
+				ws.x.setZero(n);
+				ws.nu.setZero(n);
+			}
+		}
+		
+		// The slack variables and multipliers must be strictly positive
+		if(warm and ws.lambda.size() == ws.e.size()) ws.lambda = ws.lambda.cwiseMax(sqrt(this->kktTol));
+		else                                         ws.lambda.setOnes(ws.e.size());
+		
+		ws.s = ws.e;
+		ws.s.noalias() -= ws.D*ws.x;
+		if(k < T) ws.s.noalias() -= ws.E*ws.u;
+		ws.s = ws.s.cwiseMax(warm ? sqrt(this->kktTol) : DataType(1));
+	}
+	
+	// Scales for the termination criteria
+	DataType costScale = 0.0;
+	for(unsigned int k = 0; k <= T; k++)
+	{
+		costScale = max(costScale, this->stage[k].q.template lpNorm<Infinity>());
+		if(k < T) costScale = max(costScale, this->stage[k].r.template lpNorm<Infinity>());
+	}
+	
+	DataType mu = 0.0;                                                                          // Average complementarity s'*lambda/c
+	
+	for(unsigned int i = 0; i < this->maxSteps; i++)
+	{
+		this->numSteps = i+1;                                                               // Increment the counter
+		
+		DataType rpNorm = 0.0, rdNorm = 0.0, reNorm = 0.0, sNorm = 0.0;
+		
+		mu = 0.0;
+		
+		// Residuals and the gradient of the Lagrangian
+		for(unsigned int k = 0; k <= T; k++)
+		{
+			StageWorkspace &ws = this->stage[k];
+			
+			// rp = D*x + E*u + s - e
+			ws.rp = ws.s - ws.e;
+			ws.rp.noalias() += ws.D*ws.x;
+			if(k < T) ws.rp.noalias() += ws.E*ws.u;
+			
+			// gx = Q*x + q + S'*u + D'*lambda
+			ws.gx = ws.q;
+			ws.gx.noalias() += ws.Q*ws.x;
+			ws.gx.noalias() += ws.D.transpose()*ws.lambda;
+			
+			if(k < T)
+			{
+				ws.gx.noalias() += ws.S.transpose()*ws.u;
+				
+				// gu = R*u + r + S*x + E'*lambda
+				ws.gu = ws.r;
+				ws.gu.noalias() += ws.R*ws.u;
+				ws.gu.noalias() += ws.S*ws.x;
+				ws.gu.noalias() += ws.E.transpose()*ws.lambda;
+				
+				// re = A*x + B*u + c - x_k+1
+				ws.re = ws.c - this->stage[k+1].x;
+				ws.re.noalias() += ws.A*ws.x;
+				ws.re.noalias() += ws.B*ws.u;
+				
+				// The dual residual includes the multipliers of the dynamics
+				const VectorX &nuNext = this->stage[k+1].nu;
+				
+				rdNorm = max(rdNorm, (ws.gu + ws.B.transpose()*nuNext).template lpNorm<Infinity>());
+				
+				if(k > 0) rdNorm = max(rdNorm, (ws.gx - ws.nu + ws.A.transpose()*nuNext).template lpNorm<Infinity>());
+				
+				reNorm = max(reNorm, ws.re.template lpNorm<Infinity>());
+			}
+			else rdNorm = max(rdNorm, (ws.gx - ws.nu).template lpNorm<Infinity>());
+			
+			if(ws.e.size() > 0)
+			{
+				rpNorm = max(rpNorm, ws.rp.template lpNorm<Infinity>());
+				sNorm  = max(sNorm, ws.s.template lpNorm<Infinity>());
+				mu    += ws.s.dot(ws.lambda);
+			}
+		}
+		
+		if(numConstraints > 0) mu /= numConstraints;
+		
+		if(mu <= this->kktTol
+		and rpNorm <= this->kktTol*(1 + sNorm)
+		and reNorm <= this->kktTol
+		and rdNorm <= this->kktTol*(1 + costScale))
+		{
+			this->numSteps = i;                                                         // Solved on the last step
+			break;
+		}
+		
+		// Qt = Q + D'*W*D, Rt = R + E'*W*E, St = S + E'*W*D
+		for(unsigned int k = 0; k <= T; k++)
+		{
+			StageWorkspace &ws = this->stage[k];
+			
+			ws.w = ws.lambda.cwiseQuotient(ws.s);
+			
+			ws.Qt = ws.Q;
+			ws.Qt.noalias() += ws.D.transpose()*ws.w.asDiagonal()*ws.D;
+			
+			if(k < T)
+			{
+				ws.Rt = ws.R;
+				ws.Rt.noalias() += ws.E.transpose()*ws.w.asDiagonal()*ws.E;
+				
+				ws.St = ws.S;
+				ws.St.noalias() += ws.E.transpose()*ws.w.asDiagonal()*ws.D;
+			}
+		}
+		
+		if(not riccati_factorisation())                                                     // Used for both the predictor and corrector
+		{
+			if(i == 0)
+			{
+				throw runtime_error("[ERROR] [MPC SOLVER] solve(): "
+				                    "Unable to solve the Riccati recursion. Is the control cost R positive definite?");
+			}
+			
+			break;                                                                      // Too ill-conditioned near the solution to go further
+		}
+		
+		// Predictor (affine scaling) step with rc = s.*lambda, so v = lambda - w.*rp
+		for(auto &ws : this->stage)
+		{
+			ws.rc = ws.s.cwiseProduct(ws.lambda);
+			ws.v  = ws.lambda - ws.w.cwiseProduct(ws.rp);
+		}
+		
+		riccati_solve();
+		
+		DataType alpha = constraint_step();
+		
+		DataType sigma = 0.0;                                                               // Centering parameter
+		
+		if(numConstraints > 0)
+		{
+			for(auto &ws : this->stage) sigma += (ws.s + alpha*ws.ds).dot(ws.lambda + alpha*ws.dlambda);
+			
+			sigma /= numConstraints*mu;
+			sigma = sigma*sigma*sigma;
+		}
+		
+		// Corrector step with rc = s.*lambda + ds.*dlambda - sigma*mu
+		for(auto &ws : this->stage)
+		{
+			ws.rc += ws.ds.cwiseProduct(ws.dlambda);
+			ws.rc.array() -= sigma*mu;
+			ws.v = ws.rc.cwiseQuotient(ws.s) - ws.w.cwiseProduct(ws.rp);
+		}
+		
+		riccati_solve();
+		
+		alpha = min(1.0, 0.99*constraint_step());                                           // Stay strictly inside the boundary
+		
+		// Take the step
+		DataType squaredNorm = 0.0;
+		
+		for(unsigned int k = 0; k <= T; k++)
+		{
+			StageWorkspace &ws = this->stage[k];
+			
+			if(k > 0)
+			{
+				ws.x  += alpha*ws.dx;
+				ws.nu += alpha*(ws.nuNew - ws.nu);
+				squaredNorm += ws.dx.squaredNorm();
+			}
+			
+			if(k < T)
+			{
+				ws.u += alpha*ws.du;
+				squaredNorm += ws.du.squaredNorm();
+			}
+			
+			ws.s      += alpha*ws.ds;
+			ws.lambda += alpha*ws.dlambda;
+		}
+		
+		this->stepSize = alpha*sqrt(squaredNorm);                                           // Magnitude of the step size
+	}
+	
+	// [u_0; x_1; u_1; x_2; ... ; u_T-1; x_T]
+	VectorX trajectory(T*(n+p));
+	for(unsigned int k = 0; k < T; k++)
+	{
+		trajectory.segment(k*(n+p),p)   = this->stage[k].u;
+		trajectory.segment(k*(n+p)+p,n) = this->stage[k+1].x;
+	}
+	
+	this->lastSolution = trajectory;
+	
+	return trajectory;
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                  Copy the problem in to the workspace and check the dimensions                //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType> inline
+void MPCSolver<DataType>::copy_problem(const std::vector<Stage> &stages, const VectorX &x0)
+{
+	if(stages.size() < 2)
+	{
+		throw invalid_argument("[ERROR] [MPC SOLVER] solve(): "
+		                       "Expected at least one stage and the terminal stage, but there were "
+		                       + to_string(stages.size()) + " stages.");
+	}
+	
+	unsigned int T = stages.size() - 1;
+	unsigned int n = x0.size();
+	unsigned int p = stages[0].B.cols();
+	
+	// Checks a matrix, which may be empty if it is allowed to be zero
+	auto check = [](const auto &matrix, const unsigned int &rows, const unsigned int &cols,
+	                const bool &optional, const std::string &name, const unsigned int &k)
+	{
+		if((optional and matrix.size() == 0) or (matrix.rows() == rows and matrix.cols() == cols)) return;
+		
+		throw invalid_argument("[ERROR] [MPC SOLVER] solve(): "
+		                       "Expected " + name + " in stage " + to_string(k) + " to be "
+		                       + to_string(rows) + "x" + to_string(cols) + ", but it was "
+		                       + to_string(matrix.rows()) + "x" + to_string(matrix.cols()) + ".");
+	};
+	
+	// Copies a matrix, or sets it to zero if it is empty
+	auto copy = [](const auto &from, auto &to, const unsigned int &rows, const unsigned int &cols)
+	{
+		if(from.size() == 0) to.setZero(rows,cols);
+		else                 to = from;
+	};
+	
+	this->stage.resize(T+1);
+	
+	for(unsigned int k = 0; k <= T; k++)
+	{
+		const Stage &problem = stages[k];
+		StageWorkspace &ws = this->stage[k];
+		
+		unsigned int c = problem.e.size();                                                  // Number of constraints on this stage
+		
+		check(problem.Q, n, n, false, "Q", k);
+		check(problem.q, n, 1, true,  "q", k);
+		check(problem.D, c, n, true,  "D", k);
+		
+		ws.Q = problem.Q;
+		copy(problem.q, ws.q, n, 1);
+		copy(problem.D, ws.D, c, n);
+		ws.e = problem.e;
+		
+		if(k < T)
+		{
+			check(problem.R, p, p, false, "R", k);
+			check(problem.r, p, 1, true,  "r", k);
+			check(problem.S, p, n, true,  "S", k);
+			check(problem.A, n, n, false, "A", k);
+			check(problem.B, n, p, false, "B", k);
+			check(problem.c, n, 1, true,  "c", k);
+			check(problem.E, c, p, true,  "E", k);
+			
+			ws.R = problem.R;
+			ws.A = problem.A;
+			ws.B = problem.B;
+			copy(problem.r, ws.r, p, 1);
+			copy(problem.S, ws.S, p, n);
+			copy(problem.c, ws.c, n, 1);
+			copy(problem.E, ws.E, c, p);
+		}
+	}
+	
+	this->stage[0].x = x0;
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                  Decompose the Hessian of the Newton step, backwards in time                  //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType> inline
+bool MPCSolver<DataType>::riccati_factorisation()
+{
+	unsigned int T = this->stage.size() - 1;
+	
+	this->stage[T].P = this->stage[T].Qt;                                                       // Cost-to-go at the end of the horizon
+	
+	for(int k = T-1; k >= 0; k--)
+	{
+		StageWorkspace &ws = this->stage[k];
+		const MatrixX &P = this->stage[k+1].P;
+		
+		// Rbar = Rt + B'*P*B, Sbar = St + B'*P*A
+		ws.BP.noalias() = ws.B.transpose()*P;
+		ws.Sbar = ws.St;
+		ws.Sbar.noalias() += ws.BP*ws.A;
+		ws.Rbar = ws.Rt;
+		ws.Rbar.noalias() += ws.BP*ws.B;
+		ws.Rdecomp.compute(ws.Rbar);
+		
+		if(ws.Rdecomp.info() != Success) return false;
+		
+		// K = -Rbar^-1*Sbar, then P = Qt + A'*P*A + Sbar'*K in the equivalent form
+		// P = Qt + St'*K + K'*St + K'*Rt*K + (A + B*K)'*P*(A + B*K), which is a sum of positive
+		// semi-definite terms and stays that way when the barrier makes the problem ill-conditioned.
+		ws.K = ws.Rdecomp.solve(ws.Sbar);
+		ws.K *= -1;
+		
+		ws.Acl = ws.A;
+		ws.Acl.noalias() += ws.B*ws.K;
+		ws.RK.noalias() = ws.Rt*ws.K;
+		ws.RK += ws.St;
+		ws.RK += ws.St;                                                                     // 2*St + Rt*K
+		
+		ws.P = ws.Qt;
+		ws.P.noalias() += ws.K.transpose()*ws.RK;
+		ws.P.noalias() += ws.Acl.transpose()*(P*ws.Acl);
+		
+		for(int j = 0; j < ws.P.cols(); j++)                                                // P = 0.5*(P + P'), in place
+		{
+			for(int i = j+1; i < ws.P.rows(); i++) ws.P(i,j) = ws.P(j,i) = 0.5*(ws.P(i,j) + ws.P(j,i));
+		}
+	}
+	
+	return true;
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //            Solve for the Newton step with a backward and a forward pass over the stages       //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType> inline
+void MPCSolver<DataType>::riccati_solve()
+{
+	unsigned int T = this->stage.size() - 1;
+	
+	// The linear terms are the gradient of the Lagrangian minus D'*v and E'*v
+	for(unsigned int k = 0; k <= T; k++)
+	{
+		StageWorkspace &ws = this->stage[k];
+		
+		ws.p = ws.gx;
+		ws.p.noalias() -= ws.D.transpose()*ws.v;
+		
+		if(k < T)
+		{
+			ws.k = ws.gu;
+			ws.k.noalias() -= ws.E.transpose()*ws.v;
+		}
+	}
+	
+	// Backward: k = -Rbar^-1*(gu + B'*t), p = gx + A'*t + Sbar'*k, where t = P*re + p of the next stage
+	for(int k = T-1; k >= 0; k--)
+	{
+		StageWorkspace &ws = this->stage[k];
+		const StageWorkspace &next = this->stage[k+1];
+		
+		ws.t = next.p;
+		ws.t.noalias() += next.P*ws.re;
+		
+		ws.k.noalias() += ws.B.transpose()*ws.t;
+		ws.Rdecomp.solveInPlace(ws.k);
+		ws.k *= -1;
+		
+		ws.p.noalias() += ws.A.transpose()*ws.t;
+		ws.p.noalias() += ws.Sbar.transpose()*ws.k;
+	}
+	
+	// Forward: du = K*dx + k, dx_k+1 = A*dx + B*du + re, starting from dx_0 = 0
+	this->stage[0].dx.setZero(this->stage[0].x.size());
+	
+	for(unsigned int k = 0; k < T; k++)
+	{
+		StageWorkspace &ws = this->stage[k];
+		StageWorkspace &next = this->stage[k+1];
+		
+		ws.du = ws.k;
+		ws.du.noalias() += ws.K*ws.dx;
+		
+		next.dx = ws.re;
+		next.dx.noalias() += ws.A*ws.dx;
+		next.dx.noalias() += ws.B*ws.du;
+		
+		next.nuNew = next.p;                                                                // Gradient of the cost-to-go
+		next.nuNew.noalias() += next.P*next.dx;
+	}
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //          Step for the slack variables and multipliers, and the largest feasible step          //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType> inline
+DataType MPCSolver<DataType>::constraint_step()
+{
+	unsigned int T = this->stage.size() - 1;
+	
+	DataType alpha = 1.0;
+	
+	for(unsigned int k = 0; k <= T; k++)
+	{
+		StageWorkspace &ws = this->stage[k];
+		
+		// ds = -rp - D*dx - E*du, dlambda = -(rc + lambda.*ds)./s
+		ws.ds = -ws.rp;
+		ws.ds.noalias() -= ws.D*ws.dx;
+		if(k < T) ws.ds.noalias() -= ws.E*ws.du;
+		
+		ws.dlambda = -(ws.rc + ws.lambda.cwiseProduct(ws.ds)).cwiseQuotient(ws.s);
+		
+		alpha = min(alpha, this->max_step(ws.s, ws.ds, ws.lambda, ws.dlambda));
+	}
+	
+	return alpha;
+}
+
+#endif
@@ -0,0 +1,899 @@
+/**
+ * @file  : QPProblem.h
+ * @author: Jon Woolfrey
+ * @date  : October 2026
+ * @brief : Header file for a QP problem whose matrices stay the same between calls.
+ *
+ * This software is publicly available under the GNU General Public License V3.0. You are free to
+ * use it and modify it as you see fit. If you find it useful, please acknowledge it.
+ *
+ * @see https://github.com/Woolfrey/SimpleQPSolver
+ */
+
+#ifndef QPPROBLEM_H_
+#define QPPROBLEM_H_
+
+#include <QPSolver.h>
+
+/**
+ * A QP problem where the matrices stay the same for many calls and only the vectors change, such
+ * as in model predictive control or task space control. The matrices are copied once, and their
+ * decompositions are kept until one of them is updated. All the options of QPSolver can be set on
+ * this object too.
+ * @tparam DataType float or double.
+ * @tparam N Number of decision variables.
+ * @tparam C Number of inequality constraints.
+ * @tparam M Number of equality constraints (or outputs for least squares problems).
+ */
+template <class DataType = float, int N = Dynamic, int C = Dynamic, int M = Dynamic,
+          template <class> class Factorisation = LDLTFactorisation>
+class QPProblem : public QPSolver<DataType,N,C,M,Factorisation>
+{
+	public:
+		/**
+		 * A problem of the form min 0.5*x'*H*x + x'*f subject to B*x <= z.
+		 * @param H A positive semi-definite matrix such that H = H'.
+		 * @param f A vector for the linear component of the problem.
+		 * @param B The constraint matrix.
+		 * @param z The constraint vector.
+		 */
+		QPProblem(const Matrix<DataType,N,N> &H,
+		          const Vector<DataType,N>   &f,
+		          const Matrix<DataType,C,N> &B,
+		          const Vector<DataType,C>   &z);
+		
+		/**
+		 * A problem of the form min 0.5*(y - A*x)'*W*(y - A*x) subject to xMin <= x <= xMax.
+		 * @param y The vector component of the linear equation.
+		 * @param A The matrix component of the linear equation.
+		 * @param W A positive definite weighting matrix.
+		 * @param xMin The lower bound on the decision variable.
+		 * @param xMax The upper bound on the decision variable.
+		 */
+		QPProblem(const Vector<DataType,M>   &y,
+		          const Matrix<DataType,M,N> &A,
+		          const Matrix<DataType,M,M> &W,
+		          const Vector<DataType,N>   &xMin,
+		          const Vector<DataType,N>   &xMax);
+		
+		/**
+		 * A problem of the form min 0.5*(xd - x)'*W*(xd - x) subject to A*x = y, B*x <= z.
+		 * @param xd The desired value for the decision variable.
+		 * @param W A positive definite weighting matrix.
+		 * @param A The equality constraint matrix.
+		 * @param y The equality constraint vector.
+		 * @param B The inequality constraint matrix.
+		 * @param z The inequality constraint vector.
+		 */
+		QPProblem(const Vector<DataType,N>   &xd,
+		          const Matrix<DataType,N,N> &W,
+		          const Matrix<DataType,M,N> &A,
+		          const Vector<DataType,M>   &y,
+		          const Matrix<DataType,C,N> &B,
+		          const Vector<DataType,C>   &z);
+		
+		/**
+		 * A problem of the form min 0.5*(xd - x)'*W*(xd - x) subject to A*x = y, xMin <= x <= xMax.
+		 * @param xd The desired value for the decision variable.
+		 * @param W A positive definite weighting matrix.
+		 * @param A The equality constraint matrix.
+		 * @param y The equality constraint vector.
+		 * @param xMin The lower bound on the decision variable.
+		 * @param xMax The upper bound on the decision variable.
+		 */
+		QPProblem(const Vector<DataType,N>   &xd,
+		          const Matrix<DataType,N,N> &W,
+		          const Matrix<DataType,M,N> &A,
+		          const Vector<DataType,M>   &y,
+		          const Vector<DataType,N>   &xMin,
+		          const Vector<DataType,N>   &xMax);
+		
+		/**
+		 * Solve the problem with the current vectors. The decompositions of the matrices are reused
+		 * if none of them have been updated since the last call.
+		 * @param x0 The start point for the interior point algorithm.
+		 * @return The solution for the decision variable.
+		 */
+		Vector<DataType,N> solve(const Vector<DataType,N> &x0);
+		
+		/**
+		 * Set a new linear component f for min 0.5*x'*H*x + x'*f.
+		 */
+		void update_f(const Vector<DataType,N> &f);
+		
+		/**
+		 * Set a new inequality constraint vector z for B*x <= z.
+		 */
+		void update_z(const Vector<DataType,C> &z);
+		
+		/**
+		 * Set a new vector y for the least squares output, or the equality constraint A*x = y.
+		 */
+		void update_y(const Vector<DataType,M> &y);
+		
+		/**
+		 * Set a new desired value xd for redundant problems.
+		 */
+		void update_xd(const Vector<DataType,N> &xd);
+		
+		/**
+		 * Set new bounds xMin <= x <= xMax.
+		 */
+		void update_bounds(const Vector<DataType,N> &xMin, const Vector<DataType,N> &xMax);
+		
+		/**
+		 * Set a new Hessian H. It will be decomposed again on the next call to solve().
+		 */
+		void update_H(const Matrix<DataType,N,N> &H);
+		
+		/**
+		 * Set a new weighting matrix W, which is MxM for least squares problems and NxN for
+		 * redundant problems. It will be decomposed again on the next call to solve().
+		 */
+		void update_W(const Matrix<DataType,Dynamic,Dynamic> &W);
+		
+		/**
+		 * Set a new matrix A. It will be decomposed again on the next call to solve().
+		 */
+		void update_A(const Matrix<DataType,M,N> &A);
+		
+		/**
+		 * Set a new inequality constraint matrix B. It will be decomposed again on the next call to solve().
+		 */
+		void update_B(const Matrix<DataType,C,N> &B);
+		
+		/**
+		 * Add sigma*U*U' to the Hessian H, e.g. k new terms. The decomposition used by the active
+		 * set method is updated in O(n^2*k) instead of being computed again.
+		 * @param U An Nxk matrix whose columns are the terms.
+		 * @param sigma 1 to add the terms, -1 to remove them.
+		 */
+		void rank_update_H(const Matrix<DataType,N,Dynamic> &U, const DataType &sigma = 1);
+		
+		/**
+		 * Add sigma*U*U' to the weighting matrix W. For least squares problems A'*W*A is updated in
+		 * O(n^2*k). For redundant problems the decomposition of W is updated, and the products with
+		 * A are formed again from it in O(n^2*m).
+		 * @param U A matrix with k columns, and a row for each row of W.
+		 * @param sigma 1 to add the terms, -1 to remove them.
+		 */
+		void rank_update_W(const Matrix<DataType,Dynamic,Dynamic> &U, const DataType &sigma = 1);
+		
+		/**
+		 * Add a row a'*x = y to a least squares problem, e.g. a new measurement, with its own weight.
+		 * A'*W*A is updated in O(n^2) instead of being formed again.
+		 * @param a The new row of A.
+		 * @param y The new element of y.
+		 * @param w The weight on the new row.
+		 */
+		void add_row(const Vector<DataType,N> &a, const DataType &y, const DataType &w = 1);
+		
+		/**
+		 * Remove a row of A, y and W from a least squares problem. A'*W*A is updated in O(n^2) if
+		 * the row is not coupled to the others in W, otherwise it is formed again on the next call.
+		 * @param i The index of the row.
+		 */
+		void remove_row(const unsigned int &i);
+		
+		/**
+		 * Append an inequality constraint b'*x <= z. The decompositions are kept, and the null space
+		 * method maps only the new row on to the null space of A.
+		 * @param b The new row of B.
+		 * @param z The new element of z.
+		 */
+		void add_constraint(const Vector<DataType,N> &b, const DataType &z);
+		
+		/**
+		 * Remove an inequality constraint. The decompositions are kept.
+		 * @param i The index of the row of B and z.
+		 */
+		void remove_constraint(const unsigned int &i);
+	
+	private:
+	
+		typedef QPSolver<DataType,N,C,M,Factorisation> Solver;
+		
+		enum Form {standardForm, leastSquaresForm, redundantForm, redundantBoundsForm} form; ///< Which type of problem this is
+		
+		Matrix<DataType,N,N> H;                                                             ///< Hessian for the standard form
+		Vector<DataType,N>   f;                                                             ///< Linear component for the standard form
+		Matrix<DataType,C,N> B;                                                             ///< Inequality constraint matrix
+		Vector<DataType,C>   z;                                                             ///< Inequality constraint vector
+		Vector<DataType,M>   y;                                                             ///< Least squares output, or equality constraint vector
+		Matrix<DataType,M,N> A;                                                             ///< Least squares matrix, or equality constraint matrix
+		Matrix<DataType,M,M> Wy;                                                            ///< Weighting matrix on the output for least squares problems
+		Matrix<DataType,N,N> W;                                                             ///< Weighting matrix for redundant problems
+		Vector<DataType,N>   xd;                                                            ///< Desired value for redundant problems
+		Vector<DataType,N>   xMin;                                                          ///< Lower bound on the decision variable
+		Vector<DataType,N>   xMax;                                                          ///< Upper bound on the decision variable
+		
+		typename Solver::Algorithm cachedAlgorithm;                                         ///< The algorithm used when the matrices were last decomposed
+		
+		bool resized = false;                                                               ///< Rows were added or removed since the last call, so the workspace is sized again
+		
+		/**
+		 * Updates the decompositions of a redundant problem after W has changed by sigma*U*U'.
+		 */
+		template <class Workspace, class NullSpaceWorkspace>
+		void rank_update_redundant(Workspace &ws, NullSpaceWorkspace &ns, const Matrix<DataType,Dynamic,Dynamic> &U, const DataType &sigma);
+		
+		/**
+		 * Removes a row from a matrix or vector by moving the rows below it up.
+		 */
+		template <class MatrixType>
+		static void erase_row(MatrixType &matrix, const unsigned int &i);
+		
+		/**
+		 * Throws an exception if the number of rows is fixed at compile time.
+		 */
+		void check_dynamic(const std::string &function, const bool &dynamic) const;
+		
+		/**
+		 * Throws an exception if a vector does not have the expected number of elements.
+		 */
+		void check_size(const std::string &function, const std::string &name, const unsigned int &size, const unsigned int &expected) const;
+		
+		/**
+		 * Throws an exception if the function being called does not apply to this type of problem.
+		 */
+		void check_form(const std::string &function, const bool &valid) const;
+		
+		/**
+		 * Throws an exception if the dimensions of the matrices and vectors do not match.
+		 */
+		void check_dimensions() const;
+};                                                                                                  // Required after class declaration
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                      A problem min 0.5*x'*H*x + x'*f subject to B*x <= z                       //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+QPProblem<DataType,N,C,M,Factorisation>::QPProblem(const Matrix<DataType,N,N> &_H,
+                                                   const Vector<DataType,N>   &_f,
+                                                   const Matrix<DataType,C,N> &_B,
+                                                   const Vector<DataType,C>   &_z)
+                                     : form(standardForm), H(_H), f(_f), B(_B), z(_z)
+{
+	check_dimensions();
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //             A problem min 0.5*(y - A*x)'*W*(y - A*x) subject to xMin <= x <= xMax              //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+QPProblem<DataType,N,C,M,Factorisation>::QPProblem(const Vector<DataType,M>   &_y,
+                                                   const Matrix<DataType,M,N> &_A,
+                                                   const Matrix<DataType,M,M> &_W,
+                                                   const Vector<DataType,N>   &_xMin,
+                                                   const Vector<DataType,N>   &_xMax)
+                                     : form(leastSquaresForm), y(_y), A(_A), Wy(_W), xMin(_xMin), xMax(_xMax)
+{
+	check_dimensions();
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //              A problem min 0.5*(xd - x)'*W*(xd - x) subject to A*x = y, B*x <= z               //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+QPProblem<DataType,N,C,M,Factorisation>::QPProblem(const Vector<DataType,N>   &_xd,
+                                                   const Matrix<DataType,N,N> &_W,
+                                                   const Matrix<DataType,M,N> &_A,
+                                                   const Vector<DataType,M>   &_y,
+                                                   const Matrix<DataType,C,N> &_B,
+                                                   const Vector<DataType,C>   &_z)
+                                     : form(redundantForm), B(_B), z(_z), y(_y), A(_A), W(_W), xd(_xd)
+{
+	check_dimensions();
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //          A problem min 0.5*(xd - x)'*W*(xd - x) subject to A*x = y, xMin <= x <= xMax          //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+QPProblem<DataType,N,C,M,Factorisation>::QPProblem(const Vector<DataType,N>   &_xd,
+                                                   const Matrix<DataType,N,N> &_W,
+                                                   const Matrix<DataType,M,N> &_A,
+                                                   const Vector<DataType,M>   &_y,
+                                                   const Vector<DataType,N>   &_xMin,
+                                                   const Vector<DataType,N>   &_xMax)
+                                     : form(redundantBoundsForm), y(_y), A(_A), W(_W), xd(_xd), xMin(_xMin), xMax(_xMax)
+{
+	check_dimensions();
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //           Solve the problem, reusing the decompositions of the matrices if possible            //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation> inline
+Vector<DataType,N>
+QPProblem<DataType,N,C,M,Factorisation>::solve(const Vector<DataType,N> &x0)
+{
+	unsigned int n = (this->form == standardForm) ? this->H.rows() : this->A.cols();
+	
+	check_size("solve", "start point x0", x0.size(), n);
+	
+	// reuse_workspace() clears the cache if another function used the workspace in between
+	bool unchanged = this->cached and this->algorithm == this->cachedAlgorithm;
+	
+	if(this->form == standardForm)
+	{
+		bool factorised = this->reuse_workspace(Solver::generic, n, 0, this->B.rows()) and unchanged;
+		
+		typename Solver::MallocGuard guard(not factorised or this->resized);
+		
+		typename Solver::template Workspace<N,C> &ws = this->genericWorkspace;              // Makes the code easier to read
+		
+		typename Solver::template LinearConstraints<> constraints(this->B, this->z, ws.Bw, this);
+		
+		if(this->algorithm == Solver::activeSetMethod)
+		{
+			this->active_set_method(this->H, this->f, typename Solver::NoEqualities(), constraints, ws, factorised);
+			
+			ws.x = ws.activeSet.x;
+		}
+		else this->interior_point(this->H, this->f, constraints, x0, ws);                   // H is not decomposed, only H + barrier
+		
+		this->lastSolution = ws.x;
+	}
+	else if(this->form == leastSquaresForm)
+	{
+		bool factorised = this->reuse_workspace(Solver::boundedLeastSquares, n, this->A.rows(), 2*n) and unchanged;
+		
+		typename Solver::MallocGuard guard(not factorised or this->resized);
+		
+		typename Solver::template Workspace<N,Solver::twoN> &ws = this->boundsWorkspace;    // Makes the code easier to read
+		
+		typename Solver::BoundConstraints constraints(this->xMin, this->xMax);
+		
+		if(not factorised)
+		{
+			this->leastSquares.AtW.noalias() = this->A.transpose()*this->Wy;
+			ws.H.noalias() = this->leastSquares.AtW*this->A;
+		}
+		
+		ws.f.noalias() = -this->leastSquares.AtW*this->y;                                   // Only the output has changed
+		
+		if(this->algorithm == Solver::activeSetMethod)
+		{
+			this->active_set_method(ws.H, ws.f, typename Solver::NoEqualities(), constraints, ws, factorised);
+			
+			ws.x = ws.activeSet.x;
+		}
+		else this->interior_point(ws.H, ws.f, constraints, x0, ws);
+		
+		this->lastSolution = ws.x;
+	}
+	else
+	{
+		bool bounds = (this->form == redundantBoundsForm);
+		
+		unsigned int c = bounds ? 2*n : this->B.rows();
+		
+		typename Solver::Call call;
+		
+		if(this->method == Solver::primal)    call = bounds ? Solver::redundantBoundsPrimal    : Solver::redundantPrimal;
+		else if(this->method == Solver::dual) call = bounds ? Solver::redundantBoundsDual      : Solver::redundantDual;
+		else                                  call = bounds ? Solver::redundantBoundsNullSpace : Solver::redundantNullSpace;
+		
+		bool factorised = this->reuse_workspace(call, n, this->A.rows(), c) and unchanged;
+		
+		{
+			typename Solver::MallocGuard guard(not factorised or this->resized);
+			
+			if(bounds)
+			{
+				typename Solver::BoundConstraints constraints(this->xMin, this->xMax);
+				
+				this->redundant_interior_point(this->xd, this->W, this->A, this->y, constraints, x0,
+				                               this->redundantBoundsWorkspace, this->nullSpaceBoundsWorkspace, factorised);
+			}
+			else
+			{
+				typename Solver::template LinearConstraints<> constraints(this->B, this->z, this->redundantWorkspace.Bw, this);
+				
+				this->redundant_interior_point(this->xd, this->W, this->A, this->y, constraints, x0,
+				                               this->redundantWorkspace, this->nullSpaceWorkspace, factorised);
+			}
+		}
+		
+		if(this->method == Solver::primal or this->algorithm == Solver::activeSetMethod)
+		{
+			if(bounds) this->lastSolution = this->redundantBoundsWorkspace.x.tail(n);   // We don't need the Lagrange multipliers
+			else       this->lastSolution = this->redundantWorkspace.x.tail(n);
+		}
+		else this->lastSolution = this->leastSquares.xr;
+	}
+	
+	this->cached          = true;                                                               // Only reached if there were no errors
+	this->cachedAlgorithm = this->algorithm;
+	this->resized         = false;
+	
+	return this->lastSolution;
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                           Set a new linear component of the problem                            //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation> inline
+void QPProblem<DataType,N,C,M,Factorisation>::update_f(const Vector<DataType,N> &_f)
+{
+	check_form("update_f", this->form == standardForm);
+	check_size("update_f", "vector f", _f.size(), this->f.size());
+	
+	this->f = _f;
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                             Set a new inequality constraint vector                             //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation> inline
+void QPProblem<DataType,N,C,M,Factorisation>::update_z(const Vector<DataType,C> &_z)
+{
+	check_form("update_z", this->form == standardForm or this->form == redundantForm);
+	check_size("update_z", "constraint vector z", _z.size(), this->z.size());
+	
+	this->z = _z;
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                        Set a new output, or equality constraint vector                         //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation> inline
+void QPProblem<DataType,N,C,M,Factorisation>::update_y(const Vector<DataType,M> &_y)
+{
+	check_form("update_y", this->form != standardForm);
+	check_size("update_y", "vector y", _y.size(), this->y.size());
+	
+	this->y = _y;
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                         Set a new desired value for redundant problems                         //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation> inline
+void QPProblem<DataType,N,C,M,Factorisation>::update_xd(const Vector<DataType,N> &_xd)
+{
+	check_form("update_xd", this->form == redundantForm or this->form == redundantBoundsForm);
+	check_size("update_xd", "desired value xd", _xd.size(), this->xd.size());
+	
+	this->xd = _xd;
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                            Set new bounds on the decision variable                             //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation> inline
+void QPProblem<DataType,N,C,M,Factorisation>::update_bounds(const Vector<DataType,N> &_xMin, const Vector<DataType,N> &_xMax)
+{
+	check_form("update_bounds", this->form == leastSquaresForm or this->form == redundantBoundsForm);
+	check_size("update_bounds", "lower bound xMin", _xMin.size(), this->xMin.size());
+	check_size("update_bounds", "upper bound xMax", _xMax.size(), this->xMax.size());
+	
+	this->xMin = _xMin;
+	this->xMax = _xMax;
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                                       Set a new Hessian                                        //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation> inline
+void QPProblem<DataType,N,C,M,Factorisation>::update_H(const Matrix<DataType,N,N> &_H)
+{
+	check_form("update_H", this->form == standardForm);
+	check_size("update_H", "rows of the Hessian H", _H.rows(), this->H.rows());
+	check_size("update_H", "columns of the Hessian H", _H.cols(), this->H.cols());
+	
+	this->H = _H;
+	
+	this->cached = false;                                                                       // Decompose again on the next call
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                                   Set a new weighting matrix                                   //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation> inline
+void QPProblem<DataType,N,C,M,Factorisation>::update_W(const Matrix<DataType,Dynamic,Dynamic> &_W)
+{
+	check_form("update_W", this->form != standardForm);
+	
+	unsigned int size = (this->form == leastSquaresForm) ? this->A.rows() : this->A.cols();
+	
+	check_size("update_W", "rows of the weighting matrix W", _W.rows(), size);
+	check_size("update_W", "columns of the weighting matrix W", _W.cols(), size);
+	
+	if(this->form == leastSquaresForm) this->Wy = _W;
+	else                               this->W  = _W;
+	
+	this->cached = false;                                                                       // Decompose again on the next call
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                     Set a new least squares, or equality constraint matrix                     //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation> inline
+void QPProblem<DataType,N,C,M,Factorisation>::update_A(const Matrix<DataType,M,N> &_A)
+{
+	check_form("update_A", this->form != standardForm);
+	check_size("update_A", "rows of the matrix A", _A.rows(), this->A.rows());
+	check_size("update_A", "columns of the matrix A", _A.cols(), this->A.cols());
+	
+	this->A = _A;
+	
+	this->cached = false;                                                                       // Decompose again on the next call
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                             Set a new inequality constraint matrix                             //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation> inline
+void QPProblem<DataType,N,C,M,Factorisation>::update_B(const Matrix<DataType,C,N> &_B)
+{
+	check_form("update_B", this->form == standardForm or this->form == redundantForm);
+	check_size("update_B", "rows of the constraint matrix B", _B.rows(), this->B.rows());
+	check_size("update_B", "columns of the constraint matrix B", _B.cols(), this->B.cols());
+	
+	this->B = _B;
+	
+	this->cached = false;                                                                       // The null space method maps B on to the null space of A
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                                Add a rank k term to the Hessian                                //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation> inline
+void QPProblem<DataType,N,C,M,Factorisation>::rank_update_H(const Matrix<DataType,N,Dynamic> &U, const DataType &sigma)
+{
+	check_form("rank_update_H", this->form == standardForm);
+	check_size("rank_update_H", "rows of the update U", U.rows(), this->H.rows());
+	
+	this->H.noalias() += sigma*U*U.transpose();
+	
+	// The interior point algorithms factorise H plus the barrier on every step, so only
+	// the active set method keeps a decomposition of H
+	if(this->cached and this->cachedAlgorithm == Solver::activeSetMethod)
+	{
+		rank_update(this->genericWorkspace.activeSet.Hdecomp, this->H, U, sigma);
+	}
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                           Add a rank k term to the weighting matrix                            //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation> inline
+void QPProblem<DataType,N,C,M,Factorisation>::rank_update_W(const Matrix<DataType,Dynamic,Dynamic> &U, const DataType &sigma)
+{
+	check_form("rank_update_W", this->form != standardForm);
+	
+	if(this->form == leastSquaresForm)
+	{
+		check_size("rank_update_W", "rows of the update U", U.rows(), this->A.rows());
+		
+		this->Wy.noalias() += sigma*U*U.transpose();
+		
+		if(this->cached)
+		{
+			// A'*(W + sigma*U*U')*A = A'*W*A + sigma*(A'*U)*(A'*U)'
+			Matrix<DataType,N,Dynamic> AtU = this->A.transpose()*U;
+			
+			typename Solver::template Workspace<N,Solver::twoN> &ws = this->boundsWorkspace;
+			
+			this->leastSquares.AtW.noalias() += sigma*AtU*U.transpose();
+			ws.H.noalias() += sigma*AtU*AtU.transpose();
+			
+			if(this->cachedAlgorithm == Solver::activeSetMethod) rank_update(ws.activeSet.Hdecomp, ws.H, AtU, sigma);
+		}
+	}
+	else
+	{
+		check_size("rank_update_W", "rows of the update U", U.rows(), this->A.cols());
+		
+		this->W.noalias() += sigma*U*U.transpose();
+		
+		if(this->cached)
+		{
+			if(this->form == redundantBoundsForm) rank_update_redundant(this->redundantBoundsWorkspace, this->nullSpaceBoundsWorkspace, U, sigma);
+			else                                  rank_update_redundant(this->redundantWorkspace, this->nullSpaceWorkspace, U, sigma);
+		}
+	}
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                        Update the decompositions of a redundant problem                        //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+template <class Workspace, class NullSpaceWorkspace> inline
+void QPProblem<DataType,N,C,M,Factorisation>::rank_update_redundant(Workspace                              &ws,
+                                                                    NullSpaceWorkspace                     &ns,
+                                                                    const Matrix<DataType,Dynamic,Dynamic> &U,
+                                                                    const DataType                         &sigma)
+{
+	typename Solver::LeastSquaresWorkspace &ls = this->leastSquares;                            // Makes the code easier to read
+	
+	if(this->cachedAlgorithm == Solver::activeSetMethod)
+	{
+		rank_update(ws.activeSet.Hdecomp, this->W, U, sigma);
+		
+		return;
+	}
+	
+	unsigned int m = this->A.rows();
+	unsigned int n = this->A.cols();
+	
+	// Every method uses W^-1*A' and A*W^-1*A', which are formed again from the new decomposition
+	rank_update(ls.Wdecomp, this->W, U, sigma);
+	ls.invWAt = ls.Wdecomp.solve(this->A.transpose());
+	ls.AinvWAt.noalias() = this->A*ls.invWAt;
+	ls.AinvWAtdecomp.compute(ls.AinvWAt);
+	
+	if(this->lastCall == Solver::redundantPrimal or this->lastCall == Solver::redundantBoundsPrimal)
+	{
+		ws.H.block(m,m,n,n).noalias() += sigma*U*U.transpose();                              // H = [0 -A; -A' W]
+	}
+	else if(this->lastCall == Solver::redundantNullSpace or this->lastCall == Solver::redundantBoundsNullSpace)
+	{
+		// Z'*(W + sigma*U*U')*Z = Z'*W*Z + sigma*(Z'*U)*(Z'*U)'
+		Matrix<DataType,Dynamic,Dynamic> ZtU = ns.Z.transpose()*U;
+		
+		ns.WZ.noalias() += sigma*U*ZtU.transpose();
+		ns.reduced.H.noalias() += sigma*ZtU*ZtU.transpose();
+	}
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                              Add a row to a least squares problem                              //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation> inline
+void QPProblem<DataType,N,C,M,Factorisation>::add_row(const Vector<DataType,N> &a, const DataType &_y, const DataType &w)
+{
+	check_form("add_row", this->form == leastSquaresForm);
+	check_dynamic("add_row", M == Dynamic);
+	check_size("add_row", "new row a", a.size(), this->A.cols());
+	
+	unsigned int m = this->A.rows();
+	unsigned int n = this->A.cols();
+	
+	this->A.conservativeResize(m+1,n);
+	this->A.row(m) = a.transpose();
+	
+	this->y.conservativeResize(m+1);
+	this->y(m) = _y;
+	
+	this->Wy.conservativeResize(m+1,m+1);
+	this->Wy.row(m).setZero();
+	this->Wy.col(m).setZero();
+	this->Wy(m,m) = w;
+	
+	if(this->cached)
+	{
+		typename Solver::template Workspace<N,Solver::twoN> &ws = this->boundsWorkspace;
+		
+		this->leastSquares.AtW.conservativeResize(n,m+1);
+		this->leastSquares.AtW.col(m) = w*a;
+		
+		ws.H.noalias() += w*a*a.transpose();                                                // A'*W*A + w*a*a'
+		
+		if(this->cachedAlgorithm == Solver::activeSetMethod) rank_update(ws.activeSet.Hdecomp, ws.H, a, w);
+		
+		this->lastDimensions[1] = m+1;                                                      // So reuse_workspace() keeps the decompositions
+		this->resized = true;
+	}
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                           Remove a row from a least squares problem                            //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation> inline
+void QPProblem<DataType,N,C,M,Factorisation>::remove_row(const unsigned int &i)
+{
+	check_form("remove_row", this->form == leastSquaresForm);
+	check_dynamic("remove_row", M == Dynamic);
+	
+	unsigned int m = this->A.rows();
+	
+	if(i >= m)
+	{
+		throw invalid_argument("[ERROR] [QP PROBLEM] remove_row(): "
+		                       "Cannot remove row " + to_string(i) + " of " + to_string(m) + ".");
+	}
+	
+	// Only a row that is not weighted together with the others is a rank one downdate
+	bool decoupled = this->Wy.row(i).template lpNorm<1>() == abs(this->Wy(i,i))
+	             and this->Wy.col(i).template lpNorm<1>() == abs(this->Wy(i,i));
+	
+	if(this->cached and decoupled)
+	{
+		typename Solver::template Workspace<N,Solver::twoN> &ws = this->boundsWorkspace;
+		
+		DataType w = this->Wy(i,i);
+		Vector<DataType,N> a = this->A.row(i).transpose();
+		
+		ws.H.noalias() -= w*a*a.transpose();                                                // A'*W*A - w*a*a'
+		
+		if(this->cachedAlgorithm == Solver::activeSetMethod) rank_update(ws.activeSet.Hdecomp, ws.H, a, -w);
+		
+		Matrix<DataType,M,N> AtW = this->leastSquares.AtW.transpose();                      // Erase the column as a row
+		erase_row(AtW, i);
+		this->leastSquares.AtW = AtW.transpose();
+		
+		this->lastDimensions[1] = m-1;                                                      // So reuse_workspace() keeps the decompositions
+		this->resized = true;
+	}
+	else this->cached = false;                                                                  // Form A'*W*A again on the next call
+	
+	erase_row(this->A, i);
+	erase_row(this->y, i);
+	erase_row(this->Wy, i);
+	
+	Matrix<DataType,M,M> Wt = this->Wy.transpose();                                             // Erase the column as a row
+	erase_row(Wt, i);
+	this->Wy = Wt.transpose();
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                                Append an inequality constraint                                 //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation> inline
+void QPProblem<DataType,N,C,M,Factorisation>::add_constraint(const Vector<DataType,N> &b, const DataType &_z)
+{
+	check_form("add_constraint", this->form == standardForm or this->form == redundantForm);
+	check_dynamic("add_constraint", C == Dynamic);
+	check_size("add_constraint", "new row b", b.size(), this->B.cols());
+	
+	unsigned int c = this->B.rows();
+	
+	this->B.conservativeResize(c+1,this->B.cols());
+	this->B.row(c) = b.transpose();
+	
+	this->z.conservativeResize(c+1);
+	this->z(c) = _z;
+	
+	if(this->cached)
+	{
+		if(this->lastCall == Solver::redundantNullSpace
+		and this->cachedAlgorithm != Solver::activeSetMethod)                               // ns.B = B*Z
+		{
+			typename Solver::template NullSpaceWorkspace<C> &ns = this->nullSpaceWorkspace;
+			
+			ns.B.conservativeResize(c+1,ns.Z.cols());
+			ns.B.row(c).noalias() = b.transpose()*ns.Z;
+		}
+		
+		this->lastDimensions[2] = c+1;                                                      // So reuse_workspace() keeps the decompositions
+		this->resized = true;
+	}
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                                Remove an inequality constraint                                 //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation> inline
+void QPProblem<DataType,N,C,M,Factorisation>::remove_constraint(const unsigned int &i)
+{
+	check_form("remove_constraint", this->form == standardForm or this->form == redundantForm);
+	check_dynamic("remove_constraint", C == Dynamic);
+	
+	unsigned int c = this->B.rows();
+	
+	if(i >= c)
+	{
+		throw invalid_argument("[ERROR] [QP PROBLEM] remove_constraint(): "
+		                       "Cannot remove constraint " + to_string(i) + " of " + to_string(c) + ".");
+	}
+	
+	erase_row(this->B, i);
+	erase_row(this->z, i);
+	
+	if(this->cached)
+	{
+		if(this->lastCall == Solver::redundantNullSpace
+		and this->cachedAlgorithm != Solver::activeSetMethod)                               // ns.B = B*Z
+		{
+			erase_row(this->nullSpaceWorkspace.B, i);
+		}
+		
+		this->lastDimensions[2] = c-1;                                                      // So reuse_workspace() keeps the decompositions
+		this->resized = true;
+	}
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                              Remove a row from a matrix or vector                              //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+template <class MatrixType> inline
+void QPProblem<DataType,N,C,M,Factorisation>::erase_row(MatrixType &matrix, const unsigned int &i)
+{
+	unsigned int below = matrix.rows() - i - 1;
+	
+	matrix.middleRows(i,below) = matrix.bottomRows(below).eval();                               // Rows overlap, so copy them first
+	matrix.conservativeResize(matrix.rows()-1, matrix.cols());
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                    Check that a vector has the expected number of elements                     //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation> inline
+void QPProblem<DataType,N,C,M,Factorisation>::check_size(const std::string  &function,
+                                                         const std::string  &name,
+                                                         const unsigned int &size,
+                                                         const unsigned int &expected) const
+{
+	if(size != expected)
+	{
+		throw invalid_argument("[ERROR] [QP PROBLEM] " + function + "(): "
+		                       "Expected the " + name + " to have " + to_string(expected) + " elements, "
+		                       "but it had " + to_string(size) + ".");
+	}
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                     Check that a function applies to this type of problem                      //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation> inline
+void QPProblem<DataType,N,C,M,Factorisation>::check_form(const std::string &function, const bool &valid) const
+{
+	if(not valid)
+	{
+		throw invalid_argument("[ERROR] [QP PROBLEM] " + function + "(): "
+		                       "This type of problem does not have that argument.");
+	}
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                            Check that the number of rows can change                            //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation> inline
+void QPProblem<DataType,N,C,M,Factorisation>::check_dynamic(const std::string &function, const bool &dynamic) const
+{
+	if(not dynamic)
+	{
+		throw invalid_argument("[ERROR] [QP PROBLEM] " + function + "(): "
+		                       "The number of rows is fixed at compile time.");
+	}
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                       Check that the dimensions of the problem are sound                       //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation> inline
+void QPProblem<DataType,N,C,M,Factorisation>::check_dimensions() const
+{
+	if(this->form == standardForm)
+	{
+		check_size("QPProblem", "columns of the Hessian H", this->H.cols(), this->H.rows());
+		check_size("QPProblem", "vector f", this->f.size(), this->H.rows());
+		check_size("QPProblem", "columns of the constraint matrix B", this->B.cols(), this->H.rows());
+		check_size("QPProblem", "constraint vector z", this->z.size(), this->B.rows());
+	}
+	else
+	{
+		unsigned int n = this->A.cols();
+		
+		check_size("QPProblem", "vector y", this->y.size(), this->A.rows());
+		
+		if(this->form == leastSquaresForm)
+		{
+			check_size("QPProblem", "rows of the weighting matrix W", this->Wy.rows(), this->A.rows());
+			check_size("QPProblem", "columns of the weighting matrix W", this->Wy.cols(), this->A.rows());
+		}
+		else
+		{
+			check_size("QPProblem", "rows of the weighting matrix W", this->W.rows(), n);
+			check_size("QPProblem", "columns of the weighting matrix W", this->W.cols(), n);
+			check_size("QPProblem", "desired value xd", this->xd.size(), n);
+		}
+		
+		if(this->form == redundantForm)
+		{
+			check_size("QPProblem", "columns of the constraint matrix B", this->B.cols(), n);
+			check_size("QPProblem", "constraint vector z", this->z.size(), this->B.rows());
+		}
+		else
+		{
+			check_size("QPProblem", "lower bound xMin", this->xMin.size(), n);
+			check_size("QPProblem", "upper bound xMax", this->xMax.size(), n);
+		}
+	}
+}
+
+#endif
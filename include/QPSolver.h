@@ -13,21 +13,216 @@
 #ifndef QPSOLVER_H_
 #define QPSOLVER_H_
 
+#include <algorithm>                                                                                // equal, stable_partition
+#include <atomic>                                                                                   // atomic
+#include <chrono>                                                                                   // steady_clock
+#include <condition_variable>                                                                       // condition_variable
 #include <Eigen/Dense>                                                                              // Linear algebra and matrix decomposition
+#include <Eigen/Sparse>                                                                             // SparseMatrix, SimplicialLDLT
+#include <functional>                                                                               // function
+#include <future>                                                                                   // async, future
 #include <iostream>                                                                                 // cerr, cout
+#include <memory>                                                                                   // unique_ptr
+#include <mutex>                                                                                    // mutex, lock_guard
+#include <thread>                                                                                   // thread
 #include <vector>                                                                                   // vector
 
 using namespace Eigen;                                                                              // Eigen::Dynamic, Eigen::Matrix
 using namespace std;                                                                                // std::invalid_argument, std::to_string
 
-template <class DataType = float>
+/**
+ * Factorisations for the symmetric systems in QPSolver, chosen with its last template parameter:
+ * - LDLTFactorisation is the default. It also works for semi-definite matrices.
+ * - LLTFactorisation is faster, but the matrices must be positive definite.
+ * - QRFactorisation and CODFactorisation are rank revealing, so they are more robust when the
+ *   problem is ill-conditioned. They are slower, and allocate memory every time they solve.
+ * - LapackLLTFactorisation calls the Cholesky decomposition of an external LAPACK library. It is
+ *   only available when QP_SOLVER_USE_LAPACK is defined, and the program is linked with LAPACK.
+ */
+template <class MatrixType> using LDLTFactorisation = LDLT<MatrixType,Lower>;
+template <class MatrixType> using LLTFactorisation  = LLT<MatrixType,Lower>;
+template <class MatrixType> using QRFactorisation   = ColPivHouseholderQR<MatrixType>;
+template <class MatrixType> using CODFactorisation  = CompleteOrthogonalDecomposition<MatrixType>;
+
+#ifdef QP_SOLVER_USE_LAPACK
+extern "C" void spotrf_(const char *uplo, const int *n, float  *a, const int *lda, int *info);      // LAPACK Cholesky decomposition
+extern "C" void dpotrf_(const char *uplo, const int *n, double *a, const int *lda, int *info);      // LAPACK Cholesky decomposition
+
+inline void lapack_potrf(const char *uplo, const int *n, float  *a, const int *lda, int *info) { spotrf_(uplo, n, a, lda, info); }
+inline void lapack_potrf(const char *uplo, const int *n, double *a, const int *lda, int *info) { dpotrf_(uplo, n, a, lda, info); }
+
+/**
+ * A Cholesky decomposition computed by LAPACK (e.g. OpenBLAS or MKL). The lower triangle is
+ * stored like Eigen's LLT, so solving uses the same triangular solves.
+ */
+template <class MatrixType>
+class LapackLLTFactorisation : public LLT<MatrixType,Lower>
+{
+	public:
+		LapackLLTFactorisation() {}
+		
+		explicit LapackLLTFactorisation(const MatrixType &A) { compute(A); }
+		
+		LapackLLTFactorisation &compute(const MatrixType &A)
+		{
+			this->m_matrix = A;
+			
+			int n = A.rows(), lda = this->m_matrix.outerStride(), info = 0;
+			
+			if(n > 0) lapack_potrf("L", &n, this->m_matrix.data(), &lda, &info);
+			
+			this->m_l1_norm       = 0;                                                  // Not computed, so rcond() is not available
+			this->m_isInitialized = true;
+			this->m_info          = (info == 0) ? Success : NumericalIssue;
+			
+			return *this;
+		}
+};
+#endif
+
+/**
+ * True if the factorisation solves in place without allocating memory.
+ */
+template <class Factorisation> struct solves_in_place                             : false_type {};
+template <class MatrixType, int UpLo> struct solves_in_place<LLT<MatrixType,UpLo>>  : true_type {};
+template <class MatrixType, int UpLo> struct solves_in_place<LDLT<MatrixType,UpLo>> : true_type {};
+#ifdef QP_SOLVER_USE_LAPACK
+template <class MatrixType> struct solves_in_place<LapackLLTFactorisation<MatrixType>> : true_type {};
+#endif
+
+/**
+ * Updates a factorisation of a matrix to that of the matrix plus sigma*U*U', where U has k columns.
+ * LLT and LDLT are updated one column at a time in O(n^2*k), the others are computed again.
+ * @param decomposition The factorisation of the matrix before the update.
+ * @param matrix The matrix after the update, in case it has to be factorised again.
+ * @param U The columns of the update.
+ * @param sigma 1 for an update, -1 for a downdate.
+ */
+template <class Decomposition, class MatrixType, class UpdateType, class Scalar> inline
+void rank_update(Decomposition &decomposition, const MatrixType &matrix, const UpdateType &U, const Scalar &sigma)
+{
+	decomposition.compute(matrix);
+}
+
+template <class MatrixType, int UpLo, class UpdateType, class Scalar> inline
+void rank_update(LLT<MatrixType,UpLo> &decomposition, const MatrixType &matrix, const UpdateType &U, const Scalar &sigma)
+{
+	for(int k = 0; k < U.cols(); k++) decomposition.rankUpdate(U.col(k), sigma);
+	
+	if(decomposition.info() != Success) decomposition.compute(matrix);                          // A downdate that was not positive definite
+}
+
+template <class MatrixType, int UpLo, class UpdateType, class Scalar> inline
+void rank_update(LDLT<MatrixType,UpLo> &decomposition, const MatrixType &matrix, const UpdateType &U, const Scalar &sigma)
+{
+	for(int k = 0; k < U.cols(); k++) decomposition.rankUpdate(U.col(k), sigma);
+}
+
+template <class DataType, int N, int C, int M, template <class> class Factorisation> class QPProblem; // Defined in QPProblem.h
+template <class DataType> class MPCSolver;                                                          // Defined in MPCSolver.h
+
+/**
+ * Solves convex quadratic programming problems. The problem size can be fixed at compile time so
+ * that Eigen uses stack memory and unrolled loops, which is much faster for small problems.
+ * @tparam DataType float or double.
+ * @tparam N Number of decision variables.
+ * @tparam C Number of inequality constraints.
+ * @tparam M Number of equality constraints (or outputs for least squares problems).
+ */
+template <class DataType = float, int N = Dynamic, int C = Dynamic, int M = Dynamic,
+          template <class> class Factorisation = LDLTFactorisation>
 class QPSolver
 {
 	public:
+		EIGEN_MAKE_ALIGNED_OPERATOR_NEW                                                     // Needed for fixed-size Eigen members
+		
 		/**
 		 * Constructor.
 		 */
 		QPSolver() {}
+		
+		/**
+		 * The outcome of solving a problem, or one problem in a batch. A problem is infeasible if
+		 * there is no x that strictly satisfies the inequality constraints. A call is timedOut if
+		 * it reached the deadline or time budget, and cancelled if cancel() was called.
+		 */
+		enum Status {solved, invalidArgument, failed, infeasible, timedOut, cancelled};
+		
+		/**
+		 * A problem min 0.5*x'*H*x + x'*f subject to B*x <= z for solve_batch(). The arguments are
+		 * the same as solve(H,f,B,z,x0), and must outlive the call.
+		 */
+		struct Problem
+		{
+			const Matrix<DataType,N,N> &H;
+			const Vector<DataType,N>   &f;
+			const Matrix<DataType,C,N> &B;
+			const Vector<DataType,C>   &z;
+			const Vector<DataType,N>   &x0;
+		};
+		
+		/**
+		 * A problem min 0.5*(xd - x)'*W*(xd - x) subject to A*x = y, B*x <= z for
+		 * constrained_least_squares_batch(). The arguments are the same as
+		 * constrained_least_squares(xd,W,A,y,B,z,x0), and must outlive the call.
+		 */
+		struct LeastSquaresProblem
+		{
+			const Vector<DataType,N>   &xd;
+			const Matrix<DataType,N,N> &W;
+			const Matrix<DataType,M,N> &A;
+			const Vector<DataType,M>   &y;
+			const Matrix<DataType,C,N> &B;
+			const Vector<DataType,C>   &z;
+			const Vector<DataType,N>   &x0;
+		};
+		
+		/**
+		 * The solution to one problem in a batch.
+		 */
+		struct Solution
+		{
+			EIGEN_MAKE_ALIGNED_OPERATOR_NEW                                             // Needed for fixed-size Eigen members
+			
+			Vector<DataType,N> x;                                                       ///< The solution, or the best point so far if timedOut or cancelled
+			Status status = failed;                                                     ///< As it says
+			unsigned int numSteps = 0;                                                  ///< Number of steps it took to solve
+		};
+		
+		typedef std::vector<Solution,aligned_allocator<Solution>> SolutionList;
+		
+		/**
+		 * Sets the options of one solver in a portfolio, e.g. [](QPSolver &solver){ solver.use_dual(); }.
+		 */
+		typedef std::function<void(QPSolver&)> Configuration;
+		
+		/**
+		 * The state of the algorithm on one iteration, for statistics() and the iteration callback.
+		 */
+		struct Iteration
+		{
+			unsigned int step = 0;                                                      ///< Starting from 1
+			DataType barrier = 0;                                                       ///< Barrier scalar, or the average complementarity for the primal-dual method. 0 for the active set method.
+			DataType stepNorm = 0;                                                      ///< Magnitude of the step taken
+			DataType minSlack = 0;                                                      ///< Smallest distance to the constraints before the step. Negative if one is violated.
+			DataType objective = 0;                                                     ///< Objective function before the step
+			unsigned int refinements = 0;                                               ///< Iterative refinement steps in mixed precision
+		};
+		
+		/**
+		 * Where the time went in the last call to a function with inequality constraints.
+		 */
+		struct Statistics
+		{
+			double assemblyTime = 0;                                                    ///< Seconds spent computing the gradient and Hessian
+			double factorisationTime = 0;                                               ///< Seconds spent decomposing the Hessian and solving for the step
+			double stepLengthTime = 0;                                                  ///< Seconds spent on the step length search
+			double totalTime = 0;                                                       ///< Seconds spent in the algorithm, including the above
+			unsigned int numFactorisations = 0;                                         ///< Number of times the Hessian was decomposed
+			unsigned int numRefinements = 0;                                            ///< Iterative refinement steps in mixed precision
+			unsigned int phaseOneSteps = 0;                                             ///< Newton steps taken to find a start point inside the constraints
+			std::vector<Iteration> iterations;                                          ///< As it says
+		};
 			
 		/**
 		 * Minimize 0.5*x'*H*x + x'*f, where x is the decision variable.
@@ -35,9 +230,9 @@ class QPSolver
 		 * @param f A vector.
 		 * @return The optimal solution for x.
 		 */
-		static Vector<DataType,Dynamic>
-		solve(const Matrix<DataType, Dynamic, Dynamic>  &H,
-                      const Vector<DataType, Dynamic>           &f);
+		static Vector<DataType,N>
+		solve(const Matrix<DataType,N,N> &H,
+		      const Vector<DataType,N>   &f);
 	
 		             
 		/**
@@ -47,10 +242,10 @@ class QPSolver
 		 * @param W A positive-definite weighting on the y values.
 		 * @return The vector x which returns the minimum norm || y - A*x ||
 		 */             
-		static Vector<DataType,Dynamic>
-		least_squares(const Vector<DataType,Dynamic>           &y,
-			      const Matrix<DataType, Dynamic, Dynamic> &A,
-			      const Matrix<DataType, Dynamic, Dynamic> &W);
+		static Vector<DataType,N>
+		least_squares(const Vector<DataType,M>   &y,
+			      const Matrix<DataType,M,N> &A,
+			      const Matrix<DataType,M,M> &W);
 
 		/**
 		 * Solve a least squares problem where the decision variable has more elements than the output.
@@ -63,11 +258,11 @@ class QPSolver
 		 * @param y Equality constraint vector
 		 * @return The optimal solution for x.
 		 */
-		static Vector<DataType,Dynamic>
-		redundant_least_squares(const Vector<DataType, Dynamic>          &xd,
-		                        const Matrix<DataType, Dynamic, Dynamic> &W,
-		                        const Matrix<DataType, Dynamic, Dynamic> &A,
-		                        const Vector<DataType, Dynamic>          &y);
+		static Vector<DataType,N>
+		redundant_least_squares(const Vector<DataType,N>   &xd,
+		                        const Matrix<DataType,N,N> &W,
+		                        const Matrix<DataType,M,N> &A,
+		                        const Vector<DataType,M>   &y);
 		                                                         
 		/**
 		 * Solve linear least squares with upper and lower bounds on the solution.
@@ -82,13 +277,13 @@ class QPSolver
 		 * @param x0 A start point for the algorithm.
 		 * @return The optimal solution within the constraints.
 		 */
-		Vector<DataType,Dynamic>
-		constrained_least_squares(const Vector<DataType, Dynamic>          &y,
-		                          const Matrix<DataType, Dynamic, Dynamic> &A,
-		                          const Matrix<DataType, Dynamic, Dynamic> &W,
-		                          const Vector<DataType, Dynamic>          &xMin,
-		                          const Vector<DataType, Dynamic>          &xMax,
-		                          const Vector<DataType, Dynamic>          &x0);
+		Vector<DataType,N>
+		constrained_least_squares(const Vector<DataType,M>   &y,
+		                          const Matrix<DataType,M,N> &A,
+		                          const Matrix<DataType,M,M> &W,
+		                          const Vector<DataType,N>   &xMin,
+		                          const Vector<DataType,N>   &xMax,
+		                          const Vector<DataType,N>   &x0);
 		             
 		/**
 		 * Solve a redundant least squares problem with upper and lower bounds on the solution.
@@ -105,14 +300,14 @@ class QPSolver
 		 * @param xMax upper bound on the solution.
 		 * @param x0 Starting point for the algorithm.
 		 */                  
-		Vector<DataType,Dynamic>
-		constrained_least_squares(const Vector<DataType, Dynamic>          &xd,
-		                          const Matrix<DataType, Dynamic, Dynamic> &W,
-		                          const Matrix<DataType, Dynamic, Dynamic> &A,
-		                          const Vector<DataType, Dynamic>          &y,
-		                          const Vector<DataType, Dynamic>          &xMin,
-		                          const Vector<DataType, Dynamic>          &xMax,
-		                          const Vector<DataType, Dynamic>          &x0);
+		Vector<DataType,N>
+		constrained_least_squares(const Vector<DataType,N>   &xd,
+		                          const Matrix<DataType,N,N> &W,
+		                          const Matrix<DataType,M,N> &A,
+		                          const Vector<DataType,M>   &y,
+		                          const Vector<DataType,N>   &xMin,
+		                          const Vector<DataType,N>   &xMax,
+		                          const Vector<DataType,N>   &x0);
 		
 		/**
 		 * Solve a redundant least squares problem with inequality constraints on the solution.
@@ -129,14 +324,14 @@ class QPSolver
 		 * @param z Inequality constraint vector.
 		 * @param x0 Starting point for the algorithm.
 		 */  
-		Vector<DataType,Dynamic>
-		constrained_least_squares(const Vector<DataType, Dynamic>          &xd,
-		                          const Matrix<DataType, Dynamic, Dynamic> &W,
-		                          const Matrix<DataType, Dynamic, Dynamic> &A,
-		                          const Vector<DataType, Dynamic>          &y,
-		                          const Matrix<DataType, Dynamic, Dynamic> &B,
-		                          const Vector<DataType, Dynamic>          &z,
-		                          const Vector<DataType, Dynamic>          &x0);
+		Vector<DataType,N>
+		constrained_least_squares(const Vector<DataType,N>   &xd,
+		                          const Matrix<DataType,N,N> &W,
+		                          const Matrix<DataType,M,N> &A,
+		                          const Vector<DataType,M>   &y,
+		                          const Matrix<DataType,C,N> &B,
+		                          const Vector<DataType,C>   &z,
+		                          const Vector<DataType,N>   &x0);
 		
 		/**
 		 * Solve a generic quadratic programming problem with inequality constraints.
@@ -151,12 +346,88 @@ class QPSolver
 		 * @param x0 Start point for the algorithm.
 		 * @return x: A solution that minimizes the problem whilst obeying inequality constraints.
 		 */
-		Vector<DataType,Dynamic>  
-		solve(const Matrix<DataType, Dynamic, Dynamic> &H,
-		      const Vector<DataType, Dynamic>          &f,
-		      const Matrix<DataType, Dynamic, Dynamic> &B,
-		      const Vector<DataType, Dynamic>          &z,
-		      const Vector<DataType, Dynamic>          &x0);
+		Vector<DataType,N>
+		solve(const Matrix<DataType,N,N> &H,
+		      const Vector<DataType,N>   &f,
+		      const Matrix<DataType,C,N> &B,
+		      const Vector<DataType,C>   &z,
+		      const Vector<DataType,N>   &x0);
+		
+		/**
+		 * Solve a generic quadratic programming problem with equality and inequality constraints.
+		 * The problem is of the form:
+		 * min 0.5*x'*H*x + x'*f
+		 * subject to: A*x = y, B*x < z
+		 * The equality constraints are handled in the Newton step, rather than as two inequalities
+		 * each. By default it solves for [lambda; x] with the KKT matrix [0 -A; -A' H]. With
+		 * use_null_space() it solves for v in x = xp + Z*v, where A*xp = y and A*Z = 0. The active
+		 * set method starts with them in the active set.
+		 * In the KKT form x0 is first moved toward A*x = y as far as the inequalities allow. A step
+		 * cut short by an inequality only reduces y - A*x by (1 - alpha), so the fixed barrier can
+		 * stop before the equalities hold; use_adaptive_barrier() or use_null_space() avoid this.
+		 * @param H A symmetric matrix that is positive definite on the null space of A.
+		 * @param f A vector for the linear component of the problem.
+		 * @param A Equality constraint matrix, with full row rank.
+		 * @param y Equality constraint vector.
+		 * @param B Inequality constraint matrix.
+		 * @param z Inequality constraint vector.
+		 * @param x0 Start point for the algorithm.
+		 * @return x: A solution that minimizes the problem whilst obeying both sets of constraints.
+		 */
+		Vector<DataType,N>
+		solve(const Matrix<DataType,N,N> &H,
+		      const Vector<DataType,N>   &f,
+		      const Matrix<DataType,M,N> &A,
+		      const Vector<DataType,M>   &y,
+		      const Matrix<DataType,C,N> &B,
+		      const Vector<DataType,C>   &z,
+		      const Vector<DataType,N>   &x0);
+		
+		/**
+		 * Solve a generic quadratic programming problem with sparse matrices. The Newton step uses
+		 * a sparse LDLT decomposition whose symbolic analysis is only recomputed when the sparsity
+		 * pattern of H + B'*B changes, so it is reused every step and across calls.
+		 * The problem is of the form:
+		 * min 0.5*x'*H*x + x'*f
+		 * subject to: B*x < z
+		 * @param H A sparse, positive semi-definite matrix such that H = H'.
+		 * @param f A vector for the linear component of the problem.
+		 * @param B Sparse inequality constraint matrix.
+		 * @param z Inequality constraint vector.
+		 * @param x0 Start point for the algorithm.
+		 * @return x: A solution that minimizes the problem whilst obeying inequality constraints.
+		 */
+		Vector<DataType,N>
+		solve(const SparseMatrix<DataType>   &H,
+		      const Vector<DataType,Dynamic> &f,
+		      const SparseMatrix<DataType>   &B,
+		      const Vector<DataType,Dynamic> &z,
+		      const Vector<DataType,Dynamic> &x0);
+		
+		/**
+		 * Solve a redundant least squares problem with sparse matrices and inequality constraints.
+		 * It always uses the primal method, with the sparse matrix [0 -A; -A' W]. The rows for
+		 * the Lagrange multipliers are eliminated last, so it is best suited to m << n.
+		 * The problem is of the form:
+		 * min 0.5*(xd - x)'*W*(xd - x)
+		 * subject to: A*x = y
+		 *             B*x < z
+		 * @param xd Desired value for the solution.
+		 * @param W Sparse, positive definite weighting on the desired value / solution.
+		 * @param A Sparse equality constraint matrix.
+		 * @param y Equality constraint vector.
+		 * @param B Sparse inequality constraint matrix.
+		 * @param z Inequality constraint vector.
+		 * @param x0 Starting point for the algorithm.
+		 */
+		Vector<DataType,N>
+		constrained_least_squares(const Vector<DataType,Dynamic> &xd,
+		                          const SparseMatrix<DataType>   &W,
+		                          const SparseMatrix<DataType>   &A,
+		                          const Vector<DataType,Dynamic> &y,
+		                          const SparseMatrix<DataType>   &B,
+		                          const Vector<DataType,Dynamic> &z,
+		                          const Vector<DataType,Dynamic> &x0);
 		
 		/**
 		 * Set the tolerance for the step size in the interior point aglorithm.
@@ -189,6 +460,28 @@ class QPSolver
 		 */
 		bool set_barrier_reduction_rate(const DataType &rate);
 		
+		/**
+		 * The barrier method will reduce the barrier scalar according to its progress instead of at
+		 * a fixed rate: quickly after a full Newton step close to the central path, slowly after a
+		 * short one. It stops when the duality gap c*u and the KKT residual H*x + f + B'*lambda,
+		 * with lambda = u./d, are both within set_kkt_tolerance(), instead of on the step size.
+		 */
+		void use_adaptive_barrier();
+		
+		/**
+		 * The barrier method will multiply the barrier scalar by the reduction rate every step, and
+		 * stop when the step size is below the tolerance (the default).
+		 */
+		void use_fixed_barrier();
+		
+		/**
+		 * Set the tolerance on the duality gap and residuals of the optimality conditions for the
+		 * primal-dual interior point algorithm, and for the barrier method with use_adaptive_barrier().
+		 * @param tolerance A small positive number.
+		 * @return Returns false if the argument is invalid.
+		 */
+		bool set_kkt_tolerance(const DataType &tolerance);
+		
 		/**
 		 * @return Returns the step size alpha*||dx|| for the final iteration in the interior point algorithm.
 		 */
@@ -202,13 +495,48 @@ class QPSolver
 		/**
 		 * @return Returns the last solution from when the interior point algorithm was previously called.
 		 */
-		Vector<DataType, Dynamic> last_solution() const { return this->lastSolution; }
+		Matrix<DataType,Dynamic,1,ColMajor,N,1> last_solution() const { return this->lastSolution; }
 		
 		/**
 		 * Clears the last solution such that last_solution().size() == 0.
 		 */
 		void clear_last_solution() { this->lastSolution.resize(0); }
 		
+		/**
+		 * @return Returns infeasible if the last call with inequality constraints found that they
+		 * cannot be satisfied. The solution it returned then minimises the largest violation of the
+		 * constraints instead. Otherwise it returns solved.
+		 */
+		Status status() const { return this->lastStatus; }
+		
+		/**
+		 * If status() == infeasible, multipliers lambda >= 0 on the inequality constraints B*x <= z
+		 * with sum(lambda) = 1, B'*lambda = 0 and z'*lambda <= 0, which prove there is no x with
+		 * B*x < z. For upper and lower bounds, B = [I; -I] and z = [xMax; -xMin]. It is only valid
+		 * when status() == infeasible, and is empty if the active set method found the problem
+		 * infeasible with equality constraints.
+		 */
+		const Vector<DataType,Dynamic> &infeasibility_certificate() const { return this->certificate; }
+		
+		/**
+		 * Record the phase timings and iterations of every call with inequality constraints.
+		 * This is off by default, and costs nothing when it is off.
+		 * @param record True to turn it on, false to turn it off.
+		 */
+		void record_statistics(const bool &record) { this->recordStatistics = record; }
+		
+		/**
+		 * @return The statistics from the last call with inequality constraints that recorded them.
+		 */
+		const Statistics &statistics() const { return this->stats; }
+		
+		/**
+		 * Call a function on every iteration of the algorithm for inequality constraints, e.g. for
+		 * logging. It is called on the thread running the solver. Give an empty function to remove it.
+		 * @param callback Takes the state of the algorithm on that iteration.
+		 */
+		void set_iteration_callback(const std::function<void(const Iteration&)> &callback) { this->iterationCallback = callback; }
+		
 		/**
 		 * The interior point algorithm will use the dual method to solve a redundant QP problem.
 		 */
@@ -219,581 +547,4862 @@ class QPSolver
 		 */
 		void use_primal();
 		
+		/**
+		 * The interior point algorithm will solve a redundant QP problem in the null space of the
+		 * equality constraints. They are eliminated once per call, so each step only decomposes an
+		 * (n-m)x(n-m) positive definite matrix instead of the (m+n)x(m+n) indefinite one of the
+		 * primal method. W must be positive definite, and A must have full row rank.
+		 */
+		void use_null_space();
+		
+		/**
+		 * Inequality constraints will be solved with the log barrier interior point algorithm (the default).
+		 */
+		void use_barrier_method();
+		
+		/**
+		 * Inequality constraints will be solved with a primal-dual interior point algorithm using
+		 * Mehrotra's predictor-corrector method. It terminates when the duality gap and residuals
+		 * are below the KKT tolerance, and the start point need not satisfy the constraints.
+		 */
+		void use_primal_dual_method();
+		
+		/**
+		 * Inequality constraints will be solved with the dual active set method of Goldfarb & Idnani.
+		 * The factorisation is updated as constraints are added or removed, rather than recomputed.
+		 * The Hessian (or weighting matrix) must be positive definite. The start point x0 is not used.
+		 */
+		void use_active_set_method();
+		
+		/**
+		 * @return The indices of the inequality constraints that were active in the last solution
+		 * from the active set method. For upper and lower bounds, i < n is the upper bound on x(i),
+		 * and n + i is the lower bound.
+		 */
+		std::vector<unsigned int> active_set() const { return this->activeSet; }
+		
+		/**
+		 * Set the inequality constraints that the active set method will start from on the next call.
+		 * With use_warm_start() the active set from the previous call is used automatically.
+		 * Constraints that turn out not to be active are removed.
+		 * @param indices As it says.
+		 * @return Returns false if the argument is invalid.
+		 */
+		bool set_active_set(const std::vector<unsigned int> &indices);
+		
+		/**
+		 * The interior point algorithm will resume from the barrier scalar, constraint slacks and
+		 * dual estimates of the previous solution to the same type and size of problem. The start
+		 * point x0 is only used if the previous solution does not satisfy the new constraints.
+		 * The active set method starts from the previous active set.
+		 */
+		void use_warm_start();
+		
+		/**
+		 * The interior point algorithm will start from x0 and the initial barrier scalar every time.
+		 */
+		void use_cold_start();
+		
+		/**
+		 * @return The number of fewer steps the last call took than the last cold start of the same problem.
+		 */
+		unsigned int warm_start_steps_saved() const { return this->stepsSaved; }
+		
+		/**
+		 * Solve many independent problems of the form min 0.5*x'*H*x + x'*f subject to B*x <= z
+		 * in parallel. The problems are shared between a pool of threads, each with its own
+		 * workspace, using the same options as this object. Each problem is solved from a cold start.
+		 * @param problems The problems to solve.
+		 * @return The solution and status of each problem, in the same order.
+		 */
+		SolutionList solve_batch(const std::vector<Problem> &problems);
+		
+		/**
+		 * Solve many small problems with the same dimensions, min 0.5*x'*H*x + x'*f subject to
+		 * B*x <= z, with the barrier method. Groups of Lanes problems are stepped together, with the
+		 * data interleaved so that every operation vectorizes across the problems in a group.
+		 * Problems that converge early are masked out. The groups are shared between the thread pool
+		 * as in solve_batch().
+		 * @param problems The problems to solve. They must all have the same dimensions.
+		 * @return The solution and status of each problem, in the same order.
+		 */
+		template <int Lanes = 8>
+		SolutionList solve_lockstep(const std::vector<Problem> &problems);
+		
+		/**
+		 * Solve many independent problems of the form min 0.5*(xd - x)'*W*(xd - x) subject to
+		 * A*x = y, B*x <= z in parallel. See solve_batch().
+		 * @param problems The problems to solve.
+		 * @return The solution and status of each problem, in the same order.
+		 */
+		SolutionList constrained_least_squares_batch(const std::vector<LeastSquaresProblem> &problems);
+		
+		/**
+		 * Set the number of threads used by the batch functions and the parallel assembly. The
+		 * default is the number of hardware threads. The calling thread is one of them.
+		 * @param number As it says.
+		 * @return Returns false if the argument is invalid.
+		 */
+		bool set_num_threads(const unsigned int &number);
+		
+		/**
+		 * The rows of the inequality constraints B*x <= z will be shared between the threads of the
+		 * thread pool when computing the distances, the gradient and Hessian of the barrier, and the
+		 * step length. It is only worthwhile for thousands of constraints. The rows are split in to
+		 * blocks of a fixed size, and the sums from each block are added in the same order, so the
+		 * solution does not depend on the number of threads.
+		 */
+		void use_parallel_assembly();
+		
+		/**
+		 * The gradient and Hessian of the barrier will be assembled on the calling thread (the default).
+		 */
+		void use_serial_assembly();
+		
+		/**
+		 * The Hessian of the barrier will be factorised in single precision, which is up to twice as
+		 * fast, and every Newton step is corrected with iterative refinement: the residual is computed
+		 * in DataType and the correction solved with the single precision factors. This is meant for
+		 * QPSolver<double> on large problems, where it gives close to double accuracy at close to the
+		 * cost of float. The refinement steps are counted in statistics(). Dense matrices only.
+		 * @param maxRefinements The most refinement steps per Newton step.
+		 * @return Returns false if the argument is invalid.
+		 */
+		bool use_mixed_precision(const unsigned int &maxRefinements = 3);
+		
+		/**
+		 * The Hessian of the barrier will be factorised in DataType (the default).
+		 */
+		void use_full_precision();
+		
+		/**
+		 * The Newton steps of the interior point algorithms will be solved in the space of the
+		 * constraints: H is factorised once per solve, and every step factorises a c x c matrix
+		 * instead of the n x n barrier Hessian. This is much faster when there are far fewer
+		 * constraints than variables. Dense problems only; a sparse, indefinite or badly conditioned
+		 * H uses the full space.
+		 */
+		void use_constraint_space();
+		
+		/**
+		 * The Newton steps will always factorise the n x n barrier Hessian.
+		 */
+		void use_full_space();
+		
+		/**
+		 * The constraint space is used when there are at most half as many constraints as
+		 * variables, and mixed precision is off (the default).
+		 */
+		void use_automatic_space();
+		
+		/**
+		 * Set the configurations raced by the portfolio functions. Each one has its own solver,
+		 * which starts with the options of this object at the time of the call, then the
+		 * configuration is applied to it. Each configuration runs on a thread of the pool, so
+		 * set_num_threads() should be at least the number of configurations for them to race.
+		 * @param configurations As it says.
+		 * @return Returns false if the argument is invalid.
+		 */
+		bool set_portfolio(const std::vector<Configuration> &configurations);
+		
+		/**
+		 * Solve min 0.5*x'*H*x + x'*f subject to B*x <= z with every configuration of the
+		 * portfolio at once, and return the first solution whose duality gap and KKT residual are
+		 * within set_kkt_tolerance() (or that the active set method finished), or that proves the
+		 * problem infeasible. The fixed barrier method stops on the step size, so it only wins if
+		 * its last full Newton step also met the tolerance. The other configurations are told to
+		 * stop, and return within one step. If none of them meet the tolerance, the solution with
+		 * the smallest objective is returned. See portfolio_winner().
+		 */
+		Vector<DataType,N>
+		solve_portfolio(const Matrix<DataType,N,N> &H,
+		                const Vector<DataType,N>   &f,
+		                const Matrix<DataType,C,N> &B,
+		                const Vector<DataType,C>   &z,
+		                const Vector<DataType,N>   &x0);
+		
+		/**
+		 * Solve constrained_least_squares(xd,W,A,y,xMin,xMax,x0) with every configuration of the
+		 * portfolio at once. See solve_portfolio(). The dual method scales the unconstrained
+		 * solution back inside the constraints rather than optimising, so it only wins if none of
+		 * the others meet the tolerance.
+		 */
+		Vector<DataType,N>
+		constrained_least_squares_portfolio(const Vector<DataType,N>   &xd,
+		                                    const Matrix<DataType,N,N> &W,
+		                                    const Matrix<DataType,M,N> &A,
+		                                    const Vector<DataType,M>   &y,
+		                                    const Vector<DataType,N>   &xMin,
+		                                    const Vector<DataType,N>   &xMax,
+		                                    const Vector<DataType,N>   &x0);
+		
+		/**
+		 * Solve constrained_least_squares(xd,W,A,y,B,z,x0) with every configuration of the
+		 * portfolio at once. See solve_portfolio().
+		 */
+		Vector<DataType,N>
+		constrained_least_squares_portfolio(const Vector<DataType,N>   &xd,
+		                                    const Matrix<DataType,N,N> &W,
+		                                    const Matrix<DataType,M,N> &A,
+		                                    const Vector<DataType,M>   &y,
+		                                    const Matrix<DataType,C,N> &B,
+		                                    const Vector<DataType,C>   &z,
+		                                    const Vector<DataType,N>   &x0);
+		
+		/**
+		 * @return The index of the configuration whose solution the last portfolio call returned.
+		 */
+		unsigned int portfolio_winner() const { return this->portfolioWinner; }
+		
+		/**
+		 * @return The number of times each configuration has won since set_portfolio(), for tuning the defaults.
+		 */
+		const std::vector<unsigned int> &portfolio_wins() const { return this->portfolioWins; }
+		
+		/**
+		 * Limit the time of every call with inequality constraints. When it runs out the algorithm
+		 * stops, status() is timedOut, and the interior point algorithms return the best strictly
+		 * feasible iterate so far: the last one for the barrier method, and the one with the
+		 * smallest objective for the primal-dual method. If the time runs out before phase I finds
+		 * a point inside the constraints, or with the active set method, the last iterate does not
+		 * satisfy the constraints. The clock is checked once per step.
+		 * @param seconds The time for each call, or 0 for no limit (the default).
+		 * @return Returns false if the argument is invalid.
+		 */
+		bool set_time_budget(const double &seconds);
+		
+		/**
+		 * Stop every call with inequality constraints at the given time, as with set_time_budget().
+		 * If both are set, the call stops at whichever comes first.
+		 * @param deadline As it says.
+		 */
+		void set_deadline(const std::chrono::steady_clock::time_point &deadline) { this->deadline = deadline; }
+		
+		/**
+		 * Remove the deadline given by set_deadline().
+		 */
+		void clear_deadline() { this->deadline = std::chrono::steady_clock::time_point::max(); }
+		
+		/**
+		 * Solve(H,f,B,z,x0) on another thread. The arguments are copied, so they need not outlive
+		 * the call. Do not call any other function of this object, except cancel(), until the
+		 * future is ready.
+		 * @return The solution, status and number of steps, once it is ready.
+		 */
+		std::future<Solution>
+		solve_async(const Matrix<DataType,N,N> &H,
+		            const Vector<DataType,N>   &f,
+		            const Matrix<DataType,C,N> &B,
+		            const Vector<DataType,C>   &z,
+		            const Vector<DataType,N>   &x0);
+		
+		/**
+		 * Constrained_least_squares(xd,W,A,y,B,z,x0) on another thread. See solve_async().
+		 * @return The solution, status and number of steps, once it is ready.
+		 */
+		std::future<Solution>
+		constrained_least_squares_async(const Vector<DataType,N>   &xd,
+		                                const Matrix<DataType,N,N> &W,
+		                                const Matrix<DataType,M,N> &A,
+		                                const Vector<DataType,M>   &y,
+		                                const Matrix<DataType,C,N> &B,
+		                                const Vector<DataType,C>   &z,
+		                                const Vector<DataType,N>   &x0);
+		
+		/**
+		 * Ask the call started by the last solve_async() or constrained_least_squares_async() to
+		 * stop on its next step. Its status is cancelled, and the solution is as for a time budget.
+		 * It is safe to call from any thread.
+		 */
+		void cancel() { this->cancelRequested = true; }
+	
 	private:
 		
+		friend class QPProblem<DataType,N,C,M,Factorisation>;                                     // Reuses the workspaces between calls
+		friend class MPCSolver<DataType>;                                                   // Uses the same step length rule
+		
+		static constexpr int twoN   = (N == Dynamic) ? Dynamic : 2*N;                       ///< Number of constraints for upper and lower bounds on x
+		static constexpr int MplusN = (M == Dynamic or N == Dynamic) ? Dynamic : M + N;     ///< Size of [lambda; x] for the primal method
+		static constexpr int Nplus1 = (N == Dynamic) ? Dynamic : N + 1;                     ///< Active constraints, plus the one being added
+		
 		DataType tol = 1e-02;                                                               ///< Minimum value for the step size before terminating the interior point algorithm.
 		DataType stepSize;                                                                  ///< Step size on the final iteration of the interior point algorithm.
 		DataType barrierReductionRate = 1e-03;                                              ///< Constraint barrier scalar is multiplied by this value every step in the interior point algorithm.
 		DataType initialBarrierScalar = 100;                                                ///< Starting value for the constraint barrier scalar in the interior point algorithm.
 		
-		enum Method {dual, primal} method = primal;                                         ///< Used to select which method to solve for with redundant least squares problems.                                               
+		DataType kktTol = 1e-05;                                                            ///< Tolerance on the optimality conditions for the primal-dual algorithm and adaptive barrier.
+		
+		enum Algorithm {barrier, primalDual, activeSetMethod} algorithm = barrier;          ///< Used to select the interior point algorithm.
+		
+		enum Method {dual, primal, nullSpace} method = primal;                              ///< Used to select which method to solve for with redundant least squares problems.                                               
 		
 		unsigned int maxSteps = 20;                                                         ///< Maximum number of iterations to run interior point method before terminating.
 		
+		bool adaptiveBarrier = false;                                                       ///< Reduce the barrier according to progress, and stop on the duality gap and KKT residual
+		
+		enum NewtonSpace {automaticSpace, fullSpace, constraintSpace} newtonSpace = automaticSpace; ///< Space the Newton step of the interior point algorithms is solved in
+		
+		static constexpr unsigned int constraintSpaceRatio = 2;                             ///< Automatically use the constraint space when n >= ratio*c
+		
 		unsigned int numSteps = 0;                                                          ///< Records the number of steps it took to solve a problem with the interior point algorithm.
 		
-		Vector<DataType,Dynamic> lastSolution;                                              ///< Final solution returned by interior point algorithm. Can be used as a starting point for future calls to the method.
+		bool warmStart = false;                                                             ///< Resume from the previous solution if true.
+		
+		unsigned int stepsSaved = 0;                                                        ///< Number of steps saved by the last warm start.
+		
+		std::vector<unsigned int> activeSet;                                                ///< Active inequality constraints from the active set method.
+		
+		bool activeSetGiven = false;                                                        ///< True if the user set the active set for the next call.
+		
+		bool recordStatistics = false;                                                      ///< Turned on with record_statistics()
+		
+		bool instrumented = false;                                                          ///< True while an algorithm is recording statistics or calling back
+		
+		Statistics stats;                                                                   ///< From the last call
+		
+		Status lastStatus = solved;                                                         ///< Outcome of the last call with inequality constraints
+		
+		Vector<DataType,Dynamic> certificate;                                               ///< Proof of infeasibility from the last call, if any
+		
+		std::function<void(const Iteration&)> iterationCallback;                            ///< Called on every iteration, if given
+		
+		bool converged = false;                                                             ///< True if the last solution from an algorithm is optimal to within the KKT tolerance (exactly for the active set method)
+		
+		const std::atomic<bool> *cancelFlag = nullptr;                                      ///< Set by another thread to stop the algorithm, if given
+		
+		std::atomic<bool> cancelRequested{false};                                           ///< Set by cancel()
+		
+		double timeBudget = 0;                                                              ///< Seconds for each call, 0 for no limit
+		
+		std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max(); ///< Set with set_deadline()
+		
+		std::chrono::steady_clock::time_point callDeadline;                                 ///< When the call in progress must stop
+		
+		bool timed = false;                                                                 ///< True if the call in progress has a deadline
 		
 		/**
-		 * The std::min function doesn't like floats, so I had to write my own ಠ_ಠ
-		 * @return Returns the minimum between to values 'a' and 'b'.
+		 * Starts the clock for the time budget at the start of an algorithm.
 		 */
-		DataType min(const DataType &a, const DataType &b)
+		void start_clock()
 		{
-			DataType minimum = (a < b) ? a : b;
-			return minimum;
-		}
-		
-};                                                                                                  // Required after class declaration
+			this->callDeadline = this->deadline;
+			
+			if(this->timeBudget > 0)
+			{
+				auto budget = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(this->timeBudget));
+				
+				this->callDeadline = std::min(this->callDeadline, std::chrono::steady_clock::now() + budget);
+			}
+			
+			this->timed = this->callDeadline != std::chrono::steady_clock::time_point::max();
+		}
+		
+		/**
+		 * @return True if the algorithm must stop because another thread asked it to, or it ran out
+		 * of time. The status says which, and stays set for the rest of the call.
+		 */
+		bool interrupted()
+		{
+			if(this->lastStatus == timedOut or this->lastStatus == cancelled) return true;
+			
+			if(this->cancelFlag != nullptr and this->cancelFlag->load(std::memory_order_relaxed))
+			{
+				this->lastStatus = cancelled;
+				return true;
+			}
+			
+			if(this->timed and std::chrono::steady_clock::now() >= this->callDeadline)
+			{
+				this->lastStatus = timedOut;
+				return true;
+			}
+			
+			return false;
+		}
+		
+		std::chrono::steady_clock::time_point startTime, phaseTime;                         ///< For the statistics
+		
+		/**
+		 * Clears the statistics at the start of an algorithm, if they are being recorded.
+		 * @param maxIterations Memory is reserved for this many iterations.
+		 */
+		void start_statistics(const unsigned int &maxIterations)
+		{
+			this->instrumented = this->recordStatistics or bool(this->iterationCallback);
+			
+			if(this->instrumented)
+			{
+				MallocGuard guard(true);                                            // Statistics are allowed to allocate
+				
+				this->stats.assemblyTime      = 0;
+				this->stats.factorisationTime = 0;
+				this->stats.stepLengthTime    = 0;
+				this->stats.totalTime         = 0;
+				this->stats.numFactorisations = 0;
+				this->stats.numRefinements    = 0;
+				this->stats.phaseOneSteps     = 0;
+				this->stats.iterations.clear();
+				this->stats.iterations.reserve(maxIterations);
+				
+				this->startTime = this->phaseTime = std::chrono::steady_clock::now();
+			}
+		}
+		
+		/**
+		 * Marks the start of a phase.
+		 */
+		void mark()
+		{
+			if(this->instrumented) this->phaseTime = std::chrono::steady_clock::now();
+		}
+		
+		/**
+		 * Adds the time since the last mark to the given phase, and starts the next one.
+		 */
+		void lap(double &phase)
+		{
+			if(this->instrumented)
+			{
+				auto now = std::chrono::steady_clock::now();
+				phase += std::chrono::duration<double>(now - this->phaseTime).count();
+				this->phaseTime = now;
+			}
+		}
+		
+		/**
+		 * Records an iteration and passes it to the callback.
+		 */
+		template <class Hessian, int Dim>
+		void record_iteration(const Hessian &H, const Vector<DataType,Dim> &f, const Vector<DataType,Dim> &x,
+		                      const DataType &barrier, const DataType &stepNorm, const DataType &minSlack,
+		                      const unsigned int &refinements = 0)
+		{
+			MallocGuard guard(true);                                                    // Statistics are allowed to allocate
+			
+			Iteration iteration;
+			iteration.step      = this->numSteps;
+			iteration.barrier   = barrier;
+			iteration.stepNorm  = stepNorm;
+			iteration.minSlack  = minSlack;
+			iteration.objective = 0.5*x.dot(H*x) + f.dot(x);
+			iteration.refinements = refinements;
+			
+			if(this->recordStatistics)  this->stats.iterations.push_back(iteration);
+			if(this->iterationCallback) this->iterationCallback(iteration);
+		}
+		
+		/**
+		 * Records the total time at the end of an algorithm.
+		 */
+		void finish_statistics()
+		{
+			if(this->instrumented)
+			{
+				this->stats.totalTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - this->startTime).count();
+				this->instrumented = false;
+			}
+		}
+		
+		Matrix<DataType,Dynamic,1,ColMajor,N,1> lastSolution;                               ///< Final solution returned by interior point algorithm. Can be used as a starting point for future calls to the method.
+		
+		/**
+		 * The std::min function doesn't like floats, so I had to write my own ಠ_ಠ
+		 * @return Returns the minimum between to values 'a' and 'b'.
+		 */
+		DataType min(const DataType &a, const DataType &b)
+		{
+			DataType minimum = (a < b) ? a : b;
+			return minimum;
+		}
+		
+		/**
+		 * Memory for the active set method.
+		 * @tparam Cons The number of inequality constraints.
+		 */
+		template <int Cons>
+		struct ActiveSetWorkspace
+		{
+			Matrix<DataType,N,N>                       J;                               ///< L^-T*Q, where H = L*L' and Q*[R; 0] are the active constraint normals
+			Matrix<DataType,N,N>                       R;                               ///< Upper triangular
+			LLT<Matrix<DataType,N,N>>                  Hdecomp;                         ///< Cholesky decomposition of the Hessian
+			Vector<DataType,N>                         f;                               ///< Linear component of the problem
+			Vector<DataType,N>                         x;                               ///< Solution
+			Vector<DataType,N>                         xOld;                            ///< Restored if a constraint can't be added
+			Vector<DataType,N>                         np;                              ///< Normal of the constraint being added
+			Vector<DataType,N>                         d;                               ///< J'*np
+			Vector<DataType,N>                         z;                               ///< Step direction for x
+			Vector<DataType,N>                         r;                               ///< Step direction for the multipliers
+			Vector<DataType,Nplus1>                    u;                               ///< Lagrange multipliers of the active constraints
+			Vector<DataType,Nplus1>                    uOld;                            ///< Restored if a constraint can't be added
+			Matrix<int,Nplus1,1>                       active;                          ///< Active constraints. Equality i is stored as -i-1
+			Matrix<int,Nplus1,1>                       activeOld;                       ///< Restored if a constraint can't be added
+			Vector<DataType,Cons>                      s;                               ///< Distance to every inequality constraint
+			Matrix<int,Cons,1>                         inactive;                        ///< inactive(i) = i if constraint i is not active, else -1
+			Matrix<int,Cons,1>                         excluded;                        ///< Constraints that are linearly dependent on the active set
+		};
+		
+		/**
+		 * A fill-reducing ordering for the sparse LDLT decomposition that puts rows with a zero on
+		 * the diagonal last. The decomposition does not pivot, so the zero block of the redundant
+		 * problem [0 -A; -A' W] can only be factorised after the positive definite block.
+		 */
+		struct SaddlePointOrdering
+		{
+			template <class MatrixType, class Permutation>
+			void operator()(const MatrixType &A, Permutation &perm)
+			{
+				AMDOrdering<typename MatrixType::StorageIndex> amd;
+				amd(A, perm);                                                       // perm.indices()(k) is the k-th row to be eliminated
+				
+				stable_partition(perm.indices().data(),
+				                 perm.indices().data() + perm.indices().size(),
+				                 [&A](const typename MatrixType::StorageIndex &i) { return A.coeff(i,i) != 0; });
+			}
+		};
+		
+		/**
+		 * Factorises the Hessian of the barrier function. Dense matrices use the Factorisation
+		 * template parameter, and only the lower triangle is filled in. If it fails, e.g. LLT for
+		 * the indefinite matrix [0 -A; -A' W] of redundant problems, it falls back to LDLT.
+		 * In mixed precision the matrix is factorised in float, and each solution is corrected by
+		 * iterative refinement with residuals computed in DataType.
+		 */
+		template <class Hessian, bool Sparse = is_base_of<SparseMatrixBase<Hessian>,Hessian>::value>
+		struct Decomposition
+		{
+			typedef Matrix<float,Hessian::RowsAtCompileTime,Hessian::ColsAtCompileTime> SingleMatrix;
+			typedef Matrix<float,Hessian::RowsAtCompileTime,1>                          SingleVector;
+			typedef Matrix<DataType,Hessian::RowsAtCompileTime,1>                       Residual;
+			
+			Factorisation<Hessian>                     factorisation;                   ///< As chosen by the user
+			LDLT<Hessian,Lower>                        fallback;                        ///< Used if the above fails
+			bool                                       failed = false;                  ///< True if the fallback is being used
+			
+			Factorisation<SingleMatrix>                single;                          ///< Factorisation in float for mixed precision
+			SingleMatrix                               Isingle;                         ///< The matrix rounded to float
+			SingleVector                               correction;                      ///< Solution of the residual equation in float
+			Residual                                   b;                               ///< Right hand side of the current solve
+			Residual                                   r;                               ///< b - I*x in full precision
+			const Hessian                             *matrix = nullptr;                ///< The matrix that was factorised, for the residuals
+			bool                                       mixed = false;                   ///< True if the single precision factorisation is being used
+			unsigned int                               maxRefinements = 0;              ///< Refinement steps allowed per solve
+			unsigned int                               refinements = 0;                 ///< Refinement steps taken since the last factorisation
+			
+			void factorise(Hessian &I, const unsigned int &maxRefinements = 0)
+			{
+				if(not solves_in_place<Factorisation<Hessian>>::value)              // Not a Cholesky decomposition, so it reads the upper triangle
+				{
+					I.template triangularView<StrictlyUpper>() = I.transpose();
+				}
+				
+				this->matrix         = &I;
+				this->maxRefinements = maxRefinements;
+				this->refinements    = 0;
+				this->mixed          = false;
+				
+				if(maxRefinements > 0)
+				{
+					this->Isingle = I.template cast<float>();
+					this->single.compute(this->Isingle);
+					
+					this->mixed = (this->single.info() == Success);             // Otherwise use full precision
+					
+					if(this->mixed) return;
+				}
+				
+				this->factorisation.compute(I);
+				
+				this->failed = (this->factorisation.info() != Success);
+				
+				if(this->failed) this->fallback.compute(I);
+			}
+			
+			template <class Rhs>
+			void solve_in_place(Rhs &x)
+			{
+				if(this->mixed)       refine(x);
+				else if(this->failed) solve_with(this->fallback, x);
+				else                  solve_with(this->factorisation, x);
+			}
+			
+			/**
+			 * Solves I*x = b in float, then adds the solution of I*dx = b - I*x until the residual
+			 * stops shrinking, reaches the precision of DataType, or maxRefinements is reached.
+			 */
+			template <class Rhs>
+			void refine(Rhs &x)
+			{
+				this->b          = x;
+				this->correction = this->b.template cast<float>();
+				solve_with(this->single, this->correction);
+				x = this->correction.template cast<DataType>();
+				
+				DataType tolerance = 10*NumTraits<DataType>::epsilon()*this->b.norm();
+				DataType previous  = std::numeric_limits<DataType>::max();
+				
+				for(unsigned int k = 0; k < this->maxRefinements; k++)
+				{
+					this->r = this->b;
+					this->r.noalias() -= this->matrix->template selfadjointView<Lower>()*x;
+					
+					DataType residual = this->r.norm();
+					
+					if(residual <= tolerance or residual >= 0.5*previous) break;  // Converged or stagnated
+					
+					previous = residual;
+					
+					this->correction = this->r.template cast<float>();
+					solve_with(this->single, this->correction);
+					x += this->correction.template cast<DataType>();
+					
+					this->refinements++;
+				}
+			}
+			
+			template <class Decomp, class Rhs>
+			static void solve_with(const Decomp &decomp, Rhs &x) { solve_with(decomp, x, solves_in_place<Decomp>()); }
+			
+			template <class Decomp, class Rhs>
+			static void solve_with(const Decomp &decomp, Rhs &x, true_type) { decomp.solveInPlace(x); }
+			
+			template <class Decomp, class Rhs>
+			static void solve_with(const Decomp &decomp, Rhs &x, false_type)
+			{
+				MallocGuard guard(true);                                            // Only for the QR factorisations
+				
+				x = decomp.solve(x);
+			}
+		};
+		
+		/**
+		 * Sparse matrices use a simplicial LDLT. The symbolic analysis (ordering and elimination tree)
+		 * is only recomputed when the sparsity pattern changes. There is no mixed precision.
+		 */
+		template <class Hessian>
+		struct Decomposition<Hessian,true> : public SimplicialLDLT<Hessian,Lower,SaddlePointOrdering>
+		{
+			Hessian pattern;                                                            ///< Matrix from the last symbolic analysis
+			unsigned int refinements = 0;                                               ///< Always 0
+			
+			void factorise(Hessian &I, const unsigned int & = 0)
+			{
+				I.makeCompressed();
+				
+				if(I.rows() != this->pattern.rows()
+				or I.nonZeros() != this->pattern.nonZeros()
+				or not equal(I.outerIndexPtr(), I.outerIndexPtr() + I.outerSize() + 1, this->pattern.outerIndexPtr())
+				or not equal(I.innerIndexPtr(), I.innerIndexPtr() + I.nonZeros(), this->pattern.innerIndexPtr()))
+				{
+					this->analyzePattern(I);
+					this->pattern = I;
+				}
+				
+				this->factorize(I);
+			}
+			
+			template <class Rhs>
+			void solve_in_place(Rhs &x) const { x = this->solve(x); }
+		};
+		
+		/**
+		 * Solves the Newton step (H + B'*diag(w)*B)*dx = r in the space of the constraints with the
+		 * Woodbury identity: dx = H^-1*r - G*(diag(1/w) + B*G)^-1*B*H^-1*r, where G = H^-1*B'.
+		 * H is factorised once per call, so each step only factorises a c x c matrix. The matrices
+		 * are sized dynamically, since c is not known to be small at compile time.
+		 */
+		template <int Dim, int Cons, class Hessian, bool Sparse = is_base_of<SparseMatrixBase<Hessian>,Hessian>::value>
+		struct ConstraintSpace
+		{
+			LLT<Hessian,Lower>                         Hdecomp;                         ///< H = L*L', once per call
+			Matrix<DataType,Dim,Dynamic>               G;                               ///< H^-1*B'
+			Matrix<DataType,Dynamic,Dynamic>           S;                               ///< B*H^-1*B'
+			Matrix<DataType,Dynamic,Dynamic>           K;                               ///< S + diag(1/w)
+			LLT<Matrix<DataType,Dynamic,Dynamic>,Lower> Kdecomp;                        ///< Factorised every step
+			Vector<DataType,Cons>                      y;                               ///< B*H^-1*r, then K^-1*B*H^-1*r
+			bool                                       active = false;                  ///< True if it is used instead of the full Hessian
+			
+			/**
+			 * Factorises H and forms G and S one constraint at a time.
+			 * @param column, unit, Bcolumn Memory of the size of x, w and B*x.
+			 * @return False if H is not positive definite, or too badly conditioned to invert.
+			 */
+			template <class Constraints>
+			bool prepare(const Hessian             &H,
+			             Constraints               &constraints,
+			             Vector<DataType,Dim>      &column,
+			             Vector<DataType,Cons>     &unit,
+			             Vector<DataType,Cons>     &Bcolumn)
+			{
+				unsigned int c = constraints.size();
+				
+				this->Hdecomp.compute(H);
+				
+				if(this->Hdecomp.info() != Success) return false;
+				
+				// (min(L_ii)/max(L_ii))^2 estimates 1/cond(H) without allocating, as rcond() would
+				DataType ratio = this->Hdecomp.matrixLLT().diagonal().minCoeff()
+				               / this->Hdecomp.matrixLLT().diagonal().maxCoeff();
+				
+				if(ratio*ratio < sqrt(NumTraits<DataType>::epsilon())) return false;
+				
+				this->G.resize(H.rows(),c);
+				this->S.resize(c,c);
+				this->K.resize(c,c);
+				this->y.resize(c);
+				
+				for(unsigned int j = 0; j < c; j++)
+				{
+					unit.setZero();
+					unit(j) = 1;
+					column.setZero();
+					constraints.add_gradient(unit, column);                             // j-th row of B
+					this->Hdecomp.solveInPlace(column);
+					this->G.col(j) = column;
+					constraints.multiply(column, Bcolumn);
+					this->S.col(j) = Bcolumn;
+				}
+				
+				return true;
+			}
+			
+			void factorise(const Vector<DataType,Cons> &w)
+			{
+				this->K = this->S;
+				this->K.diagonal() += w.cwiseInverse();
+				this->Kdecomp.compute(this->K);
+			}
+			
+			template <class Constraints>
+			void solve_in_place(Constraints &constraints, Vector<DataType,Dim> &x)
+			{
+				this->Hdecomp.solveInPlace(x);
+				constraints.multiply(x, this->y);
+				this->Kdecomp.solveInPlace(this->y);
+				x.noalias() -= this->G*this->y;
+			}
+		};
+		
+		/**
+		 * Sparse matrices always factorise the full Hessian.
+		 */
+		template <int Dim, int Cons, class Hessian>
+		struct ConstraintSpace<Dim,Cons,Hessian,true>
+		{
+			bool active = false;                                                        ///< Always
+			
+			template <class Constraints, class Column, class Rows>
+			bool prepare(const Hessian &, Constraints &, Column &, Rows &, Rows &) { return false; }
+			
+			template <class Rows>
+			void factorise(const Rows &) {}
+			
+			template <class Constraints, class Rhs>
+			void solve_in_place(Constraints &, Rhs &) {}
+		};
+		
+		/**
+		 * Memory for the interior point algorithm that is kept between calls. It is (re)sized on the
+		 * first call with a given problem size, after which solving does not allocate on the heap.
+		 * When the problem size is known at compile time it lives on the stack.
+		 * @tparam Dim The number of variables in the standard form of the problem.
+		 * @tparam Cons The number of inequality constraints.
+		 * @tparam Hessian Either a dense matrix, or a sparse matrix with Dim = Cons = Dynamic.
+		 */
+		template <int Dim, int Cons, class Hessian = Matrix<DataType,Dim,Dim>>
+		struct Workspace
+		{
+			Hessian                                    H;                               ///< Hessian for the standard form of the problem
+			Hessian                                    I;                               ///< Hessian of the barrier function
+			Matrix<DataType,Cons,N,(N == 1) ? ColMajor : RowMajor> Bw;                  ///< Constraint rows scaled by the square root of the barrier weights
+			Vector<DataType,Dim>                       f;                               ///< Linear component for the standard form of the problem
+			Vector<DataType,Dim>                       x0;                              ///< Start point for the standard form of the problem
+			Vector<DataType,Dim>                       x;                               ///< Solution to the standard form of the problem
+			Vector<DataType,Dim>                       dx;                              ///< Newton step
+			Vector<DataType,Dim>                       g;                               ///< Gradient vector
+			Vector<DataType,Cons>                      d;                               ///< Distance to every constraint
+			Vector<DataType,Cons>                      w;                               ///< Barrier weight on every constraint
+			Vector<DataType,Cons>                      Bdx;                             ///< Change in distance to every constraint for a given step
+			Decomposition<Hessian>                     Idecomp;                         ///< Only the lower triangle of I is used
+			ConstraintSpace<Dim,Cons,Hessian>          constraintSpace;                 ///< Used instead of Idecomp when there are few constraints
+			Vector<DataType,Cons>                      lambda;                          ///< Dual estimates u/d from the last solution
+			Vector<DataType,Cons>                      s;                               ///< Slack variables for the primal-dual algorithm
+			Vector<DataType,Cons>                      ds;                              ///< Newton step for the slack variables
+			Vector<DataType,Dim>                       xBest;                           ///< Best strictly feasible iterate of the primal-dual algorithm
+			Vector<DataType,Cons>                      dlambda;                         ///< Newton step for the Lagrange multipliers
+			DataType                                   u;                               ///< Barrier scalar from the last solution
+			unsigned int                               coldSteps = 0;                   ///< Number of steps taken by the last cold start
+			bool                                       warm = false;                    ///< True if the above can be used for a warm start
+			ActiveSetWorkspace<Cons>                   activeSet;                       ///< Used by the active set method
+		};
+		
+		Workspace<N,C>           genericWorkspace;                                          ///< Used by solve(H,f,B,z,x0)
+		Workspace<N,twoN>        boundsWorkspace;                                           ///< Used by constrained_least_squares(y,A,W,xMin,xMax,x0)
+		Workspace<MplusN,C>      redundantWorkspace;                                        ///< Used by constrained_least_squares(xd,W,A,y,B,z,x0) and solve(H,f,A,y,B,z,x0)
+		Workspace<MplusN,twoN>   redundantBoundsWorkspace;                                  ///< Used by constrained_least_squares(xd,W,A,y,xMin,xMax,x0)
+		
+		Workspace<Dynamic,Dynamic,SparseMatrix<DataType>> sparseWorkspace;                  ///< Used by solve(H,f,B,z,x0) with sparse matrices
+		Workspace<Dynamic,Dynamic,SparseMatrix<DataType>> sparseRedundantWorkspace;         ///< Used by constrained_least_squares(xd,W,A,y,B,z,x0) with sparse matrices
+		
+		/**
+		 * Memory for converting least squares problems to standard form.
+		 */
+		struct LeastSquaresWorkspace
+		{
+			Matrix<DataType,N,M>                       AtW;                             ///< A'*W for least squares problems
+			Matrix<DataType,N,M>                       invWAt;                          ///< W^-1*A' for redundant problems
+			Matrix<DataType,M,M>                       AinvWAt;                         ///< A*W^-1*A' for redundant problems
+			Vector<DataType,N>                         xr;                              ///< Range space solution for the dual method
+			Vector<DataType,N>                         xn;                              ///< Null space solution for the dual method
+			Vector<DataType,M>                         r;                               ///< Residual of the equality constraint
+			Vector<DataType,M>                         lambda;                          ///< Lagrange multipliers of the equality constraint
+			Factorisation<Matrix<DataType,N,N>>        Wdecomp;                         ///< Decomposition of the weighting matrix W
+			Factorisation<Matrix<DataType,M,M>>        AinvWAtdecomp;                   ///< Decomposition of A*W^-1*A'
+		};
+		
+		LeastSquaresWorkspace leastSquares;                                                 ///< Used by the constrained least squares functions
+		
+		/**
+		 * Memory for the null space method, which solves redundant problems with x = xp + Z*v.
+		 */
+		template <int Cons>
+		struct NullSpaceWorkspace
+		{
+			HouseholderQR<Matrix<DataType,N,M>>        qr;                              ///< Decomposition of A'
+			Vector<DataType,Dynamic>                   householder;                     ///< Memory for applying the Householder reflections
+			Matrix<DataType,N,Dynamic>                 Z;                               ///< Orthonormal basis for the null space of A
+			Matrix<DataType,N,Dynamic>                 WZ;                              ///< W*Z
+			Vector<DataType,N>                         xp;                              ///< Minimum subject to A*x = y only
+			Vector<DataType,N>                         column;                          ///< A column of Z
+			Matrix<DataType,Cons,Dynamic>              B;                               ///< Constraint matrix in the null space
+			Vector<DataType,Cons>                      z;                               ///< Constraint vector in the null space
+			Matrix<DataType,Cons,Dynamic,RowMajor>     Bw;                              ///< Constraint rows scaled by the square root of the barrier weights
+			Workspace<Dynamic,Cons>                    reduced;                         ///< Used to solve for v
+		};
+		
+		NullSpaceWorkspace<C>    nullSpaceWorkspace;                                        ///< Used by constrained_least_squares(xd,W,A,y,B,z,x0) and solve(H,f,A,y,B,z,x0)
+		NullSpaceWorkspace<twoN> nullSpaceBoundsWorkspace;                                  ///< Used by constrained_least_squares(xd,W,A,y,xMin,xMax,x0)
+		
+		enum Call {none, generic, boundedLeastSquares,
+		           redundantPrimal, redundantDual, redundantNullSpace,
+		           redundantBoundsPrimal, redundantBoundsDual, redundantBoundsNullSpace,
+		           equalityPrimal, equalityNullSpace} lastCall = none; ///< The function that last used the workspaces
+		
+		unsigned int lastDimensions[3] = {0, 0, 0};                                         ///< Dimensions n, m, c from the last call
+		
+		bool cached = false;                                                                ///< True if the workspace holds the decompositions for the matrices of a QPProblem
+		
+		/**
+		 * Records the function being called and the problem dimensions.
+		 * @return True if the last call was for the same function and dimensions, i.e. no memory will be allocated.
+		 */
+		bool reuse_workspace(const Call &call, const unsigned int &n, const unsigned int &m, const unsigned int &c)
+		{
+			bool same = (call == this->lastCall
+			             and n == this->lastDimensions[0]
+			             and m == this->lastDimensions[1]
+			             and c == this->lastDimensions[2]);
+			
+			this->cached   = false;                                                     // Set again by QPProblem after it solves
+			this->lastCall = call;
+			this->lastDimensions[0] = n;
+			this->lastDimensions[1] = m;
+			this->lastDimensions[2] = c;
+			
+			return same;
+		}
+		
+		/**
+		 * A pool of threads for the batch functions. Each thread has its own solver, and hence its
+		 * own workspace. The tasks are split evenly between the threads, and a thread that runs out
+		 * steals half of the tasks remaining from another.
+		 */
+		struct ThreadPool
+		{
+			struct Range
+			{
+				std::mutex mutex;                                                   ///< Held while the range is changed
+				unsigned int begin = 0;                                             ///< Next task to take from the front
+				unsigned int end = 0;                                               ///< One past the last task
+			};
+			
+			std::vector<std::unique_ptr<QPSolver>> solvers;                             ///< One for each thread
+			std::vector<std::thread> threads;                                           ///< Threads 1, 2, ..., the caller is thread 0
+			std::unique_ptr<Range[]> ranges;                                            ///< The tasks remaining for each thread
+			std::function<void(QPSolver&,const unsigned int&)> task;                    ///< Called for each task
+			std::mutex mutex;                                                           ///< Protects the variables below
+			std::condition_variable wake;                                               ///< Signals the threads to start
+			std::condition_variable finished;                                           ///< Signals the caller that a thread is done
+			unsigned long generation = 0;                                               ///< Incremented each time tasks are run
+			unsigned int busy = 0;                                                      ///< Number of threads still working
+			bool stop = false;                                                          ///< Tells the threads to return
+			
+			ThreadPool(const unsigned int &number) : ranges(new Range[number])
+			{
+				for(unsigned int i = 0; i < number; i++) this->solvers.emplace_back(new QPSolver());
+				
+				for(unsigned int i = 1; i < number; i++) this->threads.emplace_back(&ThreadPool::loop, this, i);
+			}
+			
+			~ThreadPool()
+			{
+				{
+					std::lock_guard<std::mutex> lock(this->mutex);
+					this->stop = true;
+				}
+				
+				this->wake.notify_all();
+				
+				for(auto &thread : this->threads) thread.join();
+			}
+			
+			unsigned int size() const { return this->solvers.size(); }
+			
+			/**
+			 * Call task(solver,i) for i = 0, 1, ..., numTasks-1 and return when they are done.
+			 */
+			void run(const unsigned int &numTasks, const std::function<void(QPSolver&,const unsigned int&)> &task)
+			{
+				unsigned long n = size();
+				
+				for(unsigned int i = 0; i < n; i++)
+				{
+					std::lock_guard<std::mutex> lock(this->ranges[i].mutex);
+					this->ranges[i].begin = (numTasks*i)/n;
+					this->ranges[i].end   = (numTasks*(i+1))/n;
+				}
+				
+				{
+					std::lock_guard<std::mutex> lock(this->mutex);
+					this->task = task;
+					this->busy = n - 1;
+					this->generation++;
+				}
+				
+				this->wake.notify_all();
+				
+				work(0);                                                            // The caller does its share
+				
+				std::unique_lock<std::mutex> lock(this->mutex);
+				this->finished.wait(lock, [this]{ return this->busy == 0; });
+			}
+			
+			/**
+			 * The body of threads 1, 2, ..., which wait for tasks until the pool is destroyed.
+			 */
+			void loop(const unsigned int id)
+			{
+				unsigned long seen = 0;
+				
+				while(true)
+				{
+					{
+						std::unique_lock<std::mutex> lock(this->mutex);
+						this->wake.wait(lock, [&]{ return this->stop or this->generation != seen; });
+						
+						if(this->stop) return;
+						
+						seen = this->generation;
+					}
+					
+					work(id);
+					
+					{
+						std::lock_guard<std::mutex> lock(this->mutex);
+						this->busy--;
+					}
+					
+					this->finished.notify_one();
+				}
+			}
+			
+			void work(const unsigned int &id)
+			{
+				unsigned int i;
+				
+				while(next(id,i)) this->task(*this->solvers[id],i);
+			}
+			
+			/**
+			 * Take the next task from the front of this thread's range, or steal the back half of
+			 * another range when it is empty. Only one lock is held at a time.
+			 * @return False when there are no tasks left.
+			 */
+			bool next(const unsigned int &id, unsigned int &i)
+			{
+				Range &own = this->ranges[id];
+				
+				{
+					std::lock_guard<std::mutex> lock(own.mutex);
+					
+					if(own.begin < own.end)
+					{
+						i = own.begin++;
+						return true;
+					}
+				}
+				
+				for(unsigned int k = 1; k < size(); k++)
+				{
+					Range &other = this->ranges[(id + k) % size()];
+					
+					unsigned int begin, end;
+					
+					{
+						std::lock_guard<std::mutex> lock(other.mutex);
+						
+						if(other.begin >= other.end) continue;
+						
+						end   = other.end;
+						begin = other.end - (other.end - other.begin + 1)/2;
+						other.end = begin;
+					}
+					
+					{
+						std::lock_guard<std::mutex> lock(own.mutex);
+						own.begin = begin + 1;
+						own.end   = end;
+					}
+					
+					i = begin;
+					return true;
+				}
+				
+				return false;
+			}
+		};
+		
+		std::unique_ptr<ThreadPool> threadPool;                                             ///< Used by the batch functions
+		
+		unsigned int numThreads = std::max(1u, std::thread::hardware_concurrency());        ///< Size of the thread pool
+		
+		bool parallelAssembly = false;                                                      ///< Share the constraint rows between threads if true
+		
+		unsigned int maxRefinements = 0;                                                    ///< Refinement steps per Newton step in mixed precision, 0 for full precision
+		
+		static constexpr unsigned int blockSize = 256;                                      ///< Constraint rows in each block of the parallel assembly
+		
+		/**
+		 * Memory for the parallel assembly. Each block of constraint rows has its own partial sums.
+		 */
+		struct AssemblyWorkspace
+		{
+			Matrix<DataType,Dynamic,Dynamic>           gradients;                       ///< Column k is the gradient from block k
+			std::vector<Matrix<DataType,Dynamic,Dynamic>> hessians;                     ///< Lower triangle of the Hessian from each block
+			Vector<DataType,Dynamic>                   minimum;                         ///< Step length from each block
+		};
+		
+		AssemblyWorkspace assembly;                                                         ///< Used by the parallel assembly
+		
+		/**
+		 * @param rows The number of constraints.
+		 * @return The thread pool if the rows should be shared between threads, or null if not.
+		 */
+		ThreadPool *assembly_pool(const unsigned int &rows)
+		{
+			if(not this->parallelAssembly or rows <= blockSize) return nullptr;
+			
+			if(not this->threadPool or this->threadPool->size() != this->numThreads)
+			{
+				MallocGuard guard(true);                                                    // Only on the first call
+				
+				start_thread_pool();
+			}
+			
+			return this->threadPool.get();
+		}
+		
+		/**
+		 * @return The number of blocks of constraint rows for the parallel assembly.
+		 */
+		static unsigned int num_blocks(const unsigned int &rows) { return (rows + blockSize - 1)/blockSize; }
+		
+		/**
+		 * Calls task(k, row, rows) for every block k of constraint rows with the thread pool.
+		 * The blocks are the same for any number of threads.
+		 */
+		template <class Task>
+		static void for_each_block(ThreadPool &pool, const unsigned int &numRows, const Task &task)
+		{
+			pool.run(num_blocks(numRows), [&](QPSolver&, const unsigned int &k)
+			{
+				unsigned int row = k*blockSize;
+				
+				task(k, row, (numRows - row < blockSize) ? numRows - row : blockSize);
+			});
+		}
+		
+		/**
+		 * Solve numProblems problems with the thread pool, using the same options as this object.
+		 * @param solve Solves problem i with the given solver.
+		 */
+		SolutionList run_batch(const unsigned int &numProblems,
+		                       const std::function<Vector<DataType,N>(QPSolver&,const unsigned int&)> &solve);
+		
+		/**
+		 * Makes the thread pool if needed, and copies the options of this object to its solvers.
+		 */
+		void start_thread_pool();
+		
+		/**
+		 * Copies the options of this object to another solver.
+		 */
+		void copy_options(QPSolver &solver) const;
+		
+		std::vector<std::unique_ptr<QPSolver>> portfolio;                                   ///< One solver for each configuration
+		
+		std::vector<unsigned int> portfolioWins;                                            ///< Times each configuration has won
+		
+		unsigned int portfolioWinner = 0;                                                   ///< Configuration that won the last portfolio call
+		
+		std::atomic<bool> portfolioDone{false};                                             ///< Tells the other configurations to stop once one has won
+		
+		/**
+		 * Race every configuration of the portfolio on the thread pool.
+		 * @param solve Solves the problem with the given solver.
+		 * @param objective The objective function, to choose between solutions when none converged.
+		 */
+		Vector<DataType,N> run_portfolio(const std::function<Vector<DataType,N>(QPSolver&)> &solve,
+		                                 const std::function<DataType(const Vector<DataType,N>&)> &objective);
+		
+		/**
+		 * Copies of the arguments for solve_async().
+		 */
+		struct ProblemCopy
+		{
+			EIGEN_MAKE_ALIGNED_OPERATOR_NEW                                             // Needed for fixed-size Eigen members
+			
+			Matrix<DataType,N,N> H;
+			Vector<DataType,N>   f;
+			Matrix<DataType,C,N> B;
+			Vector<DataType,C>   z;
+			Vector<DataType,N>   x0;
+		};
+		
+		/**
+		 * Copies of the arguments for constrained_least_squares_async().
+		 */
+		struct LeastSquaresProblemCopy
+		{
+			EIGEN_MAKE_ALIGNED_OPERATOR_NEW                                             // Needed for fixed-size Eigen members
+			
+			Vector<DataType,N>   xd;
+			Matrix<DataType,N,N> W;
+			Matrix<DataType,M,N> A;
+			Vector<DataType,M>   y;
+			Matrix<DataType,C,N> B;
+			Vector<DataType,C>   z;
+			Vector<DataType,N>   x0;
+		};
+		
+		/**
+		 * Calls solve() on another thread, which can be stopped with cancel().
+		 * @param solve Solves the problem with this object. It must own copies of the arguments.
+		 */
+		std::future<Solution> run_async(const std::function<Vector<DataType,N>()> &solve);
+		
+		/**
+		 * Calls solve(), and records the solution and status.
+		 * @param solver Used to get the number of steps.
+		 */
+		static void record(const QPSolver &solver,
+		                   Solution &solution,
+		                   const std::function<Vector<DataType,N>()> &solve);
+		
+		/**
+		 * Solves a group of up to Lanes problems with the same dimensions in lockstep with the
+		 * barrier method. The data is stored as structure-of-arrays: column k of each array holds
+		 * element k of every problem, so each operation on a column works on every problem at once.
+		 * A problem the lockstep iteration cannot handle is solved with solve() instead.
+		 * @param problems The full list of problems.
+		 * @param group Indices of the problems to solve in this group.
+		 * @param solutions Where the solutions are stored.
+		 */
+		template <int Lanes>
+		void lockstep_interior_point(const std::vector<Problem>      &problems,
+		                             const std::vector<unsigned int> &group,
+		                             SolutionList                    &solutions);
+		
+		/**
+		 * When EIGEN_RUNTIME_NO_MALLOC is defined, this asserts that Eigen does not allocate memory
+		 * on the heap for as long as the object is in scope. Otherwise it does nothing. The QR
+		 * factorisations always allocate when solving, so nothing is checked when they are used.
+		 */
+		struct MallocGuard
+		{
+		#ifdef EIGEN_RUNTIME_NO_MALLOC
+			bool previous;                                                              ///< Restored on destruction
+			
+			MallocGuard(const bool &allowed) : previous(internal::is_malloc_allowed())
+			{
+				internal::set_is_malloc_allowed(allowed or not solves_in_place<Factorisation<Matrix<DataType,Dynamic,Dynamic>>>::value);
+			}
+			
+			~MallocGuard() { internal::set_is_malloc_allowed(this->previous); }
+		#else
+			MallocGuard(const bool &allowed) {}
+		#endif
+		};
+		
+		/**
+		 * Used by the active set method when there are no equality constraints.
+		 */
+		struct NoEqualities
+		{
+			unsigned int size() const { return 0; }
+			
+			void normal(const unsigned int &i, Vector<DataType,N> &n) const {}
+			
+			DataType residual(const unsigned int &i, const Vector<DataType,N> &x) const { return 0; }
+		};
+		
+		/**
+		 * Equality constraints of the form A*x = y for the active set method.
+		 */
+		struct LinearEqualities
+		{
+			const Matrix<DataType,M,N> &A;                                              ///< Equality constraint matrix
+			const Vector<DataType,M>   &y;                                              ///< Equality constraint vector
+			
+			LinearEqualities(const Matrix<DataType,M,N> &_A,
+			                 const Vector<DataType,M>   &_y)
+			                 : A(_A), y(_y) {}
+			
+			unsigned int size() const { return this->y.size(); }
+			
+			/**
+			 * Gets the normal of the i-th constraint, i.e. the i-th row of A.
+			 */
+			void normal(const unsigned int &i, Vector<DataType,N> &n) const { n = this->A.row(i).transpose(); }
+			
+			/**
+			 * @return The value A.row(i)*x - y(i).
+			 */
+			DataType residual(const unsigned int &i, const Vector<DataType,N> &x) const { return this->A.row(i).dot(x) - this->y(i); }
+		};
+		
+		/**
+		 * Inequality constraints of the form B*x <= z. The constraint matrix may act on only a segment
+		 * of the decision variable, e.g. when it is augmented with Lagrange multipliers.
+		 */
+		template <int Rows = C, int Cols = N>
+		struct LinearConstraints
+		{
+			typedef Matrix<DataType,Rows,Cols,(Cols == 1) ? ColMajor : RowMajor> ScaledMatrix;
+			
+			const Matrix<DataType,Rows,Cols> &B;                                        ///< Constraint matrix
+			const Vector<DataType,Rows>      &z;                                        ///< Constraint vector
+			unsigned int start = 0;                                                     ///< Index of the first variable that B acts on
+			ScaledMatrix &Bw;                                                           ///< Constraint rows scaled by the square root of the barrier weights
+			QPSolver *solver;                                                           ///< Its thread pool is used for the parallel assembly
+			
+			LinearConstraints(const Matrix<DataType,Rows,Cols> &_B,
+			                  const Vector<DataType,Rows>      &_z,
+			                  ScaledMatrix                     &_Bw,
+			                  QPSolver                         *_solver = nullptr)
+			                  : B(_B), z(_z), Bw(_Bw), solver(_solver) {}
+			
+			unsigned int size() const { return this->z.size(); }
+			
+			/**
+			 * @return The thread pool if the rows are shared between threads, or null if not.
+			 */
+			ThreadPool *pool() const { return (this->solver == nullptr) ? nullptr : this->solver->assembly_pool(size()); }
+			
+			/**
+			 * Computes the distance to every constraint d = z - B*x.
+			 */
+			template <int Dim>
+			void distance(const Vector<DataType,Dim> &x, Vector<DataType,Rows> &d) const
+			{
+				unsigned int n = this->B.cols();
+				
+				if(ThreadPool *pool = this->pool())
+				{
+					for_each_block(*pool, size(), [&](const unsigned int &k, const unsigned int &row, const unsigned int &rows)
+					{
+						d.segment(row,rows).noalias() = this->z.segment(row,rows) - this->B.middleRows(row,rows)*x.template segment<Cols>(this->start,n);
+					});
+				}
+				else d.noalias() = this->z - this->B*x.template segment<Cols>(this->start,n);
+			}
+			
+			/**
+			 * Computes the change in constraint values B*dx for a given step dx.
+			 */
+			template <int Dim>
+			void multiply(const Vector<DataType,Dim> &dx, Vector<DataType,Rows> &Bdx) const
+			{
+				unsigned int n = this->B.cols();
+				
+				if(ThreadPool *pool = this->pool())
+				{
+					for_each_block(*pool, size(), [&](const unsigned int &k, const unsigned int &row, const unsigned int &rows)
+					{
+						Bdx.segment(row,rows).noalias() = this->B.middleRows(row,rows)*dx.template segment<Cols>(this->start,n);
+					});
+				}
+				else Bdx.noalias() = this->B*dx.template segment<Cols>(this->start,n);
+			}
+			
+			/**
+			 * Adds the barrier gradient g += B'*w. In parallel, each block of rows sums its own
+			 * B_k'*w_k, and these are added to g in the order of the blocks.
+			 */
+			template <int Dim>
+			void add_gradient(const Vector<DataType,Rows> &w, Vector<DataType,Dim> &g) const
+			{
+				unsigned int n = this->B.cols();
+				
+				if(ThreadPool *pool = this->pool())
+				{
+					Matrix<DataType,Dynamic,Dynamic> &gradients = this->solver->assembly.gradients;
+					
+					gradients.resize(n, num_blocks(size()));                            // Only allocates if the size changed
+					
+					for_each_block(*pool, size(), [&](const unsigned int &k, const unsigned int &row, const unsigned int &rows)
+					{
+						gradients.col(k).noalias() = this->B.middleRows(row,rows).transpose()*w.segment(row,rows);
+					});
+					
+					for(int k = 0; k < gradients.cols(); k++) g.template segment<Cols>(this->start,n) += gradients.col(k);
+				}
+				else g.template segment<Cols>(this->start,n).noalias() += this->B.transpose()*w;
+			}
+			
+			/**
+			 * Adds the barrier Hessian I += B'*diag(w)*B to the lower triangle of I. In parallel, each
+			 * block of rows forms its own B_k'*diag(w_k)*B_k. The threads then split the columns of I,
+			 * and add the blocks in order.
+			 */
+			template <int Dim>
+			void add_hessian(const Vector<DataType,Rows> &w, Matrix<DataType,Dim,Dim> &I)
+			{
+				unsigned int n = this->B.cols();
+				
+				if(ThreadPool *pool = this->pool())
+				{
+					std::vector<Matrix<DataType,Dynamic,Dynamic>> &hessians = this->solver->assembly.hessians;
+					
+					hessians.resize(num_blocks(size()));                                // Only allocates if the size changed
+					for(auto &hessian : hessians) hessian.resize(n,n);
+					this->Bw.resize(size(),n);
+					
+					for_each_block(*pool, size(), [&](const unsigned int &k, const unsigned int &row, const unsigned int &rows)
+					{
+						this->Bw.middleRows(row,rows).noalias() = w.segment(row,rows).cwiseSqrt().asDiagonal()*this->B.middleRows(row,rows);
+						
+						hessians[k].template triangularView<Lower>().setZero();
+						hessians[k].template selfadjointView<Lower>().rankUpdate(this->Bw.middleRows(row,rows).transpose());
+					});
+					
+					unsigned int numThreads = pool->size();
+					
+					pool->run(numThreads, [&](QPSolver&, const unsigned int &t)
+					{
+						for(unsigned int j = (n*t)/numThreads; j < (n*(t+1))/numThreads; j++)
+						{
+							for(const auto &hessian : hessians)
+							{
+								I.col(this->start+j).segment(this->start+j,n-j) += hessian.col(j).tail(n-j);
+							}
+						}
+					});
+				}
+				else
+				{
+					this->Bw.noalias() = w.cwiseSqrt().asDiagonal()*this->B;    // Scale each constraint row
+					
+					I.template block<Cols,Cols>(this->start,this->start,n,n).template selfadjointView<Lower>().rankUpdate(this->Bw.transpose()); // Blocked weighted Gram product
+				}
+			}
+			
+			/**
+			 * Gets the j-th row of B.
+			 */
+			void row(const unsigned int &j, Vector<DataType,Cols> &b) const { b = this->B.row(j).transpose(); }
+		};
+		
+		/**
+		 * Upper and lower bounds xMin <= x <= xMax on a segment of the decision variable.
+		 * These are equivalent to B = [I; -I], z = [xMax; -xMin], but the B matrix is never formed.
+		 * The barrier only adds to the diagonal of the Hessian.
+		 */
+		struct BoundConstraints
+		{
+			const Vector<DataType,N> &lower;                                            ///< Lower bound on the decision variable
+			const Vector<DataType,N> &upper;                                            ///< Upper bound on the decision variable
+			unsigned int start = 0;                                                     ///< Index of the first variable that is bounded
+			
+			BoundConstraints(const Vector<DataType,N> &xMin,
+			                 const Vector<DataType,N> &xMax)
+			                 : lower(xMin), upper(xMax) {}
+			
+			unsigned int size() const { return 2*this->lower.size(); }
+			
+			/**
+			 * Computes the distance to every bound d = [xMax - x; x - xMin].
+			 */
+			template <int Dim>
+			void distance(const Vector<DataType,Dim> &x, Vector<DataType,twoN> &d) const
+			{
+				unsigned int n = this->lower.size();
+				
+				d.template head<N>(n) = this->upper - x.template segment<N>(this->start,n);
+				d.template segment<N>(n,n) = x.template segment<N>(this->start,n) - this->lower;
+			}
+			
+			/**
+			 * Computes the change in bound values [dx; -dx] for a given step dx.
+			 */
+			template <int Dim>
+			void multiply(const Vector<DataType,Dim> &dx, Vector<DataType,twoN> &Bdx) const
+			{
+				unsigned int n = this->lower.size();
+				
+				Bdx.template head<N>(n) =  dx.template segment<N>(this->start,n);
+				Bdx.template segment<N>(n,n) = -dx.template segment<N>(this->start,n);
+			}
+			
+			/**
+			 * Adds the barrier gradient g += w_upper - w_lower.
+			 */
+			template <int Dim>
+			void add_gradient(const Vector<DataType,twoN> &w, Vector<DataType,Dim> &g) const
+			{
+				unsigned int n = this->lower.size();
+				
+				g.template segment<N>(this->start,n) += w.template head<N>(n) - w.template segment<N>(n,n);
+			}
+			
+			/**
+			 * Adds the barrier Hessian I += diag(w_upper + w_lower).
+			 */
+			template <int Dim>
+			void add_hessian(const Vector<DataType,twoN> &w, Matrix<DataType,Dim,Dim> &I) const
+			{
+				unsigned int n = this->lower.size();
+				
+				I.diagonal().template segment<N>(this->start,n) += w.template head<N>(n) + w.template segment<N>(n,n);
+			}
+			
+			/**
+			 * Gets the j-th row of B = [I; -I].
+			 */
+			void row(const unsigned int &j, Vector<DataType,N> &b) const
+			{
+				unsigned int n = this->lower.size();
+				
+				b.setZero(n);
+				
+				if(j < n) b(j)   =  1;
+				else      b(j-n) = -1;
+			}
+			
+			/**
+			 * Moves the start point to the middle of the bounds, i.e. (B'*B)^-1*B'*z.
+			 */
+			template <int Dim>
+			void interior_point(Vector<DataType,Dim> &x) const
+			{
+				x.template segment<N>(this->start,this->lower.size()) = 0.5*(this->lower + this->upper);
+			}
+		};
+		
+		/**
+		 * Inequality constraints of the form B*x <= z with a sparse B. It acts on the whole decision
+		 * variable, so for the redundant problem B is padded with zero columns for the multipliers.
+		 */
+		struct SparseLinearConstraints
+		{
+			const SparseMatrix<DataType>   &B;                                          ///< Constraint matrix
+			const Vector<DataType,Dynamic> &z;                                          ///< Constraint vector
+			unsigned int start = 0;                                                     ///< Index of the first column of B that is not zero
+			
+			SparseLinearConstraints(const SparseMatrix<DataType>   &_B,
+			                        const Vector<DataType,Dynamic> &_z)
+			                        : B(_B), z(_z) {}
+			
+			unsigned int size() const { return this->z.size(); }
+			
+			/**
+			 * Computes the distance to every constraint d = z - B*x.
+			 */
+			void distance(const Vector<DataType,Dynamic> &x, Vector<DataType,Dynamic> &d) const
+			{
+				d = this->z;
+				d.noalias() -= this->B*x;
+			}
+			
+			/**
+			 * Computes the change in constraint values B*dx for a given step dx.
+			 */
+			void multiply(const Vector<DataType,Dynamic> &dx, Vector<DataType,Dynamic> &Bdx) const
+			{
+				Bdx.noalias() = this->B*dx;
+			}
+			
+			/**
+			 * Adds the barrier gradient g += B'*w.
+			 */
+			void add_gradient(const Vector<DataType,Dynamic> &w, Vector<DataType,Dynamic> &g) const
+			{
+				g.noalias() += this->B.transpose()*w;
+			}
+			
+			/**
+			 * Adds the barrier Hessian I += B'*diag(w)*B. The sparsity pattern does not depend on w.
+			 */
+			void add_hessian(const Vector<DataType,Dynamic> &w, SparseMatrix<DataType> &I) const
+			{
+				I += SparseMatrix<DataType>(this->B.transpose()*w.asDiagonal())*this->B;
+			}
+		};
+		
+		/**
+		 * @return The largest step 0 < alpha <= 1 such that s + alpha*ds >= 0 and lambda + alpha*dlambda >= 0.
+		 */
+		template <int Cons>
+		DataType max_step(const Vector<DataType,Cons> &s,
+		                  const Vector<DataType,Cons> &ds,
+		                  const Vector<DataType,Cons> &lambda,
+		                  const Vector<DataType,Cons> &dlambda)
+		{
+			return min_over_blocks(s.size(), [&](const unsigned int &row, const unsigned int &rows)
+			{
+				DataType alpha = 1.0;
+				for(unsigned int j = row; j < row + rows; j++)
+				{
+					if(ds(j) < 0)      alpha = min(alpha, -s(j)/ds(j));
+					if(dlambda(j) < 0) alpha = min(alpha, -lambda(j)/dlambda(j));
+				}
+				return alpha;
+			});
+		}
+		
+		/**
+		 * @return The largest step 0 < alpha <= 1 for the barrier method, which goes 90% of the way
+		 * to any constraint that d - alpha*Bdx would violate.
+		 */
+		template <int Cons>
+		DataType barrier_step(const Vector<DataType,Cons> &d, const Vector<DataType,Cons> &Bdx)
+		{
+			return min_over_blocks(d.size(), [&](const unsigned int &row, const unsigned int &rows)
+			{
+				DataType alpha = 1.0;
+				for(unsigned int j = row; j < row + rows; j++)
+				{
+					if(d(j) - Bdx(j) <= 0) alpha = min(alpha, 0.9*d(j)/Bdx(j));          // Shrink scalar if constraint violated
+				}
+				return alpha;
+			});
+		}
+		
+		/**
+		 * @return The smallest value of step(row, rows) over the blocks of constraint rows, which are
+		 * shared between threads for the parallel assembly.
+		 */
+		template <class Step>
+		DataType min_over_blocks(const unsigned int &numRows, const Step &step)
+		{
+			if(ThreadPool *pool = assembly_pool(numRows))
+			{
+				Vector<DataType,Dynamic> &minimum = this->assembly.minimum;
+				
+				minimum.resize(num_blocks(numRows));                                        // Only allocates if the size changed
+				
+				for_each_block(*pool, numRows, [&](const unsigned int &k, const unsigned int &row, const unsigned int &rows)
+				{
+					minimum(k) = step(row, rows);
+				});
+				
+				return minimum.minCoeff();
+			}
+			else return step(0, numRows);
+		}
+		
+		/**
+		 * Solves min 0.5*x'*H*x + x'*f subject to inequality constraints with the selected interior
+		 * point algorithm. The solution is stored in ws.x.
+		 * @param H A positive semi-definite matrix such that H = H'.
+		 * @param f A vector for the linear component of the problem.
+		 * @param constraints Either LinearConstraints or BoundConstraints.
+		 * @param x0 Start point for the algorithm.
+		 * @param ws The memory used to solve the problem.
+		 */
+		template <int Dim, int Cons, class Hessian, class Constraints>
+		void
+		interior_point(const Hessian                  &H,
+		               const Vector<DataType,Dim>     &f,
+		               Constraints                    &constraints,
+		               const Vector<DataType,Dim>     &x0,
+		               Workspace<Dim,Cons,Hessian>    &ws)
+		{
+			this->lastStatus = solved;                                                  // Unless phase I finds otherwise
+			
+			start_clock();
+			
+			if(this->algorithm == primalDual) primal_dual_interior_point(H, f, constraints, x0, ws);
+			else                              barrier_interior_point(H, f, constraints, x0, ws);
+		}
+		
+		/**
+		 * The log barrier interior point algorithm. Arguments are the same as interior_point().
+		 */
+		template <int Dim, int Cons, class Hessian, class Constraints>
+		void
+		barrier_interior_point(const Hessian                  &H,
+		                       const Vector<DataType,Dim>     &f,
+		                       Constraints                    &constraints,
+		                       const Vector<DataType,Dim>     &x0,
+		                       Workspace<Dim,Cons,Hessian>    &ws);
+		
+		/**
+		 * The primal-dual interior point algorithm with Mehrotra's predictor-corrector method.
+		 * Arguments are the same as interior_point().
+		 */
+		template <int Dim, int Cons, class Hessian, class Constraints>
+		void
+		primal_dual_interior_point(const Hessian                  &H,
+		                           const Vector<DataType,Dim>     &f,
+		                           Constraints                    &constraints,
+		                           const Vector<DataType,Dim>     &x0,
+		                           Workspace<Dim,Cons,Hessian>    &ws);
+		
+		/**
+		 * Appends the elements of a sparse matrix to a list of triplets, offset by (row, col).
+		 */
+		template <class Derived>
+		static void add_triplets(const SparseMatrixBase<Derived>        &A,
+		                         const unsigned int                     &row,
+		                         const unsigned int                     &col,
+		                         std::vector<Triplet<DataType>>         &triplets)
+		{
+			SparseMatrix<DataType> temp = A;                                            // Evaluate expressions like A.transpose()
+			
+			for(int k = 0; k < temp.outerSize(); k++)
+			{
+				for(typename SparseMatrix<DataType>::InnerIterator it(temp,k); it; ++it)
+				{
+					triplets.emplace_back(row + it.row(), col + it.col(), it.value());
+				}
+			}
+		}
+		
+		/**
+		 * Forms the lower triangle of the barrier Hessian I = H + B'*diag(w)*B.
+		 */
+		template <int Dim, int Cons, class Constraints>
+		void barrier_hessian(const Matrix<DataType,Dim,Dim> &H,
+		                     const Vector<DataType,Cons>    &w,
+		                     Constraints                    &constraints,
+		                     Matrix<DataType,Dim,Dim>       &I)
+		{
+			I.template triangularView<Lower>() = H;
+			constraints.add_hessian(w, I);
+		}
+		
+		/**
+		 * Forms the barrier Hessian I = H + B'*diag(w)*B for sparse matrices.
+		 */
+		template <class Constraints>
+		void barrier_hessian(const SparseMatrix<DataType>   &H,
+		                     const Vector<DataType,Dynamic> &w,
+		                     Constraints                    &constraints,
+		                     SparseMatrix<DataType>         &I)
+		{
+			I = H;
+			constraints.add_hessian(w, I);
+		}
+		
+		/**
+		 * Decides whether the Newton steps of this call are solved in the space of the constraints,
+		 * and if so factorises H. Uses ws.g, ws.w and ws.Bdx, so call it before the first step.
+		 */
+		template <int Dim, int Cons, class Hessian, class Constraints>
+		void prepare_newton_step(const Hessian &H, Constraints &constraints, Workspace<Dim,Cons,Hessian> &ws)
+		{
+			unsigned int c = constraints.size();
+			
+			bool smaller = (this->newtonSpace == constraintSpace)
+			            or (this->newtonSpace == automaticSpace and this->maxRefinements == 0
+			                and constraintSpaceRatio*c <= (unsigned int)H.rows());
+			
+			ws.constraintSpace.active = c > 0 and smaller
+			                        and ws.constraintSpace.prepare(H, constraints, ws.g, ws.w, ws.Bdx);
+			
+			if(ws.constraintSpace.active) ws.Idecomp.refinements = 0;                   // Not used
+		}
+		
+		/**
+		 * Factorises the Newton step for the barrier weights in ws.w, I = H + B'*diag(w)*B.
+		 */
+		template <int Dim, int Cons, class Hessian, class Constraints>
+		void factorise_newton_step(const Hessian &H, Constraints &constraints, Workspace<Dim,Cons,Hessian> &ws)
+		{
+			if(ws.constraintSpace.active) ws.constraintSpace.factorise(ws.w);
+			else
+			{
+				barrier_hessian(H, ws.w, constraints, ws.I);
+				
+				lap(this->stats.assemblyTime);
+				
+				ws.Idecomp.factorise(ws.I, this->maxRefinements);
+			}
+		}
+		
+		/**
+		 * Solves I*x = b in place with the last factorisation.
+		 */
+		template <int Dim, int Cons, class Hessian, class Constraints>
+		void solve_newton_step(Constraints &constraints, Workspace<Dim,Cons,Hessian> &ws, Vector<DataType,Dim> &x)
+		{
+			if(ws.constraintSpace.active) ws.constraintSpace.solve_in_place(constraints, x);
+			else                          ws.Idecomp.solve_in_place(x);
+		}
+		
+		/**
+		 * Phase I: finds a point strictly inside the constraints by minimising the largest violation
+		 * t of B*x - z <= t with the primal-dual method. It stops once every constraint is satisfied
+		 * by a small margin, or the multipliers have converged and t > 0.
+		 * @param constraints Either LinearConstraints or SparseLinearConstraints.
+		 * @param x The start point. It is replaced with the point that was found.
+		 * @param ws Provides the memory. Only x is kept.
+		 * @return False if the constraints cannot be satisfied, in which case x minimises the
+		 * largest violation, and the status and certificate of infeasibility are set.
+		 */
+		template <int Dim, int Cons, class Hessian, class Constraints>
+		bool phase_one(Constraints &constraints, Vector<DataType,Dim> &x, Workspace<Dim,Cons,Hessian> &ws);
+		
+		/**
+		 * The middle of the bounds is the furthest point from them, so phase I takes no steps.
+		 */
+		template <int Dim, int Cons, class Hessian>
+		bool phase_one(BoundConstraints &constraints, Vector<DataType,Dim> &x, Workspace<Dim,Cons,Hessian> &ws);
+		
+		/**
+		 * Forms the phase I Hessian I = delta*eye + B'*diag(w)*B, lower triangle only. The small
+		 * delta keeps it positive definite when B has fewer rows than columns.
+		 */
+		template <int Dim, int Cons, class Constraints>
+		void phase_one_hessian(const Vector<DataType,Cons> &w,
+		                       Constraints                 &constraints,
+		                       const DataType              &delta,
+		                       Matrix<DataType,Dim,Dim>    &I)
+		{
+			I.template triangularView<Lower>().setZero();
+			I.diagonal().setConstant(delta);
+			constraints.add_hessian(w, I);
+		}
+		
+		/**
+		 * Forms the phase I Hessian I = delta*eye + B'*diag(w)*B for sparse matrices.
+		 */
+		template <class Constraints>
+		void phase_one_hessian(const Vector<DataType,Dynamic> &w,
+		                       Constraints                    &constraints,
+		                       const DataType                 &delta,
+		                       SparseMatrix<DataType>         &I)
+		{
+			I.setIdentity();
+			I *= delta;
+			constraints.add_hessian(w, I);
+		}
+		
+		/**
+		 * The dual active set method of Goldfarb & Idnani for min 0.5*x'*H*x + x'*f subject to
+		 * equality and inequality constraints. The solution is stored in ws.activeSet.x.
+		 * @param H A positive definite matrix such that H = H'.
+		 * @param f A vector for the linear component of the problem.
+		 * @param equalities Either NoEqualities or LinearEqualities.
+		 * @param constraints Either LinearConstraints or BoundConstraints.
+		 * @param workspace The memory used to solve the problem.
+		 * @param factorised True if workspace.activeSet.Hdecomp already holds the decomposition of H.
+		 */
+		template <int Dim, int Cons, class Equalities, class Constraints>
+		void
+		active_set_method(const Matrix<DataType,N,N> &H,
+		                  const Vector<DataType,N>   &f,
+		                  const Equalities           &equalities,
+		                  Constraints                &constraints,
+		                  Workspace<Dim,Cons>        &workspace,
+		                  const bool                 &factorised = false);
+		
+		/**
+		 * Computes the step directions z and r for adding the constraint with normal ws.np.
+		 * @param numActive The number of active constraints.
+		 */
+		template <int Cons>
+		void active_set_step(ActiveSetWorkspace<Cons> &ws, const unsigned int &numActive);
+		
+		/**
+		 * Updates J and R with Givens rotations after adding the constraint with normal ws.np.
+		 * @param numActive The number of active constraints. It is incremented.
+		 * @param Rnorm The largest diagonal element of R.
+		 * @return False if the constraint is linearly dependent on the active set.
+		 */
+		template <int Cons>
+		bool add_constraint(ActiveSetWorkspace<Cons> &ws, unsigned int &numActive, DataType &Rnorm);
+		
+		/**
+		 * Removes an inequality constraint from the active set and updates J and R with Givens rotations.
+		 * @param numEqualities Equality constraints are never removed.
+		 * @param numActive The number of active constraints. It is decremented.
+		 * @param index The constraint to remove.
+		 */
+		template <int Cons>
+		void delete_constraint(ActiveSetWorkspace<Cons> &ws, const unsigned int &numEqualities, unsigned int &numActive, const int &index);
+		
+		/**
+		 * Solve min 0.5*(xd - x)'*W*(xd - x) subject to A*x = y and inequality constraints using
+		 * the primal, dual, or null space method. The solution is stored in ws.x.tail(n) for the
+		 * primal method, and leastSquares.xr for the dual and null space methods.
+		 * @param constraints Either LinearConstraints or BoundConstraints.
+		 * @param ws The memory used to solve the problem.
+		 * @param ns The memory used by the null space method.
+		 * @param factorised True if ws and ns already hold the decompositions of W and A.
+		 */
+		template <int Cons, class Constraints>
+		void
+		redundant_interior_point(const Vector<DataType,N>   &xd,
+		                         const Matrix<DataType,N,N> &W,
+		                         const Matrix<DataType,M,N> &A,
+		                         const Vector<DataType,M>   &y,
+		                         Constraints                &constraints,
+		                         const Vector<DataType,N>   &x0,
+		                         Workspace<MplusN,Cons>     &ws,
+		                         NullSpaceWorkspace<Cons>   &ns,
+		                         const bool                 &factorised = false);
+		
+		/**
+		 * Solve min 0.5*x'*H*x + x'*f subject to A*x = y and inequality constraints, either for
+		 * [lambda; x] with the KKT matrix or in the null space of A. The solution is stored in
+		 * ws.x.tail(n), or leastSquares.xr for the null space method.
+		 * @param constraints The inequality constraints.
+		 * @param ws The memory used to solve the problem.
+		 * @param ns The memory used by the null space method.
+		 */
+		template <int Cons, class Constraints>
+		void
+		equality_interior_point(const Matrix<DataType,N,N> &H,
+		                        const Vector<DataType,N>   &f,
+		                        const Matrix<DataType,M,N> &A,
+		                        const Vector<DataType,M>   &y,
+		                        Constraints                &constraints,
+		                        const Vector<DataType,N>   &x0,
+		                        Workspace<MplusN,Cons>     &ws,
+		                        NullSpaceWorkspace<Cons>   &ns);
+		
+		/**
+		 * Computes an orthonormal basis Z for the null space of A from the QR decomposition of A',
+		 * and maps the inequality constraints in to it, ns.B = B*Z.
+		 * @param constraints The inequality constraints.
+		 * @param ws Provides the memory for each column of B*Z.
+		 * @param ns Where the decomposition, Z and B*Z are stored.
+		 */
+		template <int Cons, class Constraints>
+		void null_space(const Matrix<DataType,M,N> &A,
+		                Constraints                &constraints,
+		                Workspace<MplusN,Cons>     &ws,
+		                NullSpaceWorkspace<Cons>   &ns);
+		
+};                                                                                                  // Required after class declaration
+
+  ////////////////////////////////////////////////////////////////////////////////////////////////////
+ //              Solve a standard QP problem of the form min 0.5*x'*H*x + x'*f                     //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation> inline
+Vector<DataType,N>
+QPSolver<DataType,N,C,M,Factorisation>::solve(const Matrix<DataType,N,N> &H,
+                                              const Vector<DataType,N>   &f)
+{
+	if(H.rows() != H.cols())
+	{
+		throw invalid_argument("[ERROR] [QP SOLVER] solve(): "
+		                       "Expected a square matrix for the Hessian H but it was "
+		                       + to_string(H.rows()) + "x" + to_string(H.cols()) + ".");
+	}
+	else if(H.rows() != f.rows())
+	{	
+		throw invalid_argument("[ERROR] [QP SOLVER] solve(): "
+		                       "Dimensions of arguments do not match. "
+		                       "The Hessian H was " + to_string(H.rows()) + "x" + to_string(H.cols()) +
+		                       " and the f vector was " + to_string(f.size()) + "x1.");
+	}
+	else 	return Factorisation<Matrix<DataType,N,N>>(H).solve(-f);                            // Too easy lol ᕙ(▀̿̿ĺ̯̿̿▀̿ ̿) ᕗ
+}
+
+  ////////////////////////////////////////////////////////////////////////////////////////////////////
+ //           Solve an unconstrained least squares problem: min 0.5(y-A*x)'*W*(y-A*x)              //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation> inline
+Vector<DataType,N>
+QPSolver<DataType,N,C,M,Factorisation>::least_squares(const Vector<DataType,M>   &y,
+                                                      const Matrix<DataType,M,N> &A,
+                                                      const Matrix<DataType,M,M> &W)
+{
+	if(A.rows() < A.cols())                                                                     // Redundant system, use other function
+	{
+		throw invalid_argument("[ERROR] [QP SOLVER] least_squares(): "
+		                       "The A matrix has more rows than columns ("
+		                       + to_string(A.rows()) + "x" + to_string(A.cols()) + "). "
+		                       "Did you mean to call redundant_least_squares()?");	                    		                   
+	}
+	if(W.rows() != W.cols())
+	{
+		throw invalid_argument("[ERROR] [QP SOLVER] least_squares(): "
+		                       "Expected a square weighting matrix W but it was "
+		                       + to_string(W.rows()) + "x" + to_string(W.cols()) + ".");
+	}
+	else if(y.rows() != W.rows() and W.cols() != A.rows())
+	{
+		throw invalid_argument("[ERROR] [QP SOLVER] least_squares(): "
+		                       "Dimensions of input arguments do not match. "
+		                       "The y vector was " + to_string(y.size()) + "x1, "
+		                       "the A matrix had " + to_string(A.rows()) + " rows, and "
+		                       "the weighting matrix W was " + to_string(W.rows()) + "x" + to_string(W.cols()) + ".");
+	}
+	else	return Factorisation<Matrix<DataType,N,N>>(A.transpose()*W*A).solve(A.transpose()*W*y); // x = (A'*W*A)^-1*A'*W*y
+}
+
+  ////////////////////////////////////////////////////////////////////////////////////////////////////
+ //    Solve least squares problem of the form min 0.5*(xd - x)'*W*(xd - x) subject to: A*x = y    //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation> inline
+Vector<DataType,N>
+QPSolver<DataType,N,C,M,Factorisation>::redundant_least_squares(const Vector<DataType,N>   &xd,
+                                                                const Matrix<DataType,N,N> &W,
+                                                                const Matrix<DataType,M,N> &A,
+                                                                const Vector<DataType,M>   &y)
+{
+	if(A.rows() >= A.cols())
+	{
+		throw invalid_argument("[ERROR] [QP SOLVER] redundant_least_squares(): "
+		                       "The equality constraint matrix has more rows than columns ("
+		                       + to_string(A.rows()) + " >= " + to_string(A.cols()) + "). "
+		                       "Did you mean to call the other least squares function?");
+	}
+	else if(W.rows() != W.cols())
+	{
+		throw invalid_argument("[ERROR] [QP SOLVER] redundant_least_squares(): "
+		                       "Expected the weighting matrix to be square but it was "
+		                       + to_string(W.rows()) + "x" + to_string(W.cols()) + ".");
+	}
+	else if(xd.size() != W.rows() or W.cols() != A.cols())
+	{	
+		throw invalid_argument("[ERROR] [QP SOLVER] redundant_least_squares(): "
+		                       "Dimensions for the decision variable do not match. "
+		                       "The desired vector had " + to_string(xd.size()) + " elements, "
+		                       "the weighting matrix was " + to_string(W.rows()) + "x" + to_string(W.cols()) + ", and "
+		                       "the constraint matrix had " + to_string(A.cols()) + " columns.");
+        }
+        else if(y.size() != A.rows())
+        {    	
+        	throw invalid_argument("[ERROR] [QP SOLVER] redundant_least_squares(): "
+        	                       "Dimensions for the equality constraint do not match. "
+        	                       "The constraint vector had " + to_string(y.size()) + " elements, and "
+        	                       "the constraint matrix had " + to_string(A.rows()) + " rows.");
+        }
+        else
+        {   		
+		Matrix<DataType,N,M> invWA = Factorisation<Matrix<DataType,N,N>>(W).solve(A.transpose()); // Makes calcs a little easier
+		
+		return xd + invWA*Factorisation<Matrix<DataType,M,M>>(A*invWA).solve(y - A*xd);     // xd + W^-1*A'*(A*W^-1*A')^-1*(y-A*xd)
+	}
+}
+
+  ////////////////////////////////////////////////////////////////////////////////////////////////////
+ //      Solve a constrained problem: min 0.5*(y - A*x)'*W*(y - A*x) s.t. xMin <= x <= xMax        //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation> inline
+Vector<DataType,N>
+QPSolver<DataType,N,C,M,Factorisation>::constrained_least_squares(const Vector<DataType,M>   &y,
+                                                                  const Matrix<DataType,M,N> &A,
+                                                                  const Matrix<DataType,M,M> &W,
+                                                                  const Vector<DataType,N>   &xMin,
+                                                                  const Vector<DataType,N>   &xMax,
+                                                                  const Vector<DataType,N>   &x0)
+{
+	// Ensure that the input arguments are sound.
+	if(y.size() != A.rows() or A.rows() != W.rows())
+	{
+		throw invalid_argument("[ERROR] [QP SOLVER] constrained_least_squares(): "
+		                       "Dimensions of the linear equation do not match. "
+		                       "The y vector had " + to_string(y.size()) + " elements, "
+		                       "the A matrix had " + to_string(A.rows()) + " rows, and "
+		                       "the weighting matrix W had " + to_string(W.rows()) + " rows.");
+	}
+	else if(W.rows() != W.cols())
+	{
+		throw invalid_argument("[ERROR] [QP SOLVER] constrained_least_squares(): "
+		                       "Expected the weighting matrix W to be square, but it was "
+		                       + to_string(W.rows()) + "x" + to_string(W.cols()) + ".");
+	}
+	else if(A.cols() != xMin.size() or xMin.size() != xMax.size() or xMax.size() != x0.size())
+	{
+		throw invalid_argument("[ERROR] [QP SOLVER] constrained_least_squares(): "
+		                       "Dimensions for decision variable do not match. "
+		                       "The A matrix had " + to_string(A.cols()) + " columns, "
+		                       "the xMin argument had " + to_string(xMin.size()) + " elements, "
+		                       "the xMax argument had " + to_string(xMax.size()) + " elements, and "
+		                       "the start point x0 had " + to_string(x0.size()) + " elements.");
+	}
+	
+	// Solve with the interior point algorithm, using the bounds directly
+	{
+		MallocGuard guard(not reuse_workspace(boundedLeastSquares, A.cols(), A.rows(), 2*A.cols()));
+		
+		Workspace<N,twoN> &ws = this->boundsWorkspace;                                      // Makes the code easier to read
+		
+		BoundConstraints constraints(xMin, xMax);
+		
+		this->leastSquares.AtW.noalias() = A.transpose()*W;                                 // Makes calcs a tiny bit faster
+		ws.H.noalias() = this->leastSquares.AtW*A;
+		ws.f.noalias() = -this->leastSquares.AtW*y;
+		
+		if(this->algorithm == activeSetMethod)
+		{
+			active_set_method(ws.H, ws.f, NoEqualities(), constraints, ws);
+			
+			ws.x = ws.activeSet.x;
+		}
+		else interior_point(ws.H, ws.f, constraints, x0, ws);                               // Send to interior point algorithm and solve
+	}
+	
+	this->lastSolution = this->boundsWorkspace.x;
+	
+	return this->lastSolution;
+}
+
+  ////////////////////////////////////////////////////////////////////////////////////////////////////
+ //    Solve a constrained problem min 0.5*(xd - x)'*W*(xd - x) s.t. A*x = y, xMin <= x <= xMax    //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation> inline
+Vector<DataType,N>
+QPSolver<DataType,N,C,M,Factorisation>::constrained_least_squares(const Vector<DataType,N>   &xd,
+                                                                  const Matrix<DataType,N,N> &W,
+                                                                  const Matrix<DataType,M,N> &A,
+                                                                  const Vector<DataType,M>   &y,
+                                                                  const Vector<DataType,N>   &xMin,
+                                                                  const Vector<DataType,N>   &xMax,
+                                                                  const Vector<DataType,N>   &x0)
+{
+	// Ensure input arguments are sound
+	if(xd.size() != W.rows() or W.rows() != A.cols() or A.cols() != xMin.size() or xMin.size() != xMax.size() or xMax.size() != x0.size())
+	{
+		throw invalid_argument("[ERROR] [QP SOLVER] constrained_least_squares(): "
+		                       "Dimensions for decision variable do not match. "
+		                       "The desired value xd had " + to_string(xd.size()) + " elements, "
+		                       "the weighting matrix W had " + to_string(W.rows()) + " rows, "
+		                       "the equality constraint matrix A had " + to_string(A.cols()) + " columns, "
+		                       "the xMin argument had " + to_string(xMin.size()) + " elements, "
+		                       "the xMax argument had " + to_string(xMax.size()) + " elements, and "
+		                       "the start point x0 had " + to_string(x0.size()) + " elements.");
+	}
+	else if(W.rows() != W.cols())
+	{
+		throw invalid_argument("[ERROR] [QP SOLVER] constrained_least_squares(): "
+		                       "Expected the weighting matrix W to be square, but it was "
+		                       + to_string(W.rows()) + "x" + to_string(W.cols()) + ".");
+	}
+	else if(A.rows() != y.size())
+	{
+		throw invalid_argument("[ERROR] [QP SOLVER] constrained_least_squares(): "
+		                       "Dimensions for equality constraint do not match. "
+		                       "The equality constraint matrix A had " + to_string(A.rows()) + " rows, and "
+		                       "the equality constraint vector y had " + to_string(y.size()) + " elements.");
+	}
+	
+	{
+		Call call = (this->method == primal) ? redundantBoundsPrimal
+		          : (this->method == dual)   ? redundantBoundsDual : redundantBoundsNullSpace;
+		
+		MallocGuard guard(not reuse_workspace(call, A.cols(), A.rows(), 2*A.cols()));
+		
+		BoundConstraints constraints(xMin, xMax);                                           // No need to form B = [I; -I]
+		
+		redundant_interior_point(xd, W, A, y, constraints, x0, this->redundantBoundsWorkspace, this->nullSpaceBoundsWorkspace);
+	}
+	
+	if(this->method == primal or this->algorithm == activeSetMethod)
+	{
+		this->lastSolution = this->redundantBoundsWorkspace.x.tail(A.cols());               // We don't need the Lagrange multipliers
+	}
+	else this->lastSolution = this->leastSquares.xr;
+	
+	return this->lastSolution;
+}
+
+  ////////////////////////////////////////////////////////////////////////////////////////////////////
+ //        Solve a constrained problem min 0.5*(xd - x)'*W*(xd - x) s.t. A*x = y, B*x < z          //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation> inline
+Vector<DataType,N>
+QPSolver<DataType,N,C,M,Factorisation>::constrained_least_squares(const Vector<DataType,N>   &xd,
+                                                                  const Matrix<DataType,N,N> &W,
+                                                                  const Matrix<DataType,M,N> &A,
+                                                                  const Vector<DataType,M>   &y,
+                                                                  const Matrix<DataType,C,N> &B,
+                                                                  const Vector<DataType,C>   &z,
+                                                                  const Vector<DataType,N>   &x0)
+{
+	// Ensure input arguments are sound
+	if(xd.size() != W.rows() or W.rows() != A.cols() or A.cols() != B.cols() or B.cols() != x0.size())
+	{
+		throw invalid_argument("[ERROR] [QP SOLVER] constrained_least_squares(): "
+		                       "Dimensions for decision variable do not match. "
+		                       "The desired value xd had " + to_string(xd.size()) + " elements, "
+		                       "the weighting matrix W had " + to_string(W.rows()) + " rows, "
+		                       "the equality constraint matrix A had " + to_string(A.cols()) + " columns, "
+		                       "the inequality constraint matrix B had " + to_string(B.cols()) + " columns, and "
+		                       "the start point x0 had " + to_string(x0.size()) + " elements.");
+	}
+	else if(W.rows() != W.cols())
+	{
+		throw invalid_argument("[ERROR] [QP SOLVER] constrained_least_squares(): "
+		                       "Expected the weighting matrix W to be square, but it was "
+		                       + to_string(W.rows()) + "x" + to_string(W.cols()) + ".");
+	}
+	else if(A.rows() != y.size())
+	{
+		throw invalid_argument("[ERROR] [QP SOLVER] constrained_least_squares(): "
+		                       "Dimensions for equality constraint do not match. "
+		                       "The equality constraint matrix A had " + to_string(A.rows()) + " rows, and "
+		                       "the equality constraint vector y had " + to_string(y.size()) + " elements.");
+	}
+	else if(B.rows() != z.rows())
+	{
+		throw invalid_argument("[ERROR] [QP SOLVER] constrained_least_squared(): "
+		                       "Dimensions for inequality constraint do no match. "
+		                       "The inequality constraint matrix B had " + to_string(B.rows()) + " rows, and "
+		                       "the inequality constraint vector z had " + to_string(z.size()) + " elements.");
+	}
+	
+	{
+		Call call = (this->method == primal) ? redundantPrimal
+		          : (this->method == dual)   ? redundantDual : redundantNullSpace;
+		
+		MallocGuard guard(not reuse_workspace(call, A.cols(), A.rows(), B.rows()));
+		
+		LinearConstraints<> constraints(B, z, this->redundantWorkspace.Bw, this);
+		
+		redundant_interior_point(xd, W, A, y, constraints, x0, this->redundantWorkspace, this->nullSpaceWorkspace);
+	}
+	
+	if(this->method == primal or this->algorithm == activeSetMethod)
+	{
+		this->lastSolution = this->redundantWorkspace.x.tail(A.cols());                     // We don't need the Lagrange multipliers
+	}
+	else this->lastSolution = this->leastSquares.xr;
+	
+	return this->lastSolution;
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //          Solve a problem of the form: min 0.5*x'*H*x + x'*f subject to: B*x <= z              //        
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation> inline
+Vector<DataType,N>
+QPSolver<DataType,N,C,M,Factorisation>::solve(const Matrix<DataType,N,N> &H,
+                                              const Vector<DataType,N>   &f,
+                                              const Matrix<DataType,C,N> &B,
+                                              const Vector<DataType,C>   &z,
+                                              const Vector<DataType,N>   &x0)
+{
+	// Ensure arguments are sound
+	if(H.rows() != H.cols())
+	{
+		throw invalid_argument("[ERROR] [QP SOLVER] solve(): "
+		                       "Expected the Hessian matrix H to be square but it was " 
+		                       + to_string(H.rows()) + "x" + to_string(H.cols()) + ".");
+	}
+	else if(H.cols() != f.size() or f.size() != B.cols() or B.cols() != x0.size())
+	{
+		throw invalid_argument("[ERROR] [QP SOLVER] solve(): "
+		                       "Dimensions of arguments for decision variable do not match. "
+		                       "The Hessian matrix had " + to_string(H.cols()) + " rows/columns, "
+		                       "the vector f had " + to_string(f.size()) + " elements, "
+		                       "the inequality constraint matrix B had " + to_string(B.cols()) + " columns, and "
+		                       "the start point x0 had " + to_string(x0.size()) + " elements.");
+	}
+	else if(B.rows() != z.size())
+	{
+		throw invalid_argument("[ERROR] [QP SOLVER] solve(): "
+		                       "Dimensions for inequality constraint do not match. "
+		                       "The inequality constraint matrix B had " + to_string(B.rows()) + " rows, and "
+		                       "the inequality constraint vector z had " + to_string(z.size()) + " elements.");
+	}
+	
+	{
+		MallocGuard guard(not reuse_workspace(generic, H.rows(), 0, B.rows()));
+		
+		LinearConstraints<> constraints(B, z, this->genericWorkspace.Bw, this);
+		
+		if(this->algorithm == activeSetMethod)
+		{
+			active_set_method(H, f, NoEqualities(), constraints, this->genericWorkspace);
+			
+			this->genericWorkspace.x = this->genericWorkspace.activeSet.x;
+		}
+		else interior_point(H, f, constraints, x0, this->genericWorkspace);
+	}
+	
+	this->lastSolution = this->genericWorkspace.x;
+	
+	return this->lastSolution;
+}
+
+  ////////////////////////////////////////////////////////////////////////////////////////////////////
+ //       Solve a problem of the form: min 0.5*x'*H*x + x'*f subject to: A*x = y, B*x <= z        //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation> inline
+Vector<DataType,N>
+QPSolver<DataType,N,C,M,Factorisation>::solve(const Matrix<DataType,N,N> &H,
+                                              const Vector<DataType,N>   &f,
+                                              const Matrix<DataType,M,N> &A,
+                                              const Vector<DataType,M>   &y,
+                                              const Matrix<DataType,C,N> &B,
+                                              const Vector<DataType,C>   &z,
+                                              const Vector<DataType,N>   &x0)
+{
+	// Ensure arguments are sound
+	if(H.rows() != H.cols())
+	{
+		throw invalid_argument("[ERROR] [QP SOLVER] solve(): "
+		                       "Expected the Hessian matrix H to be square but it was "
+		                       + to_string(H.rows()) + "x" + to_string(H.cols()) + ".");
+	}
+	else if(H.cols() != f.size() or f.size() != A.cols() or A.cols() != B.cols() or B.cols() != x0.size())
+	{
+		throw invalid_argument("[ERROR] [QP SOLVER] solve(): "
+		                       "Dimensions of arguments for decision variable do not match. "
+		                       "The Hessian matrix had " + to_string(H.cols()) + " rows/columns, "
+		                       "the vector f had " + to_string(f.size()) + " elements, "
+		                       "the equality constraint matrix A had " + to_string(A.cols()) + " columns, "
+		                       "the inequality constraint matrix B had " + to_string(B.cols()) + " columns, and "
+		                       "the start point x0 had " + to_string(x0.size()) + " elements.");
+	}
+	else if(A.rows() != y.size())
+	{
+		throw invalid_argument("[ERROR] [QP SOLVER] solve(): "
+		                       "Dimensions for equality constraint do not match. "
+		                       "The equality constraint matrix A had " + to_string(A.rows()) + " rows, and "
+		                       "the equality constraint vector y had " + to_string(y.size()) + " elements.");
+	}
+	else if(B.rows() != z.size())
+	{
+		throw invalid_argument("[ERROR] [QP SOLVER] solve(): "
+		                       "Dimensions for inequality constraint do not match. "
+		                       "The inequality constraint matrix B had " + to_string(B.rows()) + " rows, and "
+		                       "the inequality constraint vector z had " + to_string(z.size()) + " elements.");
+	}
+	
+	{
+		Call call = (this->method == nullSpace) ? equalityNullSpace : equalityPrimal;
+		
+		MallocGuard guard(not reuse_workspace(call, A.cols(), A.rows(), B.rows()));
+		
+		LinearConstraints<> constraints(B, z, this->redundantWorkspace.Bw, this);
+		
+		equality_interior_point(H, f, A, y, constraints, x0, this->redundantWorkspace, this->nullSpaceWorkspace);
+	}
+	
+	if(this->method == nullSpace and this->algorithm != activeSetMethod)
+	{
+		this->lastSolution = this->leastSquares.xr;
+	}
+	else this->lastSolution = this->redundantWorkspace.x.tail(A.cols());                        // We don't need the Lagrange multipliers
+	
+	return this->lastSolution;
+}
+
+  ////////////////////////////////////////////////////////////////////////////////////////////////////
+ //       Solve min 0.5*x'*H*x + x'*f subject to B*x <= z where H and B are sparse matrices        //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation> inline
+Vector<DataType,N>
+QPSolver<DataType,N,C,M,Factorisation>::solve(const SparseMatrix<DataType>   &H,
+                                              const Vector<DataType,Dynamic> &f,
+                                              const SparseMatrix<DataType>   &B,
+                                              const Vector<DataType,Dynamic> &z,
+                                              const Vector<DataType,Dynamic> &x0)
+{
+	// Ensure arguments are sound
+	if(H.rows() != H.cols())
+	{
+		throw invalid_argument("[ERROR] [QP SOLVER] solve(): "
+		                       "Expected the Hessian matrix H to be square but it was "
+		                       + to_string(H.rows()) + "x" + to_string(H.cols()) + ".");
+	}
+	else if(H.cols() != f.size() or f.size() != B.cols() or B.cols() != x0.size())
+	{
+		throw invalid_argument("[ERROR] [QP SOLVER] solve(): "
+		                       "Dimensions of arguments for decision variable do not match. "
+		                       "The Hessian matrix had " + to_string(H.cols()) + " rows/columns, "
+		                       "the vector f had " + to_string(f.size()) + " elements, "
+		                       "the inequality constraint matrix B had " + to_string(B.cols()) + " columns, and "
+		                       "the start point x0 had " + to_string(x0.size()) + " elements.");
+	}
+	else if(B.rows() != z.size())
+	{
+		throw invalid_argument("[ERROR] [QP SOLVER] solve(): "
+		                       "Dimensions for inequality constraint do not match. "
+		                       "The inequality constraint matrix B had " + to_string(B.rows()) + " rows, and "
+		                       "the inequality constraint vector z had " + to_string(z.size()) + " elements.");
+	}
+	
+	if(this->algorithm == activeSetMethod)
+	{
+		return solve(Matrix<DataType,N,N>(H), f, Matrix<DataType,C,N>(B), z, x0);           // The active set method is dense
+	}
+	
+	{
+		MallocGuard guard(true);                                                            // Sparse matrix products always allocate
+		
+		SparseLinearConstraints constraints(B, z);
+		
+		interior_point(H, f, constraints, x0, this->sparseWorkspace);
+	}
+	
+	this->lastSolution = this->sparseWorkspace.x;
+	
+	return this->lastSolution;
+}
+
+  ////////////////////////////////////////////////////////////////////////////////////////////////////
+ // Solve min 0.5*(xd - x)'*W*(xd - x) s.t. A*x = y, B*x < z where W, A and B are sparse matrices  //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation> inline
+Vector<DataType,N>
+QPSolver<DataType,N,C,M,Factorisation>::constrained_least_squares(const Vector<DataType,Dynamic> &xd,
+                                                                  const SparseMatrix<DataType>   &W,
+                                                                  const SparseMatrix<DataType>   &A,
+                                                                  const Vector<DataType,Dynamic> &y,
+                                                                  const SparseMatrix<DataType>   &B,
+                                                                  const Vector<DataType,Dynamic> &z,
+                                                                  const Vector<DataType,Dynamic> &x0)
+{
+	// Ensure input arguments are sound
+	if(xd.size() != W.rows() or W.rows() != A.cols() or A.cols() != B.cols() or B.cols() != x0.size())
+	{
+		throw invalid_argument("[ERROR] [QP SOLVER] constrained_least_squares(): "
+		                       "Dimensions for decision variable do not match. "
+		                       "The desired value xd had " + to_string(xd.size()) + " elements, "
+		                       "the weighting matrix W had " + to_string(W.rows()) + " rows, "
+		                       "the equality constraint matrix A had " + to_string(A.cols()) + " columns, "
+		                       "the inequality constraint matrix B had " + to_string(B.cols()) + " columns, and "
+		                       "the start point x0 had " + to_string(x0.size()) + " elements.");
+	}
+	else if(W.rows() != W.cols())
+	{
+		throw invalid_argument("[ERROR] [QP SOLVER] constrained_least_squares(): "
+		                       "Expected the weighting matrix W to be square, but it was "
+		                       + to_string(W.rows()) + "x" + to_string(W.cols()) + ".");
+	}
+	else if(A.rows() != y.size())
+	{
+		throw invalid_argument("[ERROR] [QP SOLVER] constrained_least_squares(): "
+		                       "Dimensions for equality constraint do not match. "
+		                       "The equality constraint matrix A had " + to_string(A.rows()) + " rows, and "
+		                       "the equality constraint vector y had " + to_string(y.size()) + " elements.");
+	}
+	else if(B.rows() != z.rows())
+	{
+		throw invalid_argument("[ERROR] [QP SOLVER] constrained_least_squares(): "
+		                       "Dimensions for inequality constraint do no match. "
+		                       "The inequality constraint matrix B had " + to_string(B.rows()) + " rows, and "
+		                       "the inequality constraint vector z had " + to_string(z.size()) + " elements.");
+	}
+	
+	if(this->algorithm == activeSetMethod)
+	{
+		return constrained_least_squares(xd, Matrix<DataType,N,N>(W), Matrix<DataType,M,N>(A), y,
+		                                 Matrix<DataType,C,N>(B), z, x0);                   // The active set method is dense
+	}
+	
+	Workspace<Dynamic,Dynamic,SparseMatrix<DataType>> &ws = this->sparseRedundantWorkspace;     // Makes the code easier to read
+	
+	unsigned int m = A.rows();                                                                  // Number of equality constraints
+	unsigned int n = A.cols();                                                                  // Decision variable
+	
+	{
+		MallocGuard guard(true);                                                            // Sparse matrix products always allocate
+		
+		// H = [  0  -A ]
+		//     [ -A'  W ]
+		std::vector<Triplet<DataType>> triplets;
+		triplets.reserve(2*A.nonZeros() + W.nonZeros());
+		add_triplets(-A, 0, m, triplets);
+		add_triplets(-A.transpose(), m, 0, triplets);
+		add_triplets(W, m, m, triplets);
+		ws.H.resize(m+n,m+n);
+		ws.H.setFromTriplets(triplets.begin(), triplets.end());
+		
+		// f = [    y  ]
+		//     [ -W*xd ]
+		ws.f.resize(m+n);
+		ws.f.head(m) = y;
+		ws.f.tail(n).noalias() = -W*xd;
+		
+		// new_x0 = [ 0  ]
+		//          [ x0 ]
+		ws.x0.resize(m+n);
+		ws.x0.head(m).setZero();                                                            // The first Newton step solves for the multipliers
+		ws.x0.tail(n) = x0;
+		
+		// Bpadded = [ 0  B ]
+		triplets.clear();
+		add_triplets(B, 0, m, triplets);
+		SparseMatrix<DataType> Bpadded(B.rows(), m+n);
+		Bpadded.setFromTriplets(triplets.begin(), triplets.end());
+		
+		SparseLinearConstraints constraints(Bpadded, z);
+		constraints.start = m;                                                              // Constraints act on x, not the Lagrange multipliers
+		
+		interior_point(ws.H, ws.f, constraints, ws.x0, ws);                                 // Solution is [lambda; x]
+	}
+	
+	this->lastSolution = ws.x.tail(n);                                                          // We don't need the Lagrange multipliers
+	
+	return this->lastSolution;
+}
+
+  ////////////////////////////////////////////////////////////////////////////////////////////////////
+ //    Solve min 0.5*(xd - x)'*W*(xd - x) s.t. A*x = y and inequality constraints (primal/dual)    //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+template <int Cons, class Constraints> inline
+void
+QPSolver<DataType,N,C,M,Factorisation>::redundant_interior_point(const Vector<DataType,N>   &xd,
+                                                                 const Matrix<DataType,N,N> &W,
+                                                                 const Matrix<DataType,M,N> &A,
+                                                                 const Vector<DataType,M>   &y,
+                                                                 Constraints                &constraints,
+                                                                 const Vector<DataType,N>   &x0,
+                                                                 Workspace<MplusN,Cons>     &ws,
+                                                                 NullSpaceWorkspace<Cons>   &ns,
+                                                                 const bool                 &factorised)
+{
+	LeastSquaresWorkspace &ls = this->leastSquares;                                             // Makes the code easier to read
+	
+	unsigned int m = A.rows();                                                                  // Number of equality constraints
+	unsigned int n = A.cols();                                                                  // Decision variable
+	
+	if(this->algorithm == activeSetMethod)
+	{
+		// The active set method handles A*x = y directly, so we don't need the primal or dual form
+		ws.activeSet.f.noalias() = -W*xd;
+		
+		active_set_method(W, ws.activeSet.f, LinearEqualities(A, y), constraints, ws, factorised);
+		
+		// x = [ lambda ]
+		//     [   x    ]
+		ws.x.resize(m+n);
+		ws.x.head(m) = ws.activeSet.u.head(m);                                              // Multipliers of the equality constraints
+		ws.x.tail(n) = ws.activeSet.x;
+		
+		return;
+	}
+	
+	this->lastStatus = solved;                                                                  // The dual method doesn't check
+	
+	// lambda = (A*W^-1*A')^-1*(y - A*xd)
+	if(not factorised)
+	{
+		ls.Wdecomp.compute(W);
+		ls.invWAt = ls.Wdecomp.solve(A.transpose());                                        // Makes calcs a little easier
+		ls.AinvWAt.noalias() = A*ls.invWAt;
+		ls.AinvWAtdecomp.compute(ls.AinvWAt);                                               // Saves a bit of time
+	}
+	
+	if(this->method == primal)
+	{	
+		// H = [  0  -A ]
+		//     [ -A'  W ]
+		if(not factorised)
+		{
+			ws.H.resize(m+n,m+n);
+			ws.H.block(0,0,m,m).setZero();
+			ws.H.block(0,m,m,n) = -A;
+			ws.H.block(m,0,n,m) = -A.transpose();
+			ws.H.block(m,m,n,n) = W;
+		}
+		
+		// f = [    y  ]
+		//     [ -W*xd ]
+		ws.f.resize(m+n);
+		ws.f.head(m) = y;
+		ws.f.tail(n).noalias() = -W*xd;
+		
+		// new_x0 = [ lambda ]
+		//          [   x0   ]
+		ls.r = y;
+		ls.r.noalias() -= A*xd;
+		ws.x0.resize(m+n);
+		ws.x0.head(m) = ls.AinvWAtdecomp.solve(ls.r);                                       // Initial guess for Lagrange multipliers
+		ws.x0.tail(n) = x0;
+		
+		constraints.start = m;                                                              // Constraints act on x, not the Lagrange multipliers
+		
+		interior_point(ws.H,ws.f,constraints,ws.x0,ws);                                     // Solution is [lambda; x]
+	}
+	else if(this->method == dual)
+	{
+		// x = xd + W^-1*A'*lambda
+		
+		ls.lambda = ls.AinvWAtdecomp.solve(y);
+		ls.xr.noalias() = ls.invWAt*ls.lambda;                                              // Solve the range space
+		
+		ls.r.noalias() = A*xd;
+		ls.lambda = ls.AinvWAtdecomp.solve(ls.r);
+		ls.xn = xd;
+		ls.xn.noalias() -= ls.invWAt*ls.lambda;                                             // Compute null space component
+		
+		unsigned int c = constraints.size();
+		ws.w.resize(c);
+		ws.Bdx.resize(c);
+		ws.d.resize(c);
+		constraints.multiply(ls.xr, ws.Bdx);
+		constraints.multiply(ls.xn, ws.w);
+		constraints.distance(ls.xr, ws.d);
+		ws.d -= ws.w;                                                                       // Distance for x = xr + xn
+		
+		DataType alpha = 1.0;
+		for(int i = 0; i < c; i++)
+		{
+			if(ws.d(i) <= 0) alpha = min(alpha, 0.99*abs((ws.d(i) - ws.Bdx(i))/ws.w(i)));
+		}
+		
+		ls.xr += alpha*ls.xn;                                                               // Solution is stored here
+		
+		this->converged = false;                                                            // Feasible, but not optimal in general
+	}
+	else if(this->method == nullSpace)
+	{
+		// x = xp + Z*v, where A*xp = y and A*Z = 0, so the problem becomes
+		// min 0.5*v'*(Z'*W*Z)*v subject to (B*Z)*v <= z - B*xp
+		// There is no linear term since xp is the minimum subject to A*x = y.
+		
+		if(m >= n)
+		{
+			throw invalid_argument("[ERROR] [QP SOLVER] constrained_least_squares(): "
+			                       "The null space method needs fewer equality constraints than variables, "
+			                       "but there were " + to_string(m) + " constraints and " + to_string(n) + " variables.");
+		}
+		
+		unsigned int r = n - m;                                                             // Dimension of the null space
+		unsigned int c = constraints.size();
+		
+		// xp = xd + W^-1*A'*(A*W^-1*A')^-1*(y - A*xd)
+		ls.r = y;
+		ls.r.noalias() -= A*xd;
+		ls.lambda = ls.AinvWAtdecomp.solve(ls.r);
+		ns.xp = xd;
+		ns.xp.noalias() += ls.invWAt*ls.lambda;
+		
+		if(not factorised)
+		{
+			null_space(A, constraints, ws, ns);
+			
+			ns.WZ.noalias() = W*ns.Z;
+			ns.reduced.H.noalias() = ns.Z.transpose()*ns.WZ;
+			ns.reduced.f.setZero(r);
+		}
+		
+		ls.xn = x0 - ns.xp;
+		ns.reduced.x0.noalias() = ns.Z.transpose()*ls.xn;                                   // Closest point to x0
+		
+		ns.z.resize(c);
+		constraints.distance(ns.xp, ns.z);
+		
+		LinearConstraints<Cons,Dynamic> reducedConstraints(ns.B, ns.z, ns.Bw, this);
+		
+		interior_point(ns.reduced.H, ns.reduced.f, reducedConstraints, ns.reduced.x0, ns.reduced);
+		
+		ls.xr = ns.xp;
+		ls.xr.noalias() += ns.Z*ns.reduced.x;                                               // Solution is stored here
+	}
+	else
+	{
+		throw runtime_error("[ERROR] [QP SOLVER] constrained_least_squares(): "
+		                    "Method for solving redundant least squares was neither 'dual' "
+		                    "nor 'primal'. How did that happen?");
+	}
+}
+
+  ////////////////////////////////////////////////////////////////////////////////////////////////////
+ //     Solve min 0.5*x'*H*x + x'*f s.t. A*x = y and inequality constraints (KKT/null space)      //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+template <int Cons, class Constraints> inline
+void
+QPSolver<DataType,N,C,M,Factorisation>::equality_interior_point(const Matrix<DataType,N,N> &H,
+                                                                const Vector<DataType,N>   &f,
+                                                                const Matrix<DataType,M,N> &A,
+                                                                const Vector<DataType,M>   &y,
+                                                                Constraints                &constraints,
+                                                                const Vector<DataType,N>   &x0,
+                                                                Workspace<MplusN,Cons>     &ws,
+                                                                NullSpaceWorkspace<Cons>   &ns)
+{
+	LeastSquaresWorkspace &ls = this->leastSquares;                                             // Makes the code easier to read
+	
+	unsigned int m = A.rows();                                                                  // Number of equality constraints
+	unsigned int n = A.cols();                                                                  // Decision variable
+	
+	if(this->algorithm == activeSetMethod)
+	{
+		active_set_method(H, f, LinearEqualities(A, y), constraints, ws);
+		
+		// x = [ lambda ]
+		//     [   x    ]
+		ws.x.resize(m+n);
+		ws.x.head(m) = ws.activeSet.u.head(m);                                              // Multipliers of the equality constraints
+		ws.x.tail(n) = ws.activeSet.x;
+		
+		return;
+	}
+	
+	if(this->method == nullSpace)
+	{
+		// x = xp + Z*v, where A*xp = y and A*Z = 0, so the problem becomes
+		// min 0.5*v'*(Z'*H*Z)*v + v'*Z'*(H*xp + f) subject to (B*Z)*v <= z - B*xp
+		
+		if(m >= n)
+		{
+			throw invalid_argument("[ERROR] [QP SOLVER] solve(): "
+			                       "The null space method needs fewer equality constraints than variables, "
+			                       "but there were " + to_string(m) + " constraints and " + to_string(n) + " variables.");
+		}
+		
+		null_space(A, constraints, ws, ns);
+		
+		// A' = Q*[R; 0], so xp = Q*[R'^-1*y; 0] is the smallest x with A*x = y
+		ns.xp.setZero(n);
+		ns.xp.head(m) = y;
+		ns.qr.matrixQR().topLeftCorner(m,m).template triangularView<Upper>().transpose().solveInPlace(ns.xp.head(m));
+		ns.qr.householderQ().applyThisOnTheLeft(ns.xp, ns.householder);
+		
+		ns.WZ.noalias() = H*ns.Z;
+		ns.reduced.H.noalias() = ns.Z.transpose()*ns.WZ;
+		ns.column = f;
+		ns.column.noalias() += H*ns.xp;
+		ns.reduced.f.noalias() = ns.Z.transpose()*ns.column;
+		
+		ls.xn = x0 - ns.xp;
+		ns.reduced.x0.noalias() = ns.Z.transpose()*ls.xn;                                   // Closest point to x0
+		
+		ns.z.resize(constraints.size());
+		constraints.distance(ns.xp, ns.z);
+		
+		LinearConstraints<Cons,Dynamic> reducedConstraints(ns.B, ns.z, ns.Bw, this);
+		
+		interior_point(ns.reduced.H, ns.reduced.f, reducedConstraints, ns.reduced.x0, ns.reduced);
+		
+		ls.xr = ns.xp;
+		ls.xr.noalias() += ns.Z*ns.reduced.x;                                               // Solution is stored here
+	}
+	else
+	{
+		// H = [  0  -A ]
+		//     [ -A'  H ]
+		ws.H.resize(m+n,m+n);
+		ws.H.block(0,0,m,m).setZero();
+		ws.H.block(0,m,m,n) = -A;
+		ws.H.block(m,0,n,m) = -A.transpose();
+		ws.H.block(m,m,n,n) = H;
+		
+		// f = [ y ]
+		//     [ f ]
+		ws.f.resize(m+n);
+		ws.f.head(m) = y;
+		ws.f.tail(n) = f;
+		
+		// A step that is cut short by an inequality constraint only reduces y - A*x by (1 - alpha),
+		// so first move x0 toward A*x = y by the smallest change, A'*(A*A')^-1*(y - A*x0).
+		// With A' = Q*[R; 0] this is Q*[R'^-1*(y - A*x0); 0].
+		ns.qr.compute(A.transpose());
+		ls.r = y;
+		ls.r.noalias() -= A*x0;
+		ns.xp.setZero(n);
+		ns.xp.head(m) = ls.r;
+		ns.qr.matrixQR().topLeftCorner(m,m).template triangularView<Upper>().transpose().solveInPlace(ns.xp.head(m));
+		ns.qr.householderQ().applyThisOnTheLeft(ns.xp, ns.householder);
+		
+		unsigned int c = constraints.size();
+		ws.d.resize(c);
+		ws.Bdx.resize(c);
+		constraints.distance(x0, ws.d);
+		constraints.multiply(ns.xp, ws.Bdx);
+		
+		DataType alpha = 1.0;
+		if((ws.d.array() > 0).all())                                                        // Otherwise phase I finds a start point
+		{
+			for(int i = 0; i < c; i++)
+			{
+				if(ws.Bdx(i) > 0) alpha = min(alpha, DataType(0.99)*ws.d(i)/ws.Bdx(i)); // Stay inside the constraints
+			}
+		}
+		
+		// new_x0 = [ lambda ]
+		//          [   x0   ]
+		ws.x0.resize(m+n);
+		ws.x0.head(m).setZero();                                                            // The first Newton step solves for them exactly
+		ws.x0.tail(n) = x0;
+		ws.x0.tail(n) += alpha*ns.xp;
+		
+		constraints.start = m;                                                              // Constraints act on x, not the Lagrange multipliers
+		
+		interior_point(ws.H,ws.f,constraints,ws.x0,ws);                                     // Solution is [lambda; x]
+	}
+}
+
+  ////////////////////////////////////////////////////////////////////////////////////////////////////
+ //       Find a basis for the null space of A and map the inequality constraints in to it        //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+template <int Cons, class Constraints> inline
+void QPSolver<DataType,N,C,M,Factorisation>::null_space(const Matrix<DataType,M,N> &A,
+                                                        Constraints                &constraints,
+                                                        Workspace<MplusN,Cons>     &ws,
+                                                        NullSpaceWorkspace<Cons>   &ns)
+{
+	unsigned int r = A.cols() - A.rows();                                                       // Dimension of the null space
+	unsigned int c = constraints.size();
+	
+	// A' = Q*R, and the last n - m columns of Q are orthogonal to the rows of A
+	ns.qr.compute(A.transpose());
+	ns.Z.setZero(A.cols(),r);
+	ns.Z.bottomRows(r).setIdentity();
+	ns.qr.householderQ().applyThisOnTheLeft(ns.Z, ns.householder);                              // Z = Q*[0; I] without forming Q
+	
+	// Map the constraints in to the null space
+	ns.B.resize(c,r);
+	ws.Bdx.resize(c);
+	for(int k = 0; k < r; k++)
+	{
+		ns.column = ns.Z.col(k);
+		constraints.multiply(ns.column, ws.Bdx);
+		ns.B.col(k) = ws.Bdx;
+	}
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //         The interior point algorithm: min 0.5*x'*H*x + x'*f subject to inequality constraints //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+template <int Dim, int Cons, class Hessian, class Constraints> inline
+void
+QPSolver<DataType,N,C,M,Factorisation>::barrier_interior_point(const Hessian                  &H,
+                                                               const Vector<DataType,Dim>     &f,
+                                                               Constraints                    &constraints,
+                                                               const Vector<DataType,Dim>     &x0,
+                                                               Workspace<Dim,Cons,Hessian>    &ws)
+{
+	// h = 0.5*x'*H*x + x'*f - u*sum log(d_j),   d = z - B*x
+	// g = H*x + f + B'*(u/d)
+	// I = H + B'*diag(u/d^2)*B
+	
+	// Variables used in this scope
+	DataType u = this->initialBarrierScalar;                                                    // As it says
+	unsigned int dim = x0.size();                                                               // Dimensions of the decision varialbe
+	unsigned int numConstraints = constraints.size();                                           // As it says
+	
+	Vector<DataType,Dim>     &g   = ws.g;                                                       // Gradient vector
+	Vector<DataType,Cons>    &d   = ws.d;                                                       // Distance to every constraint
+	Vector<DataType,Cons>    &w   = ws.w;                                                       // Barrier weight on every constraint
+	Vector<DataType,Cons>    &Bdx = ws.Bdx;                                                     // Change in distance for a given step
+	Vector<DataType,Dim>     &dx  = ws.dx;                                                      // Newton step
+	Vector<DataType,Dim>     &x   = ws.x;                                                       // We want to solve for this
+	
+	// Memory is only allocated if the problem size has changed
+	ws.I.resize(dim,dim);
+	g.resize(dim);
+	dx.resize(dim);
+	d.resize(numConstraints);
+	w.resize(numConstraints);
+	Bdx.resize(numConstraints);
+	
+	start_statistics(this->maxSteps);
+	
+	bool warm = this->warmStart and ws.warm and x.size() == dim and ws.lambda.size() == numConstraints;
+	
+	if(warm)
+	{
+		constraints.distance(x, d);                                                         // Slacks of the last solution on the new constraints
+		
+		if((d.array() > 0).all())
+		{
+			// r = H*x + f + B'*lambda is zero if the problem hasn't changed
+			g = f;
+			g.noalias() += H*x;
+			constraints.add_gradient(ws.lambda, g);
+			
+			u = ws.lambda.cwiseProduct(d).mean()                                        // Complementarity of the old duals with the new slacks
+			  + g.norm()*d.mean();                                                      // Make u/d about the size of the change in gradient
+			
+			     if(u < ws.u)                       u = ws.u;                           // Don't go below where we finished
+			else if(u > this->initialBarrierScalar) u = this->initialBarrierScalar;     // No worse than a cold start
+		}
+		else    warm = false;                                                               // Constraints moved too far; start again
+	}
+	
+	if(not warm)
+	{
+		x = x0;
+		
+		constraints.distance(x, d);                                                         // Distance to every constraint
+		
+		if((d.array() <= 0).any() and not phase_one(constraints, x, ws))                    // Find a start point inside the constraints
+		{
+			this->lastCall   = none;                                                    // Not all of the workspace was sized
+			this->numSteps   = 0;
+			this->stepsSaved = 0;
+			ws.warm          = false;
+			
+			finish_statistics();
+			
+			return;
+		}
+	}
+	
+	ws.warm = false;                                                                            // Until we get a solution
+	
+	mark();
+	
+	prepare_newton_step(H, constraints, ws);                                                    // Factorises H if there are few constraints
+	
+	lap(this->stats.factorisationTime);
+	
+	this->converged = false;                                                                    // Until the optimality conditions hold
+	
+	// Run the interior point algorithm
+	for(int i = 0; i < this->maxSteps; i++)
+	{
+		if(interrupted()) break;                                                            // Out of time, or stopped by another thread
+		
+		this->numSteps = i+1;                                                               // Increment the counter
+		
+		mark();
+		
+		constraints.distance(x, d);                                                         // Distance to every constraint
+		
+		DataType minSlack = (numConstraints > 0) ? d.minCoeff() : DataType(0);
+		
+		if(this->adaptiveBarrier and i > 0 and minSlack <= 0)                               // Rounding error at the tolerance, so go back inside
+		{
+			x -= dx;
+			
+			this->numSteps = i;
+			
+			break;
+		}
+		
+		d = (d.array() <= 0).select(DataType(1e-03), d);                                    // Constraint violated; set a small, but non-zero distance
+		
+		// g = H*x + f + B'*(u/d)
+		w = u*d.cwiseInverse();
+		g = f;
+		g.noalias() += H*x;
+		
+		DataType objective = DataType(0.5)*x.dot(g + f);                                    // 0.5*x'*H*x + x'*f
+		
+		constraints.add_gradient(w, g);
+		
+		// I = H + B'*diag(u/d^2)*B, lower triangle only
+		w = w.cwiseProduct(d.cwiseInverse());
+		factorise_newton_step(H, constraints, ws);
+		dx = -g;
+		solve_newton_step(constraints, ws, dx);                                             // Compute Newton step
+		
+		DataType target = u;                                                                // Barrier for the Newton step
+		
+		// Only reduce the barrier close to the central path, i.e. when the Newton decrement
+		// -g'*dx is small compared to the duality gap c*u. Otherwise take a centering step.
+		if(this->adaptiveBarrier and -g.dot(dx) <= 2*numConstraints*u)
+		{
+			// Keeping I at u, the step toward a smaller barrier v is dx - (v - u)*I^-1*B'*(1./d).
+			// This moves an active constraint from d to (v/u)*d, whereas a Newton step on the
+			// barrier for v would overshoot the constraint for any v < u/2.
+			w = d.cwiseInverse();
+			g.setZero();
+			constraints.add_gradient(w, g);
+			solve_newton_step(constraints, ws, g);
+			
+			// Predict the complementarity after the affine scaling step, v = 0, with
+			// lambda = u./d. Relative to u it is (1 - a*r).*(1 - a + a*r), with r = Bdx./d.
+			dx += u*g;
+			constraints.multiply(dx, Bdx);
+			w = Bdx.cwiseQuotient(d);
+			
+			DataType alphaAffine = 1;
+			for(int j = 0; j < w.size(); j++)
+			{
+				     if(w(j) > 1) alphaAffine = min(alphaAffine, 1/w(j));              // Distance reaches zero
+				else if(w(j) < 0) alphaAffine = min(alphaAffine, 1/(1 - w(j)));        // Multiplier reaches zero
+			}
+			
+			DataType sigma = ((1 - alphaAffine*w.array())*(1 - alphaAffine + alphaAffine*w.array())).mean();
+			sigma = max(sigma*sigma*sigma, this->barrierReductionRate);                 // As in the primal-dual method, but no faster than the fixed rate
+			
+			target = max(sigma*u, DataType(0.5)*this->kktTol*(1 + abs(objective))/numConstraints); // No smaller than the tolerance needs
+			dx -= target*g;
+		}
+		
+		lap(this->stats.factorisationTime);
+		
+		// Compute scalar for step size so that constraint is not violated on next step
+		constraints.multiply(dx, Bdx);
+		DataType alpha = barrier_step(d, Bdx);
+		
+		// After a full step, lambda = (v + u*r)./d with r = Bdx./d makes the KKT residual
+		// H*(x + dx) + f + B'*lambda zero. If lambda >= 0 the duality gap is
+		// lambda'*(d - Bdx) = sum((v + u*r).*(1 - r)), which is at most c*v when centred.
+		// The fixed barrier checks it too, for converged, but still stops on the step size.
+		bool certified = false;
+		
+		if(alpha >= 1 and minSlack > 0)
+		{
+			w = Bdx.cwiseQuotient(d);
+			
+			certified = (target + u*w.array()).minCoeff() >= 0
+			        and ((target + u*w.array())*(1 - w.array())).sum() <= this->kktTol*(1 + abs(objective));
+		}
+		
+		dx *= alpha;                                                                        // Scale the step
+		
+		lap(this->stats.stepLengthTime);
+		
+		this->stepSize = dx.norm();                                                         // Magnitude of the step size
+		
+		if(this->instrumented)
+		{
+			this->stats.numFactorisations++;
+			this->stats.numRefinements += ws.Idecomp.refinements;
+			record_iteration(H, f, x, target, this->stepSize, minSlack, ws.Idecomp.refinements);
+		}
+		
+		if(not this->adaptiveBarrier and this->stepSize <= this->tol) break;                // If smaller than tolerance, break
+		
+		// Increment values for next loop
+		x += dx;                                                                            // Increment state
+		
+		this->converged = certified;                                                        // Optimal to within the tolerance
+		
+		if(this->adaptiveBarrier and certified) break;
+		
+		if(this->adaptiveBarrier) u = target;                                               // Chosen above
+		else                      u *= this->barrierReductionRate;                          // Reduce barrier
+	}
+	
+	finish_statistics();
+	
+	// Save the barrier scalar and dual estimates for the next call
+	if(warm) this->stepsSaved = (ws.coldSteps > this->numSteps) ? ws.coldSteps - this->numSteps : 0;
+	else
+	{
+		ws.coldSteps = this->numSteps;
+		this->stepsSaved = 0;
+	}
+	
+	constraints.distance(x, d);
+	
+	if((d.array() > 0).all())
+	{
+		ws.lambda = u*d.cwiseInverse();
+		ws.u      = u;
+		ws.warm   = true;
+	}
+}
+
+  ////////////////////////////////////////////////////////////////////////////////////////////////////
+ //           Phase I: find a start point inside the constraints, or show there is none            //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+template <int Dim, int Cons, class Hessian, class Constraints> inline
+bool QPSolver<DataType,N,C,M,Factorisation>::phase_one(Constraints                 &constraints,
+                                                       Vector<DataType,Dim>        &x,
+                                                       Workspace<Dim,Cons,Hessian> &ws)
+{
+	// min t subject to B*x - t + s = z, s >= 0, with the primal-dual method
+	//
+	// rx = B'*lambda        = 0   (dual residual for x)
+	// rt = 1 - sum(lambda)  = 0   (dual residual for t)
+	// rp = B*x - t + s - z  = 0   (primal residual)
+	// rc = s.*lambda - sigma*mu = 0  (complementarity)
+	//
+	// Eliminating ds and dlambda leaves, with w = lambda./s and u = lambda - rc./s + w.*rp:
+	// [ B'*diag(w)*B   -B'*w  ][dx]   [ -B'*u      ]
+	// [ -w'*B          sum(w) ][dt] = [ sum(u) - 1 ]
+	// and dt is eliminated in turn, so only the n x n block is factorised. At the solution
+	// t = -z'*lambda, so if t > 0 then lambda proves that there is no x with B*x <= z.
+	
+	// Variables used in this scope
+	unsigned int numConstraints = constraints.size();                                           // As it says
+	unsigned int maxIterations  = 50;                                                           // Just in case
+	
+	Vector<DataType,Dim>  &b       = ws.g;                                                      // I^-1*B'*w
+	Vector<DataType,Dim>  &dx      = ws.dx;                                                     // Newton step for x
+	Vector<DataType,Cons> &rp      = ws.d;                                                      // Primal residual
+	Vector<DataType,Cons> &w       = ws.w;                                                      // lambda./s
+	Vector<DataType,Cons> &rc      = ws.Bdx;                                                    // Complementarity residual
+	Vector<DataType,Cons> &s       = ws.s;                                                      // Slack variables
+	Vector<DataType,Cons> &lambda  = ws.lambda;                                                 // Lagrange multipliers
+	Vector<DataType,Cons> &ds      = ws.ds;                                                     // Newton step for the slack variables
+	Vector<DataType,Cons> &dlambda = ws.dlambda;                                                // Newton step for the Lagrange multipliers
+	
+	const DataType margin = 1e-03;                                                              // How far inside the constraints to stop
+	
+	{
+		MallocGuard guard(true);                                                            // Only allocates if the size changed
+		
+		s.resize(numConstraints);                                                           // Not otherwise used by the barrier method
+		lambda.resize(numConstraints);
+		ds.resize(numConstraints);
+		dlambda.resize(numConstraints);
+	}
+	
+	// Start on the constraint with rp = 0, s >= 1
+	constraints.distance(x, s);
+	DataType t = 1 - s.minCoeff();                                                              // Largest violation, plus a bit
+	s.array() += t;
+	rp.setZero();
+	lambda.setConstant(DataType(1)/numConstraints);
+	
+	for(unsigned int i = 0; i < maxIterations; i++)
+	{
+		if(interrupted()) return true;                                                      // The caller stops too
+		
+		DataType minSlack = (s - rp).minCoeff() - t;                                        // z - B*x = s - t - rp
+		
+		if(minSlack >= margin) return true;                                                 // Far enough inside the constraints
+		
+		DataType mu  = s.dot(lambda)/numConstraints;
+		DataType sum = lambda.sum();
+		
+		dx.setZero();
+		constraints.add_gradient(lambda, dx);                                               // rx = B'*lambda
+		
+		if(mu <= this->kktTol
+		and rp.template lpNorm<Infinity>() <= this->kktTol*(1 + s.template lpNorm<Infinity>())
+		and abs(1 - sum) <= this->kktTol
+		and (dx.template lpNorm<Infinity>() <= this->kktTol
+		 or  mu <= NumTraits<DataType>::epsilon()*this->kktTol))                            // B'*lambda can stall at rounding level
+		{
+			if(minSlack > 0) return true;                                               // Inside, but it can't get any further
+			
+			MallocGuard guard(true);                                                    // Only allocates if the size changed
+			
+			this->certificate = lambda/sum;
+			this->lastStatus  = infeasible;
+			
+			return false;
+		}
+		
+		// I = delta*eye + B'*diag(lambda./s)*B, lower triangle only
+		w = lambda.cwiseQuotient(s);
+		phase_one_hessian(w, constraints, sqrt(NumTraits<DataType>::epsilon())*(1 + w.maxCoeff()), ws.I);
+		
+		ws.Idecomp.factorise(ws.I);                                                         // Used for both the predictor and corrector
+		
+		// b = I^-1*B'*w
+		b.setZero();
+		constraints.add_gradient(w, b);
+		ws.Idecomp.solve_in_place(b);
+		constraints.multiply(b, ds);
+		DataType schur = w.sum() - w.dot(ds);                                               // sum(w) - w'*B*I^-1*B'*w
+		
+		// Predictor (affine scaling) step with rc = s.*lambda
+		rc = s.cwiseProduct(lambda);
+		dlambda = lambda - rc.cwiseQuotient(s) + w.cwiseProduct(rp);                        // u
+		dx.setZero();
+		constraints.add_gradient(dlambda, dx);
+		dx = -dx;
+		DataType dt = (dlambda.sum() - 1 + b.dot(dx))/schur;
+		ws.Idecomp.solve_in_place(dx);
+		dx += dt*b;
+		constraints.multiply(dx, ds);
+		ds = -rp - ds;
+		ds.array() += dt;                                                                   // ds = -rp - B*dx + dt
+		dlambda = -(rc + lambda.cwiseProduct(ds)).cwiseQuotient(s);
+		
+		DataType alpha = max_step(s, ds, lambda, dlambda);
+		
+		DataType sigma = (s + alpha*ds).dot(lambda + alpha*dlambda)/(numConstraints*mu);    // Centering parameter
+		sigma = sigma*sigma*sigma;
+		
+		// Corrector step with rc = s.*lambda + ds.*dlambda - sigma*mu
+		rc += ds.cwiseProduct(dlambda);
+		rc.array() -= sigma*mu;
+		dlambda = lambda - rc.cwiseQuotient(s) + w.cwiseProduct(rp);
+		dx.setZero();
+		constraints.add_gradient(dlambda, dx);
+		dx = -dx;
+		dt = (dlambda.sum() - 1 + b.dot(dx))/schur;
+		ws.Idecomp.solve_in_place(dx);
+		dx += dt*b;
+		constraints.multiply(dx, ds);
+		ds = -rp - ds;
+		ds.array() += dt;
+		dlambda = -(rc + lambda.cwiseProduct(ds)).cwiseQuotient(s);
+		
+		alpha = min(1.0, 0.99*max_step(s, ds, lambda, dlambda));                            // Stay strictly inside the boundary
+		
+		x      += alpha*dx;
+		t      += alpha*dt;
+		s      += alpha*ds;
+		lambda += alpha*dlambda;
+		
+		// rp = B*x - t + s - z
+		constraints.distance(x, rp);
+		rp = s - rp;
+		rp.array() -= t;
+		
+		if(this->instrumented)
+		{
+			this->stats.phaseOneSteps++;
+			this->stats.numFactorisations++;
+		}
+	}
+	
+	if((s - rp).minCoeff() - t > 0) return true;
+	
+	MallocGuard guard(true);                                                                    // Only allocates if the size changed
+	
+	this->certificate = lambda/lambda.sum();                                                    // May not prove anything
+	this->lastStatus  = infeasible;
+	
+	return false;
+}
+
+  ////////////////////////////////////////////////////////////////////////////////////////////////////
+ //                               Phase I for upper and lower bounds                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+template <int Dim, int Cons, class Hessian> inline
+bool QPSolver<DataType,N,C,M,Factorisation>::phase_one(BoundConstraints            &constraints,
+                                                       Vector<DataType,Dim>        &x,
+                                                       Workspace<Dim,Cons,Hessian> &ws)
+{
+	constraints.interior_point(x);                                                              // Middle of the bounds
+	constraints.distance(x, ws.d);
+	
+	if((ws.d.array() > 0).all()) return true;
+	
+	// xMax(j) <= xMin(j), so lambda = 0.5 on both bounds of x(j) gives B'*lambda = 0 and
+	// z'*lambda = 0.5*(xMax(j) - xMin(j)) <= 0
+	unsigned int n = ws.d.size()/2;
+	
+	Index j;
+	ws.d.head(n).minCoeff(&j);
+	
+	MallocGuard guard(true);                                                                    // Only allocates if the size changed
+	
+	this->certificate.setZero(2*n);
+	this->certificate(j) = this->certificate(n+j) = 0.5;
+	this->lastStatus = infeasible;
+	
+	return false;
+}
+
+  ////////////////////////////////////////////////////////////////////////////////////////////////////
+ //       Primal-dual interior point algorithm with Mehrotra's predictor-corrector method          //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+template <int Dim, int Cons, class Hessian, class Constraints> inline
+void
+QPSolver<DataType,N,C,M,Factorisation>::primal_dual_interior_point(const Hessian                  &H,
+                                                                   const Vector<DataType,Dim>     &f,
+                                                                   Constraints                    &constraints,
+                                                                   const Vector<DataType,Dim>     &x0,
+                                                                   Workspace<Dim,Cons,Hessian>    &ws)
+{
+	// L = 0.5*x'*H*x + x'*f + lambda'*(B*x + s - z),   s >= 0, lambda >= 0
+	//
+	// rd = H*x + f + B'*lambda = 0   (dual residual)
+	// rp = B*x + s - z         = 0   (primal residual)
+	// rc = s.*lambda - sigma*mu = 0  (complementarity)
+	//
+	// Eliminating ds and dlambda from the Newton step leaves:
+	// (H + B'*diag(lambda./s)*B)*dx = -rd + B'*(rc./s - (lambda./s).*rp)
+	
+	// Variables used in this scope
+	unsigned int dim = x0.size();                                                               // Dimensions of the decision variable
+	unsigned int numConstraints = constraints.size();                                           // As it says
+	
+	Vector<DataType,Dim>     &rd      = ws.g;                                                   // Dual residual
+	Vector<DataType,Dim>     &dx      = ws.dx;                                                  // Newton step
+	Vector<DataType,Dim>     &x       = ws.x;                                                   // We want to solve for this
+	Vector<DataType,Cons>    &rp      = ws.d;                                                   // Primal residual
+	Vector<DataType,Cons>    &w       = ws.w;                                                   // lambda./s
+	Vector<DataType,Cons>    &rc      = ws.Bdx;                                                 // Complementarity residual
+	Vector<DataType,Cons>    &s       = ws.s;                                                   // Slack variables
+	Vector<DataType,Cons>    &lambda  = ws.lambda;                                              // Lagrange multipliers
+	Vector<DataType,Cons>    &ds      = ws.ds;                                                  // Newton step for the slack variables
+	Vector<DataType,Cons>    &dlambda = ws.dlambda;                                             // Newton step for the Lagrange multipliers
+	
+	bool warm = this->warmStart and ws.warm and x.size() == dim and lambda.size() == numConstraints;
+	
+	// Memory is only allocated if the problem size has changed
+	ws.I.resize(dim,dim);
+	rd.resize(dim);
+	dx.resize(dim);
+	rp.resize(numConstraints);
+	w.resize(numConstraints);
+	rc.resize(numConstraints);
+	s.resize(numConstraints);
+	lambda.resize(numConstraints);
+	ds.resize(numConstraints);
+	dlambda.resize(numConstraints);
+	ws.xBest.resize(dim);
+	
+	// The start point does not need to satisfy the constraints, but the slack variables
+	// and Lagrange multipliers must be strictly positive
+	if(warm) lambda = lambda.cwiseMax(sqrt(this->kktTol));                                      // Move the last multipliers off the boundary
+	else
+	{
+		x = x0;
+		lambda.setOnes();
+	}
+	
+	constraints.distance(x, s);                                                                 // s = z - B*x satisfies the constraints exactly...
+	s = s.cwiseMax(warm ? sqrt(this->kktTol) : DataType(1));                                    // ...but must be positive
+	
+	ws.warm = false;                                                                            // Until we get a solution
+	
+	DataType mu = 0.0;                                                                          // Average complementarity s'*lambda/c
+	
+	DataType bestObjective = numeric_limits<DataType>::infinity();                              // Of ws.xBest
+	
+	start_statistics(this->maxSteps);
+	
+	mark();
+	
+	prepare_newton_step(H, constraints, ws);                                                    // Factorises H if there are few constraints
+	
+	lap(this->stats.factorisationTime);
+	
+	this->converged = false;                                                                    // Until the optimality conditions hold
+	
+	for(int i = 0; i < this->maxSteps; i++)
+	{
+		if(interrupted()) break;                                                            // Out of time, or stopped by another thread
+		
+		this->numSteps = i+1;                                                               // Increment the counter
+		
+		mark();
+		
+		// rp = B*x + s - z
+		constraints.distance(x, rp);
+		rp = s - rp;
+		
+		// rd = H*x + f + B'*lambda
+		rd = f;
+		rd.noalias() += H*x;
+		
+		DataType objective = DataType(0.5)*x.dot(rd + f);                                   // 0.5*x'*H*x + x'*f
+		
+		constraints.add_gradient(lambda, rd);
+		
+		// Keep the best strictly feasible iterate, in case the algorithm is stopped early
+		if(objective < bestObjective and (numConstraints == 0 or (s - rp).minCoeff() > 0)) // z - B*x = s - rp
+		{
+			ws.xBest = x;
+			bestObjective = objective;
+		}
+		
+		mu = s.dot(lambda)/numConstraints;
+		
+		if(mu <= this->kktTol
+		and rp.template lpNorm<Infinity>() <= this->kktTol*(1 + s.template lpNorm<Infinity>())
+		and rd.template lpNorm<Infinity>() <= this->kktTol*(1 + f.template lpNorm<Infinity>()))
+		{
+			this->numSteps = i;                                                         // Solved on the last step
+			this->converged = true;
+			break;
+		}
+		
+		// I = H + B'*diag(lambda./s)*B, lower triangle only
+		w = lambda.cwiseQuotient(s);
+		factorise_newton_step(H, constraints, ws);                                          // Used for both the predictor and corrector
+		
+		// Predictor (affine scaling) step with rc = s.*lambda
+		rc = s.cwiseProduct(lambda);
+		dlambda = lambda - w.cwiseProduct(rp);                                              // rc./s - w.*rp
+		dx = -rd;
+		constraints.add_gradient(dlambda, dx);
+		solve_newton_step(constraints, ws, dx);
+		constraints.multiply(dx, ds);
+		ds = -rp - ds;                                                                      // ds = -rp - B*dx
+		dlambda = -(rc + lambda.cwiseProduct(ds)).cwiseQuotient(s);
+		
+		lap(this->stats.factorisationTime);
+		
+		DataType alpha = max_step(s, ds, lambda, dlambda);
+		
+		lap(this->stats.stepLengthTime);
+		
+		DataType sigma = (s + alpha*ds).dot(lambda + alpha*dlambda)/(numConstraints*mu);    // Centering parameter
+		sigma = sigma*sigma*sigma;
+		
+		// Corrector step with rc = s.*lambda + ds.*dlambda - sigma*mu
+		rc += ds.cwiseProduct(dlambda);
+		rc.array() -= sigma*mu;
+		dlambda = rc.cwiseQuotient(s) - w.cwiseProduct(rp);
+		dx = -rd;
+		constraints.add_gradient(dlambda, dx);
+		solve_newton_step(constraints, ws, dx);
+		constraints.multiply(dx, ds);
+		ds = -rp - ds;
+		dlambda = -(rc + lambda.cwiseProduct(ds)).cwiseQuotient(s);
+		
+		lap(this->stats.factorisationTime);
+		
+		alpha = min(1.0, 0.99*max_step(s, ds, lambda, dlambda));                            // Stay strictly inside the boundary
+		
+		lap(this->stats.stepLengthTime);
+		
+		this->stepSize = alpha*dx.norm();                                                   // Magnitude of the step size
+		
+		if(this->instrumented)
+		{
+			this->stats.numFactorisations++;
+			this->stats.numRefinements += ws.Idecomp.refinements;
+			record_iteration(H, f, x, mu, this->stepSize, (s - rp).minCoeff(),          // z - B*x = s - rp
+			                 ws.Idecomp.refinements);
+		}
+		
+		x      += alpha*dx;
+		s      += alpha*ds;
+		lambda += alpha*dlambda;
+	}
+	
+	// The iterates do not have to satisfy the constraints, so if the last one doesn't then check
+	// that they can be satisfied at all
+	if(numConstraints > 0) constraints.distance(x, rp);
+	
+	// If stopped early, return the best iterate that does
+	if((this->lastStatus == timedOut or this->lastStatus == cancelled)
+	and bestObjective < numeric_limits<DataType>::infinity()
+	and numConstraints > 0 and not (rp.minCoeff() > 0))
+	{
+		x = ws.xBest;
+		constraints.distance(x, rp);
+	}
+	
+	bool violated = numConstraints > 0
+	            and not (rp.minCoeff() >= -this->kktTol*(1 + s.template lpNorm<Infinity>())); // Also true for NaN
+	
+	if(violated and not x.allFinite()) x = x0;                                                  // The iterates diverged
+	
+	if(violated and not phase_one(constraints, x, ws))
+	{
+		finish_statistics();
+		
+		ws.warm = false;
+		this->stepsSaved = 0;
+		
+		return;
+	}
+	
+	finish_statistics();
+	
+	// Save the duals for the next call
+	if(warm) this->stepsSaved = (ws.coldSteps > this->numSteps) ? ws.coldSteps - this->numSteps : 0;
+	else
+	{
+		ws.coldSteps = this->numSteps;
+		this->stepsSaved = 0;
+	}
+	
+	ws.u    = mu;
+	ws.warm = true;
+}
+
+  ////////////////////////////////////////////////////////////////////////////////////////////////////
+ //            The dual active set method of Goldfarb & Idnani for strictly convex problems        //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+template <int Dim, int Cons, class Equalities, class Constraints> inline
+void
+QPSolver<DataType,N,C,M,Factorisation>::active_set_method(const Matrix<DataType,N,N> &H,
+                                                          const Vector<DataType,N>   &f,
+                                                          const Equalities           &equalities,
+                                                          Constraints                &constraints,
+                                                          Workspace<Dim,Cons>        &workspace,
+                                                          const bool                 &factorised)
+{
+	// D. Goldfarb and A. Idnani (1983) "A numerically stable dual method for solving strictly
+	// convex quadratic programs", Mathematical Programming 27, pp. 1-33.
+	//
+	// Starting from the unconstrained minimum, the most violated constraint is added to the
+	// active set at each step. Constraints whose Lagrange multipliers would become negative are
+	// removed along the way. The matrices J and R are updated with Givens rotations.
+	//
+	// Inequalities are written as s(x) = z - B*x >= 0, with normal -B.row(j)'.
+	
+	ActiveSetWorkspace<Cons> &ws = workspace.activeSet;                                         // Makes the code easier to read
+	
+	// Variables used in this scope
+	unsigned int n = f.size();                                                                  // Dimensions of the decision variable
+	unsigned int m = equalities.size();                                                         // Number of equality constraints
+	unsigned int c = constraints.size();                                                        // Number of inequality constraints
+	unsigned int numActive = 0;                                                                 // Number of constraints in the active set
+	DataType inf = numeric_limits<DataType>::infinity();
+	DataType eps = numeric_limits<DataType>::epsilon();
+	DataType Rnorm = 1.0;                                                                       // Largest diagonal element of R
+	
+	// Memory is only allocated if the problem size has changed
+	ws.J.resize(n,n);
+	ws.R.resize(n,n);
+	ws.x.resize(n);
+	ws.xOld.resize(n);
+	ws.np.resize(n);
+	ws.d.resize(n);
+	ws.z.resize(n);
+	ws.r.resize(n);
+	ws.u.resize(n+1);
+	ws.uOld.resize(n+1);
+	ws.active.resize(n+1);
+	ws.activeOld.resize(n+1);
+	ws.s.resize(c);
+	ws.inactive.resize(c);
+	ws.excluded.resize(c);
+	
+	start_statistics(n + c);
+	
+	if(not factorised) ws.Hdecomp.compute(H);                                                   // H = L*L'
+	
+	lap(this->stats.factorisationTime);
+	
+	if(this->instrumented) this->stats.numFactorisations = factorised ? 0 : 1;
+	
+	if(ws.Hdecomp.info() != Success)
+	{
+		this->lastCall = none;                                                              // Not all of the workspace was sized
+		
+		throw runtime_error("[ERROR] [QP SOLVER] solve(): "
+		                    "The active set method requires a positive definite Hessian.");
+	}
+	
+	// A constraint is violated if s(x) < -tolerance, relative to the size of z = s(0)
+	ws.np.setZero();
+	constraints.distance(ws.np, ws.s);
+	DataType tolerance = 100*eps*(1 + ((c > 0) ? ws.s.template lpNorm<Infinity>() : DataType(0)));
+	
+	// The active set from the last call, or given by the user, is added first
+	bool seeded = this->activeSetGiven or this->warmStart;
+	
+	this->activeSetGiven = false;                                                               // Only used once
+	
+	ws.excluded.setZero();                                                                      // Marks seeds that were not active
+	
+	unsigned int restarts = 0;
+	
+	while(true)
+	{
+		// Start from the unconstrained minimum with J = L^-T, R = 0
+		ws.J.setIdentity();
+		ws.Hdecomp.matrixU().solveInPlace(ws.J);
+		ws.R.setZero();
+		ws.x = -f;
+		ws.Hdecomp.solveInPlace(ws.x);
+		numActive = 0;
+		Rnorm = 1.0;
+		
+		// Equality constraints are always active
+		for(int i = 0; i < m; i++)
+		{
+			equalities.normal(i, ws.np);
+			active_set_step(ws, numActive);
+			
+			DataType t = 0.0;
+			if(ws.z.squaredNorm() > eps) t = -equalities.residual(i, ws.x)/ws.z.dot(ws.np); // Step on to the constraint
+			
+			ws.x += t*ws.z;
+			ws.u(numActive) = t;
+			ws.u.head(numActive) -= t*ws.r.head(numActive);
+			ws.active(numActive) = -i-1;
+			
+			if(not add_constraint(ws, numActive, Rnorm))
+			{
+				this->lastCall = none;
+				
+				throw invalid_argument("[ERROR] [QP SOLVER] constrained_least_squares(): "
+				                       "The equality constraints are linearly dependent.");
+			}
+		}
+		
+		if(not seeded) break;
+		
+		// Add the seeded inequality constraints as if they were equalities
+		bool restart = false;
+		
+		for(int k = 0; k < this->activeSet.size() and numActive < n and not restart; k++)
+		{
+			unsigned int j = this->activeSet[k];
+			
+			if(j >= c or ws.excluded(j)) continue;                                      // Invalid, or found not to be active
+			
+			bool duplicate = false;
+			for(int i = m; i < numActive; i++) if(ws.active(i) == j) duplicate = true;
+			if(duplicate) continue;
+			
+			constraints.row(j, ws.np);
+			ws.np = -ws.np;
+			active_set_step(ws, numActive);
+			
+			constraints.distance(ws.x, ws.s);
+			
+			DataType t = 0.0;
+			if(ws.z.squaredNorm() > eps) t = -ws.s(j)/ws.z.dot(ws.np);
+			
+			ws.x += t*ws.z;
+			ws.u(numActive) = t;
+			ws.u.head(numActive) -= t*ws.r.head(numActive);
+			ws.active(numActive) = j;
+			
+			if(not add_constraint(ws, numActive, Rnorm))                                // Linearly dependent
+			{
+				ws.excluded(j) = 1;
+				restart = true;
+			}
+		}
+		
+		// The multipliers must be positive, otherwise remove the worst one and try again
+		if(not restart)
+		{
+			int worst = -1;
+			DataType minimum = 0.0;
+			for(int i = m; i < numActive; i++)
+			{
+				if(ws.u(i) < minimum)
+				{
+					minimum = ws.u(i);
+					worst   = ws.active(i);
+				}
+			}
+			
+			if(worst < 0) break;                                                        // The seeds are a valid start
+			
+			ws.excluded(worst) = 1;
+		}
+		
+		if(++restarts > this->activeSet.size()) seeded = false;                             // Give up on the seeds
+	}
+	
+	// Run the active set method
+	for(int i = 0; i < c; i++) ws.inactive(i) = i;
+	for(int i = m; i < numActive; i++) ws.inactive(ws.active(i)) = -1;
+	
+	this->numSteps = 0;
+	this->stepSize = 0.0;
+	
+	unsigned int maxIterations = 10*(n + c);                                                    // Just in case it cycles
+	
+	this->lastStatus = solved;                                                                  // Unless a constraint can't be satisfied
+	
+	start_clock();
+	
+	bool solved = false;
+	
+	while(not solved and this->lastStatus != infeasible and this->numSteps < maxIterations and not interrupted())
+	{
+		// Step 1: Check every constraint
+		constraints.distance(ws.x, ws.s);
+		
+		if(c == 0 or ws.s.minCoeff() >= -tolerance)                                         // Every constraint is satisfied
+		{
+			solved = true;
+			break;
+		}
+		
+		ws.uOld.head(numActive)      = ws.u.head(numActive);
+		ws.activeOld.head(numActive) = ws.active.head(numActive);
+		ws.xOld                      = ws.x;
+		ws.excluded.setZero();
+		
+		while(true)
+		{
+			// Step 2: Choose the most violated constraint
+			int p = -1;
+			DataType violation = -tolerance;
+			for(int i = 0; i < c; i++)
+			{
+				if(ws.s(i) < violation and ws.inactive(i) != -1 and not ws.excluded(i))
+				{
+					violation = ws.s(i);
+					p = i;
+				}
+			}
+			
+			if(p < 0)
+			{
+				solved = true;
+				break;
+			}
+			
+			constraints.row(p, ws.np);
+			ws.np = -ws.np;
+			ws.u(numActive) = 0.0;
+			ws.active(numActive) = p;
+			
+			bool added = false;
+			
+			while(not added)
+			{
+				this->numSteps++;
+				
+				// Step 2a: Compute the step direction in the primal and dual space
+				active_set_step(ws, numActive);
+				
+				// Step 2b: Partial step length t1; the largest step before a multiplier becomes negative
+				int l = -1;
+				DataType t1 = inf;
+				for(int k = m; k < numActive; k++)
+				{
+					if(ws.r(k) > 0 and ws.u(k)/ws.r(k) < t1)
+					{
+						t1 = ws.u(k)/ws.r(k);
+						l  = ws.active(k);
+					}
+				}
+				
+				// Full step length t2; the step on to the constraint
+				DataType t2 = inf;
+				if(ws.z.squaredNorm() > eps)
+				{
+					t2 = -ws.s(p)/ws.z.dot(ws.np);
+					if(t2 < 0) t2 = inf;                                        // Numerical inconsistency
+				}
+				
+				DataType t = min(t1, t2);
+				
+				// Step 2c: Take the step
+				if(t >= inf)                                                        // Constraint p can't be satisfied with the active ones
+				{
+					this->lastStatus = infeasible;
+					
+					MallocGuard guard(true);                                    // Only allocates if the size changed
+					
+					if(m > 0) this->certificate.resize(0);                      // It would also need the equality multipliers
+					else
+					{
+						// Row p of B is a combination sum(r_k*b_k) of the active rows with r <= 0,
+						// and s(p) = z(p) - b_p'*x < 0 where b_k'*x = z(k)
+						this->certificate.setZero(c);
+						this->certificate(p) = 1;
+						for(int k = 0; k < numActive; k++) this->certificate(ws.active(k)) = -ws.r(k);
+						this->certificate /= this->certificate.sum();
+					}
+					
+					break;
+				}
+				
+				if(t2 >= inf)                                                       // Step in the dual space only
+				{
+					ws.u.head(numActive) -= t*ws.r.head(numActive);
+					ws.u(numActive) += t;
+					ws.inactive(l) = l;
+					delete_constraint(ws, m, numActive, l);
+					continue;
+				}
+				
+				if(this->instrumented)
+				{
+					MallocGuard guard(true);                                    // Statistics are allowed to allocate
+					
+					Vector<DataType,Cons> slack(c);
+					constraints.distance(ws.x, slack);
+					
+					record_iteration(H, f, ws.x, DataType(0), t*ws.z.norm(), slack.minCoeff());
+				}
+				
+				ws.x += t*ws.z;                                                     // Step in the primal and dual space
+				ws.u.head(numActive) -= t*ws.r.head(numActive);
+				ws.u(numActive) += t;
+				
+				this->stepSize = t*ws.z.norm();
+				
+				if(t == t2)                                                         // Full step; add the constraint
+				{
+					if(add_constraint(ws, numActive, Rnorm)) ws.inactive(p) = -1;
+					else
+					{
+						// Linearly dependent on the active set, so restore the last step and try another
+						ws.excluded(p) = 1;
+						delete_constraint(ws, m, numActive, p);
+						for(int i = 0; i < c; i++) ws.inactive(i) = i;
+						for(int i = m; i < numActive; i++)
+						{
+							ws.active(i) = ws.activeOld(i);
+							ws.u(i)      = ws.uOld(i);
+							ws.inactive(ws.active(i)) = -1;
+						}
+						ws.x = ws.xOld;
+						break;
+					}
+					
+					added = true;
+				}
+				else                                                                // Partial step; remove the blocking constraint
+				{
+					ws.inactive(l) = l;
+					delete_constraint(ws, m, numActive, l);
+					ws.s(p) += t*ws.z.dot(ws.np);
+				}
+			}
+			
+			if(added or this->lastStatus == infeasible) break;
+		}
+	}
+	
+	this->converged = solved;
+	
+	// Save the active set for the next call
+	this->activeSet.clear();
+	for(int i = m; i < numActive; i++) this->activeSet.push_back(ws.active(i));
+	
+	finish_statistics();
+}
+
+  ////////////////////////////////////////////////////////////////////////////////////////////////////
+ //               Compute the primal and dual step directions for the active set method            //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+template <int Cons> inline
+void QPSolver<DataType,N,C,M,Factorisation>::active_set_step(ActiveSetWorkspace<Cons> &ws, const unsigned int &numActive)
+{
+	unsigned int n = ws.x.size();
+	
+	ws.d.noalias() = ws.J.transpose()*ws.np;
+	
+	ws.z.noalias() = ws.J.rightCols(n - numActive)*ws.d.tail(n - numActive);                    // Step in the primal space
+	
+	ws.r.head(numActive) = ws.d.head(numActive);
+	ws.R.topLeftCorner(numActive,numActive).template triangularView<Upper>().solveInPlace(ws.r.head(numActive)); // Step in the dual space
+}
+
+  ////////////////////////////////////////////////////////////////////////////////////////////////////
+ //                    Add a constraint to the active set for the active set method                //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+template <int Cons> inline
+bool QPSolver<DataType,N,C,M,Factorisation>::add_constraint(ActiveSetWorkspace<Cons> &ws, unsigned int &numActive, DataType &Rnorm)
+{
+	unsigned int n = ws.x.size();
+	
+	// Rotate d so that only its first numActive+1 elements are non-zero, and apply the same to J
+	for(int j = n-1; j > (int)numActive; j--)
+	{
+		DataType cc = ws.d(j-1);
+		DataType ss = ws.d(j);
+		DataType h  = hypot(cc, ss);
+		
+		if(h == 0.0) continue;
+		
+		ws.d(j) = 0.0;
+		ss /= h;
+		cc /= h;
+		
+		if(cc < 0)
+		{
+			ws.d(j-1) = -h;
+			cc = -cc;
+			ss = -ss;
+		}
+		else	ws.d(j-1) = h;
+		
+		DataType xny = ss/(1.0 + cc);
+		
+		for(int k = 0; k < n; k++)
+		{
+			DataType t1 = ws.J(k,j-1);
+			DataType t2 = ws.J(k,j);
+			ws.J(k,j-1) = t1*cc + t2*ss;
+			ws.J(k,j)   = xny*(t1 + ws.J(k,j-1)) - t2;
+		}
+	}
+	
+	numActive++;
+	
+	ws.R.col(numActive-1).head(numActive) = ws.d.head(numActive);                               // Add a column to R
+	
+	if(abs(ws.d(numActive-1)) <= numeric_limits<DataType>::epsilon()*Rnorm) return false;       // Linearly dependent
+	
+	Rnorm = std::max<DataType>(Rnorm, abs(ws.d(numActive-1)));
+	
+	return true;
+}
+
+  ////////////////////////////////////////////////////////////////////////////////////////////////////
+ //                Remove a constraint from the active set for the active set method               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+template <int Cons> inline
+void QPSolver<DataType,N,C,M,Factorisation>::delete_constraint(ActiveSetWorkspace<Cons> &ws,
+                                                               const unsigned int &numEqualities,
+                                                               unsigned int &numActive,
+                                                               const int &index)
+{
+	unsigned int n = ws.x.size();
+	unsigned int q = numEqualities;
+	
+	for(int i = numEqualities; i < numActive; i++)
+	{
+		if(ws.active(i) == index)
+		{
+			q = i;
+			break;
+		}
+	}
+	
+	// Shift everything after it to the left, including the constraint being added
+	for(int i = q; i < numActive-1; i++)
+	{
+		ws.active(i) = ws.active(i+1);
+		ws.u(i)      = ws.u(i+1);
+		ws.R.col(i)  = ws.R.col(i+1);
+	}
+	
+	ws.active(numActive-1) = ws.active(numActive);
+	ws.u(numActive-1)      = ws.u(numActive);
+	ws.active(numActive)   = 0;
+	ws.u(numActive)        = 0.0;
+	ws.R.col(numActive-1).head(numActive).setZero();
+	
+	numActive--;
+	
+	// R now has a non-zero subdiagonal from column q, so rotate it back to upper triangular
+	for(int j = q; j < numActive; j++)
+	{
+		DataType cc = ws.R(j,j);
+		DataType ss = ws.R(j+1,j);
+		DataType h  = hypot(cc, ss);
+		
+		if(h == 0.0) continue;
+		
+		cc /= h;
+		ss /= h;
+		ws.R(j+1,j) = 0.0;
+		
+		if(cc < 0)
+		{
+			ws.R(j,j) = -h;
+			cc = -cc;
+			ss = -ss;
+		}
+		else	ws.R(j,j) = h;
+		
+		DataType xny = ss/(1.0 + cc);
+		
+		for(int k = j+1; k < numActive; k++)
+		{
+			DataType t1 = ws.R(j,k);
+			DataType t2 = ws.R(j+1,k);
+			ws.R(j,k)   = t1*cc + t2*ss;
+			ws.R(j+1,k) = xny*(t1 + ws.R(j,k)) - t2;
+		}
+		
+		for(int k = 0; k < n; k++)
+		{
+			DataType t1 = ws.J(k,j);
+			DataType t2 = ws.J(k,j+1);
+			ws.J(k,j)   = t1*cc + t2*ss;
+			ws.J(k,j+1) = xny*(ws.J(k,j) + t1) - t2;
+		}
+	}
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                  Set the rate at which the barrier scalar reduces: u *= beta                  //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+bool QPSolver<DataType,N,C,M,Factorisation>::set_barrier_reduction_rate(const DataType &rate)
+{
+	if(rate <= 0 or rate >= 1)
+	{
+		cerr << "[ERROR] [QP SOLVER] set_barrier_reduction_rate(): "
+		        "Input argument was " << to_string(rate) << " but it must be between 0 and 1.\n";
+		             
+		return false;
+	}
+	else
+	{
+		this->barrierReductionRate = rate;
+		
+		return true;
+	}
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //             Reduce the barrier according to progress and stop on the duality gap              //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+void QPSolver<DataType,N,C,M,Factorisation>::use_adaptive_barrier()
+{
+	this->adaptiveBarrier = true;
+	
+	std::cout << "[INFO] [QP SOLVER] Reducing the barrier according to progress, and stopping on the duality gap.\n";
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                 Reduce the barrier at a fixed rate and stop on the step size                  //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+void QPSolver<DataType,N,C,M,Factorisation>::use_fixed_barrier()
+{
+	this->adaptiveBarrier = false;
+	
+	std::cout << "[INFO] [QP SOLVER] Reducing the barrier at a fixed rate, and stopping on the step size.\n";
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //       Set the magnitude of the step size for which the interior point method terminates       //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+bool QPSolver<DataType,N,C,M,Factorisation>::set_tolerance(const DataType &tolerance)
+{
+	if(tolerance <= 0)
+	{
+		cerr << "[ERROR] [QP SOLVER] set_tolerance(): "
+		     << "Input argument was " << to_string(tolerance) << " but it must be positive.\n";
+		 
+		return false;
+	}
+	else
+	{
+		this->tol = tolerance;
+		
+		return true;
+	}
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //            Set the number of steps in the interior point method before terminating            //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+bool QPSolver<DataType,N,C,M,Factorisation>::set_max_steps(const unsigned int &number)
+{
+	if(number == 0)
+	{
+		cerr << "[ERROR] [QP SOLVER] set_num_steps(): "
+		     << "Input argument was 0 but it must be greater than zero.\n";
+		
+		return false;
+	}
+	else
+	{
+		this->maxSteps = number;
+		
+		return true;
+	}
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //               Set the scalar on the barrier function for inequality constraints               //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+bool QPSolver<DataType,N,C,M,Factorisation>::set_barrier_scalar(const DataType &scalar)
+{
+	if(scalar <= 0)
+	{
+		cerr << "[ERROR] [QP SOLVER] set_barrier_scalar(): "
+		     << "Input argument was " << to_string(scalar) << " but it must be positive.\n";
+		
+		return false;
+	}
+	else
+	{
+		this->initialBarrierScalar = scalar;
+		
+		return true;
+	}
+}
+  
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //    Set the tolerance on the optimality conditions for the primal-dual interior point method   //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+bool QPSolver<DataType,N,C,M,Factorisation>::set_kkt_tolerance(const DataType &tolerance)
+{
+	if(tolerance <= 0)
+	{
+		cerr << "[ERROR] [QP SOLVER] set_kkt_tolerance(): "
+		     << "Input argument was " << to_string(tolerance) << " but it must be positive.\n";
+		
+		return false;
+	}
+	else
+	{
+		this->kktTol = tolerance;
+		
+		return true;
+	}
+}
+
+  ////////////////////////////////////////////////////////////////////////////////////////////////////
+ //                           Use the dual method to solve the QP problem                          //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+void QPSolver<DataType,N,C,M,Factorisation>::use_dual()
+{
+	this->method = dual;
+	
+	std::cout << "[INFO] [QP SOLVER] Using the dual method to solve.\n";
+}
+
+  ////////////////////////////////////////////////////////////////////////////////////////////////////
+ //                         Use the primal method to solve the QP problem                          //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+void QPSolver<DataType,N,C,M,Factorisation>::use_primal()
+{
+	this->method = primal;
+	
+	std::cout << "[INFO] [QP SOLVER] Using the primal method to solve.\n";
+}
+
+  ////////////////////////////////////////////////////////////////////////////////////////////////////
+ //              Solve redundant problems in the null space of the equality constraints            //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+void QPSolver<DataType,N,C,M,Factorisation>::use_null_space()
+{
+	this->method = nullSpace;
+	
+	std::cout << "[INFO] [QP SOLVER] Using the null space method to solve.\n";
+}
+
+  ////////////////////////////////////////////////////////////////////////////////////////////////////
+ //                   Resume the interior point algorithm from the last solution                   //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+void QPSolver<DataType,N,C,M,Factorisation>::use_warm_start()
+{
+	this->warmStart = true;
+	
+	std::cout << "[INFO] [QP SOLVER] Using a warm start for inequality constraints.\n";
+}
 
   ////////////////////////////////////////////////////////////////////////////////////////////////////
- //              Solve a standard QP problem of the form min 0.5*x'*H*x + x'*f                     //
+ //                     Start the interior point algorithm from x0 every time                      //
 ////////////////////////////////////////////////////////////////////////////////////////////////////
-template <class DataType> inline
-Vector<DataType,Dynamic>
-QPSolver<DataType>::solve(const Matrix<DataType, Dynamic, Dynamic> &H,
-		          const Vector<DataType, Dynamic>          &f)
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+void QPSolver<DataType,N,C,M,Factorisation>::use_cold_start()
 {
-	if(H.rows() != H.cols())
-	{
-		throw invalid_argument("[ERROR] [QP SOLVER] solve(): "
-		                       "Expected a square matrix for the Hessian H but it was "
-		                       + to_string(H.rows()) + "x" + to_string(H.cols()) + ".");
-	}
-	else if(H.rows() != f.rows())
-	{	
-		throw invalid_argument("[ERROR] [QP SOLVER] solve(): "
-		                       "Dimensions of arguments do not match. "
-		                       "The Hessian H was " + to_string(H.rows()) + "x" + to_string(H.cols()) +
-		                       " and the f vector was " + to_string(f.size()) + "x1.");
-	}
-	else 	return H.ldlt().solve(-f);                                                          // Too easy lol ᕙ(▀̿̿ĺ̯̿̿▀̿ ̿) ᕗ
+	this->warmStart = false;
+	
+	std::cout << "[INFO] [QP SOLVER] Using a cold start for inequality constraints.\n";
 }
 
-  ////////////////////////////////////////////////////////////////////////////////////////////////////
- //           Solve an unconstrained least squares problem: min 0.5(y-A*x)'*W*(y-A*x)              //
-////////////////////////////////////////////////////////////////////////////////////////////////////
-template <class DataType> inline
-Vector<DataType,Dynamic>
-QPSolver<DataType>::least_squares(const Vector<DataType, Dynamic>          &y,
-                                  const Matrix<DataType, Dynamic, Dynamic> &A,
-                                  const Matrix<DataType, Dynamic, Dynamic> &W)
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                     Set the number of threads used by the batch functions                      //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+bool QPSolver<DataType,N,C,M,Factorisation>::set_num_threads(const unsigned int &number)
 {
-	if(A.rows() < A.cols())                                                                     // Redundant system, use other function
+	if(number == 0)
 	{
-		throw invalid_argument("[ERROR] [QP SOLVER] least_squares(): "
-		                       "The A matrix has more rows than columns ("
-		                       + to_string(A.rows()) + "x" + to_string(A.cols()) + "). "
-		                       "Did you mean to call redundant_least_squares()?");	                    		                   
+		cerr << "[ERROR] [QP SOLVER] set_num_threads(): "
+		     << "Input argument was 0 but it must be greater than zero.\n";
+		
+		return false;
 	}
-	if(W.rows() != W.cols())
+	else
 	{
-		throw invalid_argument("[ERROR] [QP SOLVER] least_squares(): "
-		                       "Expected a square weighting matrix W but it was "
-		                       + to_string(W.rows()) + "x" + to_string(W.cols()) + ".");
+		this->numThreads = number;                                                          // The pool is resized on the next batch
+		
+		return true;
 	}
-	else if(y.rows() != W.rows() and W.cols() != A.rows())
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //             Share the constraint rows between threads when assembling the barrier             //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+void QPSolver<DataType,N,C,M,Factorisation>::use_parallel_assembly()
+{
+	this->parallelAssembly = true;
+	
+	std::cout << "[INFO] [QP SOLVER] Sharing the constraints between threads when assembling the barrier.\n";
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                        Assemble the barrier on the calling thread only                        //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+void QPSolver<DataType,N,C,M,Factorisation>::use_serial_assembly()
+{
+	this->parallelAssembly = false;
+	
+	std::cout << "[INFO] [QP SOLVER] Assembling the barrier on the calling thread.\n";
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //              Factorise the barrier in single precision with iterative refinement              //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+bool QPSolver<DataType,N,C,M,Factorisation>::use_mixed_precision(const unsigned int &maxRefinements)
+{
+	if(maxRefinements == 0)
 	{
-		throw invalid_argument("[ERROR] [QP SOLVER] least_squares(): "
-		                       "Dimensions of input arguments do not match. "
-		                       "The y vector was " + to_string(y.size()) + "x1, "
-		                       "the A matrix had " + to_string(A.rows()) + " rows, and "
-		                       "the weighting matrix W was " + to_string(W.rows()) + "x" + to_string(W.cols()) + ".");
+		cerr << "[ERROR] [QP SOLVER] use_mixed_precision(): "
+		     << "Input argument was 0 but it must be greater than zero.\n";
+		
+		return false;
 	}
-	else	return (A.transpose()*W*A).ldlt().solve(A.transpose()*W*y);                         // x = (A'*W*A)^-1*A'*W*y
+	
+	this->maxRefinements = maxRefinements;
+	
+	std::cout << "[INFO] [QP SOLVER] Factorising the barrier in single precision with up to "
+	          << maxRefinements << " refinement steps.\n";
+	
+	return true;
 }
 
-  ////////////////////////////////////////////////////////////////////////////////////////////////////
- //    Solve least squares problem of the form min 0.5*(xd - x)'*W*(xd - x) subject to: A*x = y    //
-////////////////////////////////////////////////////////////////////////////////////////////////////
-template <class DataType> inline
-Vector<DataType,Dynamic>
-QPSolver<DataType>::redundant_least_squares(const Vector<DataType, Dynamic>          &xd,
-                                            const Matrix<DataType, Dynamic, Dynamic> &W,
-                                            const Matrix<DataType, Dynamic, Dynamic> &A,
-                                            const Vector<DataType, Dynamic>          &y)
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                            Factorise the barrier in full precision                            //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+void QPSolver<DataType,N,C,M,Factorisation>::use_full_precision()
 {
-	if(A.rows() >= A.cols())
+	this->maxRefinements = 0;
+	
+	std::cout << "[INFO] [QP SOLVER] Factorising the barrier in full precision.\n";
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                     Solve the Newton step in the space of the constraints                     //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+void QPSolver<DataType,N,C,M,Factorisation>::use_constraint_space()
+{
+	this->newtonSpace = constraintSpace;
+	
+	std::cout << "[INFO] [QP SOLVER] Solving the Newton step in the space of the constraints.\n";
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                      Solve the Newton step in the space of the variables                      //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+void QPSolver<DataType,N,C,M,Factorisation>::use_full_space()
+{
+	this->newtonSpace = fullSpace;
+	
+	std::cout << "[INFO] [QP SOLVER] Solving the Newton step in the space of the variables.\n";
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                   Choose the space of the Newton step from the problem size                   //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+void QPSolver<DataType,N,C,M,Factorisation>::use_automatic_space()
+{
+	this->newtonSpace = automaticSpace;
+	
+	std::cout << "[INFO] [QP SOLVER] Choosing the space of the Newton step from the problem size.\n";
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                             Solve a batch of problems in parallel                              //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+typename QPSolver<DataType,N,C,M,Factorisation>::SolutionList
+QPSolver<DataType,N,C,M,Factorisation>::run_batch(const unsigned int &numProblems,
+                                                  const std::function<Vector<DataType,N>(QPSolver&,const unsigned int&)> &solve)
+{
+	start_thread_pool();
+	
+	SolutionList solutions(numProblems);
+	
+	this->threadPool->run(numProblems, [&](QPSolver &solver, const unsigned int &i)
 	{
-		throw invalid_argument("[ERROR] [QP SOLVER] redundant_least_squares(): "
-		                       "The equality constraint matrix has more rows than columns ("
-		                       + to_string(A.rows()) + " >= " + to_string(A.cols()) + "). "
-		                       "Did you mean to call the other least squares function?");
-	}
-	else if(W.rows() != W.cols())
+		record(solver, solutions[i], [&]{ return solve(solver,i); });
+	});
+	
+	return solutions;
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                   Size the thread pool and give its solvers the same options                   //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+void QPSolver<DataType,N,C,M,Factorisation>::start_thread_pool()
+{
+	if(not this->threadPool or this->threadPool->size() != this->numThreads)
 	{
-		throw invalid_argument("[ERROR] [QP SOLVER] redundant_least_squares(): "
-		                       "Expected the weighting matrix to be square but it was "
-		                       + to_string(W.rows()) + "x" + to_string(W.cols()) + ".");
+		this->threadPool.reset();                                                           // Join the old threads first
+		this->threadPool.reset(new ThreadPool(this->numThreads));
 	}
-	else if(xd.size() != W.rows() or W.cols() != A.cols())
-	{	
-		throw invalid_argument("[ERROR] [QP SOLVER] redundant_least_squares(): "
-		                       "Dimensions for the decision variable do not match. "
-		                       "The desired vector had " + to_string(xd.size()) + " elements, "
-		                       "the weighting matrix was " + to_string(W.rows()) + "x" + to_string(W.cols()) + ", and "
-		                       "the constraint matrix had " + to_string(A.cols()) + " columns.");
-        }
-        else if(y.size() != A.rows())
-        {    	
-        	throw invalid_argument("[ERROR] [QP SOLVER] redundant_least_squares(): "
-        	                       "Dimensions for the equality constraint do not match. "
-        	                       "The constraint vector had " + to_string(y.size()) + " elements, and "
-        	                       "the constraint matrix had " + to_string(A.rows()) + " rows.");
-        }
-        else
-        {   		
-		MatrixXf invWA = W.ldlt().solve(A.transpose());                                     // Makes calcs a little easier
+	
+	for(auto &solver : this->threadPool->solvers)
+	{
+		copy_options(*solver);
 		
-		return xd + invWA*(A*invWA).ldlt().solve(y - A*xd);                                 // xd + W^-1*A'*(A*W^-1*A')^-1*(y-A*xd)
+		solver->warmStart = false;                                                          // The problems are independent
 	}
 }
 
-  ////////////////////////////////////////////////////////////////////////////////////////////////////
- //      Solve a constrained problem: min 0.5*(y - A*x)'*W*(y - A*x) s.t. xMin <= x <= xMax        //
-////////////////////////////////////////////////////////////////////////////////////////////////////
-template <class DataType> inline
-Vector<DataType,Dynamic>
-QPSolver<DataType>::constrained_least_squares(const Vector<DataType, Dynamic>           &y,
-                                              const Matrix<DataType, Dynamic, Dynamic>  &A,
-                                              const Matrix<DataType, Dynamic, Dynamic>  &W,
-                                              const Vector<DataType, Dynamic>           &xMin,
-                                              const Vector<DataType, Dynamic>           &xMax,
-                                              const Vector<DataType, Dynamic>           &x0)
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                          Copy the options of this object to another                           //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+void QPSolver<DataType,N,C,M,Factorisation>::copy_options(QPSolver &solver) const
 {
-	// Ensure that the input arguments are sound.
-	if(y.size() != A.rows() or A.rows() != W.rows())
+	if(solver.algorithm != this->algorithm) solver.lastCall = none;                             // It uses different memory
+	
+	solver.tol                  = this->tol;
+	solver.barrierReductionRate = this->barrierReductionRate;
+	solver.initialBarrierScalar = this->initialBarrierScalar;
+	solver.kktTol               = this->kktTol;
+	solver.algorithm            = this->algorithm;
+	solver.method               = this->method;
+	solver.maxSteps             = this->maxSteps;
+	solver.adaptiveBarrier      = this->adaptiveBarrier;
+	solver.newtonSpace          = this->newtonSpace;
+	solver.timeBudget           = this->timeBudget;
+	solver.deadline             = this->deadline;
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                           Set the configurations raced in a portfolio                          //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+bool QPSolver<DataType,N,C,M,Factorisation>::set_portfolio(const std::vector<Configuration> &configurations)
+{
+	if(configurations.empty())
 	{
-		throw invalid_argument("[ERROR] [QP SOLVER] constrained_least_squares(): "
-		                       "Dimensions of the linear equation do not match. "
-		                       "The y vector had " + to_string(y.size()) + " elements, "
-		                       "the A matrix had " + to_string(A.rows()) + " rows, and "
-		                       "the weighting matrix W had " + to_string(W.rows()) + " rows.");
+		cerr << "[ERROR] [QP SOLVER] set_portfolio(): "
+		     << "There must be at least one configuration.\n";
+		
+		return false;
 	}
-	else if(W.rows() != W.cols())
+	
+	this->portfolio.clear();
+	
+	for(const Configuration &configure : configurations)
 	{
-		throw invalid_argument("[ERROR] [QP SOLVER] constrained_least_squares(): "
-		                       "Expected the weighting matrix W to be square, but it was "
-		                       + to_string(W.rows()) + "x" + to_string(W.cols()) + ".");
+		this->portfolio.emplace_back(new QPSolver());
+		
+		QPSolver &solver = *this->portfolio.back();
+		
+		copy_options(solver);
+		
+		solver.warmStart      = this->warmStart;                                            // Each configuration resumes from its own last solution
+		solver.maxRefinements = this->maxRefinements;
+		solver.cancelFlag     = &this->portfolioDone;
+		
+		if(configure) configure(solver);
 	}
-	else if(A.cols() != xMin.size() or xMin.size() != xMax.size() or xMax.size() != x0.size())
+	
+	this->portfolioWins.assign(configurations.size(), 0);
+	this->portfolioWinner = 0;
+	
+	return true;
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                  Race the configurations of the portfolio on the thread pool                  //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+Vector<DataType,N>
+QPSolver<DataType,N,C,M,Factorisation>::run_portfolio(const std::function<Vector<DataType,N>(QPSolver&)> &solve,
+                                                      const std::function<DataType(const Vector<DataType,N>&)> &objective)
+{
+	if(this->portfolio.empty())
 	{
-		throw invalid_argument("[ERROR] [QP SOLVER] constrained_least_squares(): "
-		                       "Dimensions for decision variable do not match. "
-		                       "The A matrix had " + to_string(A.cols()) + " columns, "
-		                       "the xMin argument had " + to_string(xMin.size()) + " elements, "
-		                       "the xMax argument had " + to_string(xMax.size()) + " elements, and "
-		                       "the start point x0 had " + to_string(x0.size()) + " elements.");
+		throw runtime_error("[ERROR] [QP SOLVER] solve_portfolio(): "
+		                    "Call set_portfolio() first.");
 	}
 	
-	// Convert to standard form and solve with the interior point algorithm
+	unsigned int numConfigurations = this->portfolio.size();
 	
-	unsigned int n = x0.size();
+	start_thread_pool();
 	
-	// B = [  I ] < z = [  xMax ]
-	//     [ -I ]       [ -xMin ]
+	SolutionList solutions(numConfigurations);
 	
-	Matrix<DataType,Dynamic,Dynamic> B(2*n,n);
-	B.block(0,0,n,n).setIdentity();
-	B.block(n,0,n,n) = -Matrix<DataType,Dynamic,Dynamic>::Identity(n,n);
+	std::mutex mutex;                                                                           // Protects the winner
+	int winner = -1;
 	
-	Vector<DataType,Dynamic> z(2*n);
-	z.head(n) =  xMax;
-	z.tail(n) = -xMin;
+	this->portfolioDone = false;
 	
-	Matrix<DataType,Dynamic,Dynamic> AtW = A.transpose()*W;                                     // Makes calcs a tiny bit faster
-
-	return solve(AtW*A, -AtW*y, B, z, x0);                                                      // Send to interior point algorithm and solve
-}
-
-  ////////////////////////////////////////////////////////////////////////////////////////////////////
- //    Solve a constrained problem min 0.5*(xd - x)'*W*(xd - x) s.t. A*x = y, xMin <= x <= xMax    //
-////////////////////////////////////////////////////////////////////////////////////////////////////
-template <class DataType> inline
-Vector<DataType,Dynamic>
-QPSolver<DataType>::constrained_least_squares(const Vector<DataType, Dynamic>           &xd,
-                                              const Matrix<DataType, Dynamic, Dynamic>  &W,
-                                              const Matrix<DataType, Dynamic, Dynamic>  &A,
-                                              const Vector<DataType, Dynamic>           &y,
-                                              const Vector<DataType, Dynamic>           &xMin,
-                                              const Vector<DataType, Dynamic>           &xMax,
-                                              const Vector<DataType, Dynamic>           &x0)
-{
-	if(xMin.size() != xMax.size())
+	this->threadPool->run(numConfigurations, [&](QPSolver&, const unsigned int &i)
 	{
-		throw invalid_argument("[ERROR] [QP SOLVER] constrained_least_squares(): "
-		                       "Dimensions of inequality constraints do not match. "
-		                       "The xMin argument had " + to_string(xMin.size()) + " elements, and "
-		                       "the xMax argument had " + to_string(xMax.size()) + " elements.");
+		QPSolver &solver = *this->portfolio[i];
+		
+		solver.converged = false;                                                           // In case it throws before the algorithm starts
+		
+		record(solver, solutions[i], [&]{ return solve(solver); });
+		
+		if((solutions[i].status == solved and solver.converged) or solutions[i].status == infeasible)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			
+			if(winner < 0)
+			{
+				winner = i;
+				this->portfolioDone = true;                                         // The others stop on their next step
+			}
+		}
+	});
+	
+	// If none of them converged, take the best of those that were solved or ran out of time
+	auto usable = [&solutions](const unsigned int &i)
+	{
+		return solutions[i].status == solved or solutions[i].status == timedOut;
+	};
+	
+	for(unsigned int i = 0; i < numConfigurations and winner < 0; i++)
+	{
+		if(not usable(i)) continue;
+		
+		DataType best = objective(solutions[i].x);
+		winner = i;
+		
+		for(unsigned int j = i+1; j < numConfigurations; j++)
+		{
+			if(usable(j) and objective(solutions[j].x) < best)
+			{
+				best = objective(solutions[j].x);
+				winner = j;
+			}
+		}
 	}
-		                       
-	// Convert constraints to standard form and pass on to generic function
 	
-	unsigned int n = xMin.size();
+	if(winner < 0)
+	{
+		if(solutions[0].status == invalidArgument)                                          // The arguments are the same for all
+		{
+			throw invalid_argument("[ERROR] [QP SOLVER] solve_portfolio(): "
+			                       "Dimensions of input arguments do not match.");
+		}
+		
+		throw runtime_error("[ERROR] [QP SOLVER] solve_portfolio(): "
+		                    "None of the configurations could solve the problem.");
+	}
 	
-	// B = [  I ] < z = [  xMax ]
-	//     [ -I ]     = [ -xMin ]
+	this->portfolioWinner = winner;
+	this->portfolioWins[winner]++;
 	
-	Matrix<DataType,Dynamic,Dynamic> B(2*n,n);
-	B.block(0,0,n,n).setIdentity();
-	B.block(n,0,n,n) = -Matrix<DataType,Dynamic,Dynamic>::Identity(n,n);
+	const QPSolver &solver = *this->portfolio[winner];
 	
-	Vector<DataType,Dynamic> z(2*n);
-	z.head(n) =  xMax;
-	z.tail(n) = -xMin;
+	this->numSteps     = solver.numSteps;
+	this->stepSize     = solver.stepSize;
+	this->lastStatus   = solver.lastStatus;
+	this->certificate  = solver.certificate;
+	this->lastSolution = solutions[winner].x;
 	
-	return constrained_least_squares(xd, W, A, y, B, z, x0);
+	return this->lastSolution;
 }
 
-  ////////////////////////////////////////////////////////////////////////////////////////////////////
- //        Solve a constrained problem min 0.5*(xd - x)'*W*(xd - x) s.t. A*x = y, B*x < z          //
-////////////////////////////////////////////////////////////////////////////////////////////////////
-template <class DataType> inline
-Vector<DataType,Dynamic>
-QPSolver<DataType>::constrained_least_squares(const Vector<DataType, Dynamic>          &xd,
-                                              const Matrix<DataType, Dynamic, Dynamic> &W,
-                                              const Matrix<DataType, Dynamic, Dynamic> &A,
-                                              const Vector<DataType, Dynamic>          &y,
-                                              const Matrix<DataType, Dynamic, Dynamic> &B,
-                                              const Vector<DataType, Dynamic>          &z,
-                                              const Vector<DataType, Dynamic>          &x0)
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                       Set the time limit for each call with constraints                        //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+bool QPSolver<DataType,N,C,M,Factorisation>::set_time_budget(const double &seconds)
 {
-	// Ensure input arguments are sound
-	if(xd.size() != W.rows() or W.rows() != A.cols() or A.cols() != B.cols() or B.cols() != x0.size())
-	{
-		throw invalid_argument("[ERROR] [QP SOLVER] constrained_least_squares(): "
-		                       "Dimensions for decision variable do not match. "
-		                       "The desired value xd had " + to_string(xd.size()) + " elements, "
-		                       "the weighting matrix W had " + to_string(W.rows()) + " rows, "
-		                       "the equality constraint matrix A had " + to_string(A.cols()) + " columns, "
-		                       "the inequality constraint matrix B had " + to_string(B.cols()) + " columns, and "
-		                       "the start point x0 had " + to_string(x0.size()) + " elements.");
-	}
-	else if(W.rows() != W.cols())
-	{
-		throw invalid_argument("[ERROR] [QP SOLVER] constrained_least_squares(): "
-		                       "Expected the weighting matrix W to be square, but it was "
-		                       + to_string(W.rows()) + "x" + to_string(W.cols()) + ".");
-	}
-	else if(A.rows() != y.size())
+	if(seconds < 0)
 	{
-		throw invalid_argument("[ERROR] [QP SOLVER] constrained_least_squares(): "
-		                       "Dimensions for equality constraint do not match. "
-		                       "The equality constraint matrix A had " + to_string(A.rows()) + " rows, and "
-		                       "the equality constraint vector y had " + to_string(y.size()) + " elements.");
+		cerr << "[ERROR] [QP SOLVER] set_time_budget(): "
+		     << "Input argument was " << to_string(seconds) << " but it cannot be negative.\n";
+		
+		return false;
 	}
-	else if(B.rows() != z.rows())
+	else
 	{
-		throw invalid_argument("[ERROR] [QP SOLVER] constrained_least_squared(): "
-		                       "Dimensions for inequality constraint do no match. "
-		                       "The inequality constraint matrix B had " + to_string(B.rows()) + " rows, and "
-		                       "the inequality constraint vector z had " + to_string(z.size()) + " elements.");
+		this->timeBudget = seconds;
+		
+		return true;
 	}
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                               Solve a problem on another thread                                //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+std::future<typename QPSolver<DataType,N,C,M,Factorisation>::Solution>
+QPSolver<DataType,N,C,M,Factorisation>::run_async(const std::function<Vector<DataType,N>()> &solve)
+{
+	this->cancelRequested = false;                                                              // Only cancel this call
 	
-	if(this->method == primal)
-	{	
-		unsigned int c = B.rows();                                                          // Number of inequality constraints
-		unsigned int m = A.rows();                                                          // Number of equality constraints
-		unsigned int n = A.cols();                                                          // Decision variable
-		
-		// H = [  0  -A ]
-		//     [ -A'  W ]
-		Matrix<DataType,Dynamic,Dynamic> H(m+n,m+n);
-		H.block(0,0,m,m).setZero();
-		H.block(0,m,m,n) = -A;
-		H.block(m,0,n,m) = -A.transpose();
-		H.block(m,m,n,n) = W;
-		
-		// f = [    y  ]
-		//     [ -W*xd ]
-		Vector<DataType,Dynamic> f(m+n);
-		f.head(m) = y;
-		f.tail(n) = -W*xd;
+	return std::async(std::launch::async, [this, solve]
+	{
+		const std::atomic<bool> *previous = this->cancelFlag;
 		
-		// new_x0 = [ lambda ]
-		//          [   x0   ]
-		Vector<DataType,Dynamic> new_x0(m+n);
-		new_x0.head(m) = (A*W.ldlt().solve(A.transpose())).ldlt().solve(y - A*xd);          // Initial guess for Lagrange multipliers
-		new_x0.tail(n) = x0;
+		this->cancelFlag = &this->cancelRequested;
 		
-		// newB = [ 0 B ]
-		Matrix<DataType,Dynamic,Dynamic> newB(c,m+n);
-		newB.block(0,0,c,m).setZero();
-		newB.block(0,m,c,n) = B;
+		Solution solution;
 		
-		this->lastSolution = solve(H,f,newB,z,new_x0).tail(n);                              // We don't need the Lagrange multipliers
+		record(*this, solution, solve);
 		
-		return this->lastSolution;                                                          // Return decision variable x
+		this->cancelFlag = previous;
+		
+		return solution;
+	});
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                          Solve a generic QP problem on another thread                          //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+std::future<typename QPSolver<DataType,N,C,M,Factorisation>::Solution>
+QPSolver<DataType,N,C,M,Factorisation>::solve_async(const Matrix<DataType,N,N> &H,
+                                                    const Vector<DataType,N>   &f,
+                                                    const Matrix<DataType,C,N> &B,
+                                                    const Vector<DataType,C>   &z,
+                                                    const Vector<DataType,N>   &x0)
+{
+	std::shared_ptr<ProblemCopy> p(new ProblemCopy{H, f, B, z, x0});
+	
+	return run_async([this, p]{ return this->solve(p->H, p->f, p->B, p->z, p->x0); });
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //          Solve a redundant least squares problem with inequalities on another thread           //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+std::future<typename QPSolver<DataType,N,C,M,Factorisation>::Solution>
+QPSolver<DataType,N,C,M,Factorisation>::constrained_least_squares_async(const Vector<DataType,N>   &xd,
+                                                                        const Matrix<DataType,N,N> &W,
+                                                                        const Matrix<DataType,M,N> &A,
+                                                                        const Vector<DataType,M>   &y,
+                                                                        const Matrix<DataType,C,N> &B,
+                                                                        const Vector<DataType,C>   &z,
+                                                                        const Vector<DataType,N>   &x0)
+{
+	std::shared_ptr<LeastSquaresProblemCopy> p(new LeastSquaresProblemCopy{xd, W, A, y, B, z, x0});
+	
+	return run_async([this, p]{ return this->constrained_least_squares(p->xd, p->W, p->A, p->y, p->B, p->z, p->x0); });
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                       Solve a generic QP problem with a portfolio of solvers                   //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+Vector<DataType,N>
+QPSolver<DataType,N,C,M,Factorisation>::solve_portfolio(const Matrix<DataType,N,N> &H,
+                                                        const Vector<DataType,N>   &f,
+                                                        const Matrix<DataType,C,N> &B,
+                                                        const Vector<DataType,C>   &z,
+                                                        const Vector<DataType,N>   &x0)
+{
+	return run_portfolio([&](QPSolver &solver){ return solver.solve(H,f,B,z,x0); },
+	                     [&](const Vector<DataType,N> &x){ return DataType(0.5)*x.dot(H*x) + x.dot(f); });
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //           Solve a redundant least squares problem with bounds with a portfolio of solvers      //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+Vector<DataType,N>
+QPSolver<DataType,N,C,M,Factorisation>::constrained_least_squares_portfolio(const Vector<DataType,N>   &xd,
+                                                                            const Matrix<DataType,N,N> &W,
+                                                                            const Matrix<DataType,M,N> &A,
+                                                                            const Vector<DataType,M>   &y,
+                                                                            const Vector<DataType,N>   &xMin,
+                                                                            const Vector<DataType,N>   &xMax,
+                                                                            const Vector<DataType,N>   &x0)
+{
+	return run_portfolio([&](QPSolver &solver){ return solver.constrained_least_squares(xd,W,A,y,xMin,xMax,x0); },
+	                     [&](const Vector<DataType,N> &x){ return DataType(0.5)*(xd - x).dot(W*(xd - x)); });
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //    Solve a redundant least squares problem with inequalities with a portfolio of solvers       //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+Vector<DataType,N>
+QPSolver<DataType,N,C,M,Factorisation>::constrained_least_squares_portfolio(const Vector<DataType,N>   &xd,
+                                                                            const Matrix<DataType,N,N> &W,
+                                                                            const Matrix<DataType,M,N> &A,
+                                                                            const Vector<DataType,M>   &y,
+                                                                            const Matrix<DataType,C,N> &B,
+                                                                            const Vector<DataType,C>   &z,
+                                                                            const Vector<DataType,N>   &x0)
+{
+	return run_portfolio([&](QPSolver &solver){ return solver.constrained_least_squares(xd,W,A,y,B,z,x0); },
+	                     [&](const Vector<DataType,N> &x){ return DataType(0.5)*(xd - x).dot(W*(xd - x)); });
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                      Solve one problem in a batch, and record the outcome                      //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+void QPSolver<DataType,N,C,M,Factorisation>::record(const QPSolver                        &solver,
+                                                    Solution                              &solution,
+                                                    const std::function<Vector<DataType,N>()> &solve)
+{
+	try
+	{
+		solution.x        = solve();
+		solution.status   = solver.lastStatus;
+		solution.numSteps = solver.numSteps;
 	}
-	else if(this->method == dual)
+	catch(const std::invalid_argument &exception)
 	{
-		// x = xd + W^-1*A'*lambda
-		
-		// lambda = (A*W^-1*A')^-1*(y - A*xd)
-		
-		Matrix<DataType,Dynamic,Dynamic> invWAt = W.ldlt().solve(A.transpose());            // Makes calcs a little easier
+		cerr << exception.what() << "\n";
 		
-		Matrix<DataType,Dynamic,Dynamic> H = A*invWAt;                                      // Hessian matrix for dual problem
-		
-		LDLT<Matrix<DataType,Dynamic,Dynamic>> Hdecomp(H);                                  // Saves a bit of time
+		solution.status = invalidArgument;
+	}
+	catch(const std::exception &exception)
+	{
+		cerr << exception.what() << "\n";
 		
-		Vector<DataType,Dynamic> xr = invWAt*(H,-y,B*invWAt,z,Hdecomp.solve(y));            // Solve the range space
+		solution.status = failed;
+	}
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //                        Solve a batch of generic QP problems in parallel                        //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+typename QPSolver<DataType,N,C,M,Factorisation>::SolutionList
+QPSolver<DataType,N,C,M,Factorisation>::solve_batch(const std::vector<Problem> &problems)
+{
+	return run_batch(problems.size(), [&problems](QPSolver &solver, const unsigned int &i)
+	{
+		const Problem &p = problems[i];
 		
-		Vector<DataType,Dynamic> xn = xd - invWAt*Hdecomp.solve(A*xd);                      // Compute null space component
+		return solver.solve(p.H, p.f, p.B, p.z, p.x0);
+	});
+}
+
+  ///////////////////////////////////////////////////////////////////////////////////////////////////
+ //             Solve a batch of small problems with the same dimensions in lockstep              //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+template <int Lanes>
+typename QPSolver<DataType,N,C,M,Factorisation>::SolutionList
+QPSolver<DataType,N,C,M,Factorisation>::solve_lockstep(const std::vector<Problem> &problems)
+{
+	static_assert(Lanes > 0, "[ERROR] [QP SOLVER] solve_lockstep(): Number of lanes must be positive.");
+	
+	SolutionList solutions(problems.size());
+	
+	if(problems.size() == 0) return solutions;
+	
+	unsigned int n = problems[0].H.rows();
+	unsigned int c = problems[0].B.rows();
+	
+	// Group the problems with the expected dimensions
+	std::vector<std::vector<unsigned int>> groups;
+	
+	for(unsigned int i = 0; i < problems.size(); i++)
+	{
+		const Problem &p = problems[i];
 		
-		DataType alpha = 1.0;
-		for(int i = 0; i < z.size(); i++)
+		if(p.H.rows() != n or p.H.cols() != n or p.f.size() != n or p.x0.size() != n
+		or p.B.rows() != c or p.B.cols() != n or p.z.size() != c)
 		{
-			DataType a = B.row(i).dot(xr);
+			cerr << "[ERROR] [QP SOLVER] solve_lockstep(): "
+			     << "Expected every problem to have " << n << " variables and " << c << " constraints "
+			     << "like the first one, but problem " << i << " had H as " << p.H.rows() << "x" << p.H.cols() << ", "
+			     << "f with " << p.f.size() << " elements, B as " << p.B.rows() << "x" << p.B.cols() << ", "
+			     << "z with " << p.z.size() << " elements, and x0 with " << p.x0.size() << " elements.\n";
 			
-			DataType b = B.row(i).dot(xn);
-			
-			DataType dist = z(i) - a - b;
+			solutions[i].status = invalidArgument;
+		}
+		else
+		{
+			if(groups.empty() or groups.back().size() == Lanes) groups.emplace_back();
 			
-			if(dist <= 0) alpha = min(alpha, 0.99*abs((dist - a)/b));
+			groups.back().push_back(i);
 		}
-		
-		this->lastSolution = xr + alpha*xn;
-		
-		return this->lastSolution;
 	}
-	else
+	
+	start_thread_pool();
+	
+	this->threadPool->run(groups.size(), [&](QPSolver &solver, const unsigned int &i)
 	{
-		throw runtime_error("[ERROR] [QP SOLVER] constrained_least_squares(): "
-		                    "Method for solving redundant least squares was neither 'dual' "
-		                    "nor 'primal'. How did that happen?");
-	}
+		solver.template lockstep_interior_point<Lanes>(problems, groups[i], solutions);
+	});
+	
+	return solutions;
 }
 
   ///////////////////////////////////////////////////////////////////////////////////////////////////
- //          Solve a problem of the form: min 0.5*x'*H*x + x'*f subject to: B*x <= z              //        
+ //             The barrier method for a group of problems, interleaved across lanes              //
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-template <class DataType> inline
-Vector<DataType,Dynamic>
-QPSolver<DataType>::solve(const Matrix<DataType, Dynamic, Dynamic> &H,
-                          const Vector<DataType,Dynamic>           &f,
-                          const Matrix<DataType, Dynamic, Dynamic> &B,
-                          const Vector<DataType,Dynamic>           &z,
-                          const Vector<DataType,Dynamic>           &x0)
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+template <int Lanes>
+void
+QPSolver<DataType,N,C,M,Factorisation>::lockstep_interior_point(const std::vector<Problem>      &problems,
+                                                                const std::vector<unsigned int> &group,
+                                                                SolutionList                    &solutions)
 {
-	// Ensure arguments are sound
-	if(H.rows() != H.cols())
-	{
-		throw invalid_argument("[ERROR] [QP SOLVER] solve(): "
-		                       "Expected the Hessian matrix H to be square but it was " 
-		                       + to_string(H.rows()) + "x" + to_string(H.cols()) + ".");
-	}
-	else if(H.cols() != f.size() or f.size() != B.cols() or B.cols() != x0.size())
-	{
-		throw invalid_argument("[ERROR] [QP SOLVER] solve(): "
-		                       "Dimensions of arguments for decision variable do not match. "
-		                       "The Hessian matrix had " + to_string(H.cols()) + " rows/columns, "
-		                       "the vector f had " + to_string(f.size()) + " elements, "
-		                       "the inequality constraint matrix B had " + to_string(B.cols()) + " columns, and "
-		                       "the start point x0 had " + to_string(x0.size()) + " elements.");
-	}
-	else if(B.rows() != z.size())
-	{
-		throw invalid_argument("[ERROR] [QP SOLVER] solve(): "
-		                       "Dimensions for inequality constraint do not match. "
-		                       "The inequality constraint matrix B had " + to_string(B.rows()) + " rows, and "
-		                       "the inequality constraint vector z had " + to_string(z.size()) + " elements.");
-	}
+	// Column k of each array is element k of every problem in the group, so that the operations
+	// below act on every problem at once. Unused lanes repeat the first problem and are masked out.
 	
-	// h = 0.5*x'*H*x + x'*f - sum log(d_i),   d_i = z_i - b_i'*x
-	// g = H*x + f + sum (1/d_i)*b_i
-	// I = H + sum (1/d_i^2)*b_i*b_i'
+	typedef Array<DataType,Lanes,1>       Lane;
+	typedef std::vector<Lane,aligned_allocator<Lane>> LaneVector;
 	
-	// Variables used in this scope
-	DataType u = this->initialBarrierScalar;                                                    // As it says
-	unsigned int dim = x0.size();                                                               // Dimensions of the decision varialbe
-	unsigned int numConstraints = z.size();                                                     // As it says
-	Matrix<DataType,Dynamic,Dynamic> I(dim,dim);                                                // Hessian matrix
-	Vector<DataType,Dynamic> g(dim);                                                            // Gradient vector
-	vector<DataType> d(numConstraints);                                                         // Distance to every constraint
-	vector<Vector<DataType,Dynamic>> b(numConstraints);                                         // Row vectors of constraint matrix (transposed)
-	vector<Matrix<DataType,Dynamic,Dynamic>> bbt(numConstraints);                               // Outer product of row vectors
-	Vector<DataType,Dynamic> x(dim);                                                            // We want to solve for this
+	unsigned int n = problems[group[0]].H.rows();
+	unsigned int c = problems[group[0]].B.rows();
+	
+	LaneVector H(n*n), B(c*n), f(n), z(c), x(n);                                                // H(i,j) is column i + j*n, B(k,j) is column k + j*c
+	LaneVector L(n*n), Bw(c*n), g(n), dx(n), d(c), w(c), Bdx(c);
+	
+	Lane active = Lane::Zero();                                                                 // 1 if the problem is still being solved, 0 otherwise
+	Lane steps  = Lane::Zero();                                                                 // Number of steps for each problem
 	
-	// Do some pre-processing
-	bool initialConstraintViolated = false;
-	for(int j = 0; j < numConstraints; j++)
+	std::vector<bool> fallback(Lanes, false);                                                   // Solve these one at a time
+	
+	for(unsigned int k = 0; k < Lanes; k++)
 	{
-		b[j]   = B.row(j).transpose();                                                      // Transpose the row vector
-		bbt[j] = b[j]*b[j].transpose();                                                     // Compute the outer product
-
-		d[j] = z(j) - b[j].dot(x0);                                                         // Distance to constraint
+		const Problem &p = problems[group[k < group.size() ? k : 0]];
+		
+		for(unsigned int j = 0; j < n*n; j++) H[j](k) = p.H(j%n,j/n);
+		for(unsigned int j = 0; j < c*n; j++) B[j](k) = p.B(j%c,j/c);
+		
+		for(unsigned int j = 0; j < n; j++)
+		{
+			f[j](k) = p.f(j);
+			x[j](k) = p.x0(j);
+		}
 		
-		if(d[j] <= 0) initialConstraintViolated = true;                                     // Flag
+		for(unsigned int j = 0; j < c; j++) z[j](k) = p.z(j);
+		
+		if(k < group.size()) active(k) = 1;
 	}
 	
-	// Set the start point
-	if(initialConstraintViolated)
+	// d = z - B*x
+	auto distance = [&]()
+	{
+		d = z;
+		for(unsigned int j = 0; j < n; j++)
+		{
+			for(unsigned int k = 0; k < c; k++) d[k] -= B[k + j*c]*x[j];
+		}
+	};
+	
+	distance();
+	
+	for(unsigned int k = 0; k < group.size(); k++)
 	{
-		Vector<DataType,Dynamic> dz = 1e-03*Vector<DataType,Dynamic>::Ones(numConstraints);       // Add a tiny offset so we're not exactly on the constraint      
+		bool inside = true;
 		
-		     if(numConstraints > dim) x = (B.transpose()*B).ldlt().solve(B.transpose()*(z - dz)); // Underdetermined system
-		else if(numConstraints < dim) x =  B.transpose()*(B*B.transpose()).ldlt().solve(z - dz);  // Overdetermined system
-		else			      x =  B.partialPivLu().solve(z - dz);                        // Exact solution
+		for(unsigned int j = 0; j < c; j++) inside &= d[j](k) > 0;
+		
+		if(not inside)                                                                      // The start point needs to be moved
+		{
+			fallback[k] = true;
+			active(k)   = 0;
+		}
 	}
-	else	x = x0;                                                                                   // Given start point
 	
-	// Run the interior point algorithm
-	for(int i = 0; i < this->maxSteps; i++)
+	DataType u = this->initialBarrierScalar;
+	
+	for(int i = 0; i < this->maxSteps and (active > 0).any(); i++)
 	{
-		this->numSteps = i+1;                                                               // Increment the counter
+		steps += active;
+		
+		distance();
+		
+		// g = H*x + f + B'*(u/d)
+		for(unsigned int k = 0; k < c; k++)
+		{
+			d[k] = (d[k] <= 0).select(DataType(1e-03), d[k]);                           // Constraint violated; set a small, but non-zero distance
+			
+			w[k] = u*d[k].inverse();
+		}
 		
-		// (Re)set values for new loop
-		g = H*x + f;                                                                        // Gradient vector
-		I = H;                                                                              // Hessian matrix
+		g = f;
+		for(unsigned int j = 0; j < n; j++)
+		{
+			for(unsigned int r = 0; r < n; r++) g[r] += H[r + j*n]*x[j];
+			
+			for(unsigned int k = 0; k < c; k++) g[j] += B[k + j*c]*w[k];
+		}
+		
+		// L = H + B'*diag(u/d^2)*B, lower triangle only
+		for(unsigned int k = 0; k < c; k++) w[k] /= d[k];
+		
+		for(unsigned int j = 0; j < c*n; j++) Bw[j] = B[j]*w[j%c];
+		for(unsigned int j = 0; j < n; j++)
+		{
+			for(unsigned int r = j; r < n; r++)
+			{
+				Lane sum = H[r + j*n];
+				
+				for(unsigned int k = 0; k < c; k++) sum += Bw[k + r*c]*B[k + j*c];
+				
+				L[r + j*n] = sum;
+			}
+		}
 		
-		// Compute distance to every constraint
-		for(int j = 0; j < numConstraints; j++)
+		// Cholesky decomposition L*L' in place
+		for(unsigned int j = 0; j < n; j++)
 		{
-			d[j] = z(j) - b[j].dot(x);                                                  // Distance to constraint
+			Lane pivot = L[j + j*n];
+			
+			for(unsigned int k = 0; k < j; k++) pivot -= L[j + k*n].square();
 			
-			if(i == 0 and d[j] <= 0)
+			Lane good = (pivot > 0).template cast<DataType>();
+			
+			if((active*(1 - good) > 0).any())                                           // Not positive definite
 			{
-				throw runtime_error("[ERROR] [QP SOLVER] solve(): Unable to find a solution that satisfies constraints.");
+				for(unsigned int k = 0; k < group.size(); k++)
+				{
+					if(active(k) > 0 and good(k) == 0)
+					{
+						fallback[k] = true;
+						active(k)   = 0;
+					}
+				}
 			}
 			
-			if(d[j] <= 0) d[j] = 1e-03;                                                 // Constraint violated; set a small, but non-zero distance
-		 
-			g += (u/d[j])*b[j];                                                         // Add up gradient
-			I += (u/(d[j]*d[j]))*bbt[j];                                                // Add up Hessian
+			L[j + j*n] = (pivot > 0).select(pivot, Lane::Ones()).sqrt();
+			
+			for(unsigned int r = j+1; r < n; r++)
+			{
+				Lane sum = L[r + j*n];
+				
+				for(unsigned int k = 0; k < j; k++) sum -= L[r + k*n]*L[j + k*n];
+				
+				L[r + j*n] = sum/L[j + j*n];
+			}
 		}
-
-		Vector<DataType,Dynamic> dx = I.ldlt().solve(-g);                                   // Compute Newton step
 		
-		// Compute scalar for step size so that constraint is not violated on next step
-		DataType alpha = 1.0;
-		for(int j = 0; j < numConstraints; j++)
+		// Solve L*L'*dx = -g
+		for(unsigned int r = 0; r < n; r++)
 		{
-			DataType dotProd = b[j].dot(dx);                                            // Makes calcs a little easier
+			Lane sum = -g[r];
 			
-			if(d[j] - dotProd <= 0) alpha = min(alpha,0.9*d[j]/dotProd);                // Shrink scalar if constraint violated
+			for(unsigned int k = 0; k < r; k++) sum -= L[r + k*n]*dx[k];
+			
+			dx[r] = sum/L[r + r*n];
 		}
 		
-		dx *= alpha;                                                                        // Scale the step
+		for(int r = n-1; r >= 0; r--)
+		{
+			Lane sum = dx[r];
+			
+			for(unsigned int k = r+1; k < n; k++) sum -= L[k + r*n]*dx[k];
+			
+			dx[r] = sum/L[r + r*n];
+		}
 		
-		this->stepSize = dx.norm();                                                         // Magnitude of the step size
+		// Compute scalar for step size so that constraint is not violated on next step
+		for(unsigned int k = 0; k < c; k++) Bdx[k].setZero();
+		for(unsigned int j = 0; j < n; j++)
+		{
+			for(unsigned int k = 0; k < c; k++) Bdx[k] += B[k + j*c]*dx[j];
+		}
 		
-		if(this->stepSize <= this->tol) break;                                              // If smaller than tolerance, break
+		Lane alpha = Lane::Ones();
+		for(unsigned int k = 0; k < c; k++)
+		{
+			alpha = (d[k] - Bdx[k] <= 0).select(alpha.min(0.9*d[k]/Bdx[k]), alpha);
+		}
+		
+		Lane stepSize = Lane::Zero();
+		for(unsigned int j = 0; j < n; j++) stepSize += dx[j].square();
+		stepSize = alpha*stepSize.sqrt();                                                   // Magnitude of the step size
+		
+		active = (stepSize <= this->tol).select(Lane::Zero(), active);                      // Stop if smaller than tolerance
+		
+		for(unsigned int j = 0; j < n; j++) x[j] += active*alpha*dx[j];                     // Increment state
 		
-		// Increment values for next loop
-		x += dx;                                                                            // Increment state
 		u *= this->barrierReductionRate;                                                    // Reduce barrier
 	}
 	
-	this->lastSolution = x;                                                                     // Save the value
-	
-	return x;
-}
-
-  ///////////////////////////////////////////////////////////////////////////////////////////////////
- //                  Set the rate at which the barrier scalar reduces: u *= beta                  //
-///////////////////////////////////////////////////////////////////////////////////////////////////
-template <class DataType>
-bool QPSolver<DataType>::set_barrier_reduction_rate(const DataType &rate)
-{
-	if(rate <= 0 or rate >= 1)
-	{
-		cerr << "[ERROR] [QP SOLVER] set_barrier_reduction_rate(): "
-		        "Input argument was " << to_string(rate) << " but it must be between 0 and 1.\n";
-		             
-		return false;
-	}
-	else
+	for(unsigned int k = 0; k < group.size(); k++)
 	{
-		this->barrierRedunctionRate = rate;
+		Solution &solution = solutions[group[k]];
 		
-		return true;
+		if(fallback[k])
+		{
+			const Problem &p = problems[group[k]];
+			
+			record(*this, solution, [&]{ return this->solve(p.H, p.f, p.B, p.z, p.x0); });
+		}
+		else
+		{
+			solution.x.resize(n);
+			for(unsigned int j = 0; j < n; j++) solution.x(j) = x[j](k);
+			
+			solution.status   = solved;
+			solution.numSteps = steps(k);
+		}
 	}
 }
 
   ///////////////////////////////////////////////////////////////////////////////////////////////////
- //       Set the magnitude of the step size for which the interior point method terminates       //
+ //                Solve a batch of constrained least squares problems in parallel                 //
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-template <class DataType>
-bool QPSolver<DataType>::set_tolerance(const DataType &tolerance)
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+typename QPSolver<DataType,N,C,M,Factorisation>::SolutionList
+QPSolver<DataType,N,C,M,Factorisation>::constrained_least_squares_batch(const std::vector<LeastSquaresProblem> &problems)
 {
-	if(tolerance <= 0)
-	{
-		cerr << "[ERROR] [QP SOLVER] set_tolerance(): "
-		     << "Input argument was " << to_string(tolerance) << " but it must be positive.\n";
-		 
-		return false;
-	}
-	else
+	return run_batch(problems.size(), [&problems](QPSolver &solver, const unsigned int &i)
 	{
-		this->tol = tolerance;
+		const LeastSquaresProblem &p = problems[i];
 		
-		return true;
-	}
+		return solver.constrained_least_squares(p.xd, p.W, p.A, p.y, p.B, p.z, p.x0);
+	});
 }
 
-  ///////////////////////////////////////////////////////////////////////////////////////////////////
- //            Set the number of steps in the interior point method before terminating            //
-///////////////////////////////////////////////////////////////////////////////////////////////////
-template <class DataType>
-bool QPSolver<DataType>::set_max_steps(const unsigned int &number)
+  ////////////////////////////////////////////////////////////////////////////////////////////////////
+ //                Use the log barrier interior point algorithm for inequalities                   //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+void QPSolver<DataType,N,C,M,Factorisation>::use_barrier_method()
 {
-	if(number == 0)
-	{
-		cerr << "[ERROR] [QP SOLVER] set_num_steps(): "
-		     << "Input argument was 0 but it must be greater than zero.\n";
-		
-		return false;
-	}
-	else
-	{
-		this->maxSteps = number;
-		
-		return true;
-	}
+	this->algorithm = barrier;
+	
+	this->lastCall = none;                                                                      // It uses different memory
+	
+	std::cout << "[INFO] [QP SOLVER] Using the barrier method for inequality constraints.\n";
 }
 
-  ///////////////////////////////////////////////////////////////////////////////////////////////////
- //               Set the scalar on the barrier function for inequality constraints               //
-///////////////////////////////////////////////////////////////////////////////////////////////////
-template <class DataType>
-bool QPSolver<DataType>::set_barrier_scalar(const DataType &scalar)
+  ////////////////////////////////////////////////////////////////////////////////////////////////////
+ //                Use the primal-dual interior point algorithm for inequalities                   //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+void QPSolver<DataType,N,C,M,Factorisation>::use_primal_dual_method()
 {
-	if(scalar <= 0)
-	{
-		cerr << "[ERROR] [QP SOLVER] set_barrier_scalar(): "
-		     << "Input argument was " << to_string(scalar) << " but it must be positive.\n";
-		
-		return false;
-	}
-	else
-	{
-		this->initialBarrierScalar = scalar;
-		
-		return true;
-	}
+	this->algorithm = primalDual;
+	
+	this->lastCall = none;                                                                      // It uses different memory
+	
+	std::cout << "[INFO] [QP SOLVER] Using the primal-dual method for inequality constraints.\n";
 }
-  
+
   ////////////////////////////////////////////////////////////////////////////////////////////////////
- //                           Use the dual method to solve the QP problem                          //
+ //                Use the dual active set method for inequality constraints                       //
 ////////////////////////////////////////////////////////////////////////////////////////////////////
-template<class DataType>
-void QPSolver<DataType>::use_dual()
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+void QPSolver<DataType,N,C,M,Factorisation>::use_active_set_method()
 {
-	this->method = dual;
+	this->algorithm = activeSetMethod;
 	
-	std::cout << "[INFO] [QP SOLVER] Using the dual method to solve.\n";
+	this->lastCall = none;                                                                      // It uses different memory
+	
+	std::cout << "[INFO] [QP SOLVER] Using the active set method for inequality constraints.\n";
 }
 
   ////////////////////////////////////////////////////////////////////////////////////////////////////
- //                         Use the primal method to solve the QP problem                          //
+ //               Set the active constraints for the next call to the active set method            //
 ////////////////////////////////////////////////////////////////////////////////////////////////////
-template<class DataType>
-void QPSolver<DataType>::use_primal()
+template <class DataType, int N, int C, int M, template <class> class Factorisation>
+bool QPSolver<DataType,N,C,M,Factorisation>::set_active_set(const std::vector<unsigned int> &indices)
 {
-	this->method = primal;
-	
-	std::cout << "[INFO] [QP SOLVER] Using the primal method to solve.\n";
+	if(N != Dynamic and indices.size() > N)
+	{
+		cerr << "[ERROR] [QP SOLVER] set_active_set(): "
+		     << "There can be at most " << N << " active constraints but the argument had "
+		     << indices.size() << " elements.\n";
+		
+		return false;
+	}
+	else
+	{
+		this->activeSet = indices;
+		this->activeSetGiven = true;
+		
+		return true;
+	}
 }
 
 #endif
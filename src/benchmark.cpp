@@ -0,0 +1,1034 @@
+/**
+ * @file  : benchmark.cpp
+ * @author: Jon Woolfrey
+ * @date  : August 2023
+ * @brief : Measures the latency of every public function in the QPSolver, QPProblem and MPCSolver
+ *          classes over a range of problem sizes, and writes the results to a JSON file so they can
+ *          be compared between releases.
+ *
+ * Usage: ./benchmark [output file] [repetitions]
+ *
+ * Each function is called a few times to warm up, then timed on every call. The median and the
+ * 99th percentile are reported, which are less sensitive to noise than a single measurement.
+ *
+ * This software is publicly available under the GNU General Public License V3.0. You are free to
+ * use it and modify it as you see fit. If you find it useful, please acknowledge it.
+ *
+ * @see https://github.com/Woolfrey/SimpleQPSolver
+ */
+
+#include <algorithm>                                                                                // std::sort
+#include <chrono>                                                                                   // std::chrono::steady_clock
+#include <fstream>                                                                                  // std::ofstream
+#include <functional>                                                                               // std::function
+#include <iostream>                                                                                 // std::cout
+#include <MPCSolver.h>                                                                              // Custom class
+#include <QPProblem.h>                                                                              // Custom class
+#include <sstream>                                                                                  // std::ostringstream
+#include <string>                                                                                   // std::string
+#include <thread>                                                                                   // std::thread::hardware_concurrency
+#include <vector>                                                                                   // std::vector
+
+#ifndef QP_SOLVER_VERSION
+#define QP_SOLVER_VERSION "unknown"
+#endif
+
+const unsigned int numWarmUp = 10;                                                                  // Calls before timing starts
+const double       timeBudget = 0.5;                                                                // Seconds spent on each measurement, roughly
+
+unsigned int maxRepetitions = 200;                                                                  // Timed calls for each measurement
+unsigned int minRepetitions = 30;                                                                   // Even if it takes longer than the budget
+
+/**
+ * The conditions for one measurement. Fields that don't apply are left empty.
+ */
+struct Case
+{
+	std::string function;                                                                       ///< Name of the function called
+	std::string type;                                                                           ///< float or double
+	unsigned int n = 0;                                                                         ///< Number of decision variables
+	unsigned int m = 0;                                                                         ///< Number of equality constraints or outputs
+	unsigned int c = 0;                                                                         ///< Number of inequality constraints
+	std::string constraints;                                                                    ///< none, equality, bounds, generic, paired equality
+	std::string algorithm;                                                                      ///< barrier, primal-dual, active set
+	std::string method;                                                                         ///< primal, dual or null space for redundant problems, riccati, or serial/parallel assembly
+	std::string factorisation = "ldlt";                                                         ///< ldlt, llt, qr, cod or lapack llt
+};
+
+/**
+ * Collects the results and writes them as JSON.
+ */
+class Benchmark
+{
+	public:
+		/**
+		 * Warm up, then time the function and record the median and 99th percentile.
+		 * @param conditions The conditions for this measurement.
+		 * @param call Calls the function once, and returns the number of steps it took (0 if not applicable).
+		 */
+		void measure(const Case &conditions, const std::function<unsigned int()> &call)
+		{
+			std::ostringstream record;
+			
+			record << "\t\t{\"function\": \"" << conditions.function << "\", "
+			       << "\"type\": \"" << conditions.type << "\", "
+			       << "\"n\": " << conditions.n << ", "
+			       << "\"m\": " << conditions.m << ", "
+			       << "\"c\": " << conditions.c << ", "
+			       << "\"constraints\": \"" << conditions.constraints << "\", "
+			       << "\"algorithm\": \"" << conditions.algorithm << "\", "
+			       << "\"method\": \"" << conditions.method << "\", "
+			       << "\"factorisation\": \"" << conditions.factorisation << "\", ";
+			
+			try
+			{
+				unsigned int steps = 0;
+				
+				auto start = std::chrono::steady_clock::now();
+				for(unsigned int i = 0; i < numWarmUp; i++) steps = call();
+				double estimate = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()/numWarmUp;
+				
+				unsigned int repetitions = std::max(minRepetitions, std::min(maxRepetitions, (unsigned int)(timeBudget/estimate)));
+				
+				std::vector<double> times(repetitions);
+				for(unsigned int i = 0; i < repetitions; i++)
+				{
+					start = std::chrono::steady_clock::now();
+					call();
+					times[i] = std::chrono::duration<double,std::micro>(std::chrono::steady_clock::now() - start).count();
+				}
+				
+				std::sort(times.begin(), times.end());
+				
+				double median = (times[(repetitions-1)/2] + times[repetitions/2])/2;
+				double p99    = times[std::min(repetitions-1, (unsigned int)(0.99*repetitions))];
+				
+				record << "\"repetitions\": " << repetitions << ", "
+				       << "\"steps\": " << steps << ", "
+				       << "\"min_us\": " << times.front() << ", "
+				       << "\"median_us\": " << median << ", "
+				       << "\"p99_us\": " << p99 << ", "
+				       << "\"max_us\": " << times.back() << "}";
+				
+				std::cout << conditions.function << " " << conditions.type << " n=" << conditions.n
+				          << " m=" << conditions.m << " c=" << conditions.c << " " << conditions.constraints
+				          << " " << conditions.algorithm << " " << conditions.method
+				          << " " << conditions.factorisation << ": median " << median << " us, p99 " << p99 << " us\n";
+			}
+			catch(const std::exception &exception)
+			{
+				record << "\"error\": \"" << exception.what() << "\"}";
+				
+				std::cout << conditions.function << " " << conditions.type << " n=" << conditions.n
+				          << ": " << exception.what() << "\n";
+			}
+			
+			this->records.push_back(record.str());
+		}
+		
+		/**
+		 * Write the results to a JSON file.
+		 */
+		bool write(const std::string &fileName) const
+		{
+			std::ofstream file(fileName);
+			
+			if(not file.is_open()) return false;
+			
+			file << "{\n"
+			     << "\t\"library\": \"SimpleQPSolver\",\n"
+			     << "\t\"version\": \"" << QP_SOLVER_VERSION << "\",\n"
+			     << "\t\"compiler\": \"" << __VERSION__ << "\",\n"
+			     << "\t\"eigen\": \"" << EIGEN_WORLD_VERSION << "." << EIGEN_MAJOR_VERSION << "." << EIGEN_MINOR_VERSION << "\",\n"
+			     << "\t\"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n"
+			     << "\t\"warm_up\": " << numWarmUp << ",\n"
+			     << "\t\"results\":\n"
+			     << "\t[\n";
+			
+			for(unsigned int i = 0; i < this->records.size(); i++)
+			{
+				file << this->records[i] << (i+1 < this->records.size() ? ",\n" : "\n");
+			}
+			
+			file << "\t]\n"
+			     << "}\n";
+			
+			return true;
+		}
+	
+	private:
+		
+		std::vector<std::string> records;                                                   ///< One JSON object for each measurement
+};
+
+/**
+ * Sets the algorithm for inequality constraints by name.
+ */
+template <class DataType>
+void set_algorithm(QPSolver<DataType> &solver, const std::string &algorithm)
+{
+	     if(algorithm == "barrier")     solver.use_barrier_method();
+	else if(algorithm == "primal-dual") solver.use_primal_dual_method();
+	else                                solver.use_active_set_method();
+}
+
+/**
+ * Sets the method for redundant problems by name.
+ */
+template <class DataType>
+void set_method(QPSolver<DataType> &solver, const std::string &method)
+{
+	     if(method == "primal") solver.use_primal();
+	else if(method == "dual")   solver.use_dual();
+	else                        solver.use_null_space();
+}
+
+/**
+ * Measure every public function for one scalar type over a range of problem sizes.
+ */
+template <class DataType>
+void run(Benchmark &benchmark, const std::string &type)
+{
+	typedef Eigen::Matrix<DataType,Eigen::Dynamic,Eigen::Dynamic> Matrix;
+	typedef Eigen::Matrix<DataType,Eigen::Dynamic,1>              Vector;
+	
+	const std::vector<std::string> algorithms = {"barrier", "primal-dual", "active set"};
+	const std::vector<std::string> methods    = {"primal", "dual", "null space"};
+	const std::vector<unsigned int> sizes     = {5, 10, 25, 50, 100};
+	
+	for(unsigned int n : sizes)
+	{
+		unsigned int m = n/2;                                                               // Equality constraints for redundant problems
+		unsigned int c = 2*n;                                                               // Inequality constraints
+		
+		srand(n);                                                                           // Same problems every run
+		
+		// Generic QP problem
+		Matrix R = Matrix::Random(n,n);
+		Matrix H = R*R.transpose() + Matrix::Identity(n,n);
+		Vector f = Vector::Random(n);
+		Matrix B = Matrix::Random(c,n);
+		Vector z = Vector::Ones(c) + Vector::Random(c).cwiseAbs();                          // x0 = 0 is inside the constraints
+		Vector x0 = Vector::Zero(n);
+		
+		// Least squares problems
+		Matrix A  = Matrix::Random(2*n,n);                                                  // Over-determined
+		Vector y  = A*Vector::Random(n);
+		Matrix Wy = Matrix::Identity(2*n,2*n);
+		
+		Matrix Ar = Matrix::Random(m,n);                                                    // Redundant
+		Vector yr = Ar*(0.5*Vector::Random(n));
+		Matrix W  = (Vector::Ones(n) + Vector::Random(n).cwiseAbs()).asDiagonal();
+		Vector xd = Vector::Random(n);
+		
+		Vector xMin = -Vector::Ones(n);
+		Vector xMax =  Vector::Ones(n);
+		
+		// Functions without inequality constraints
+		benchmark.measure({"solve(H,f)", type, n, 0, 0, "none", "", ""},
+		                  [&]{ QPSolver<DataType>::solve(H,f); return 0u; });
+		
+		benchmark.measure({"least_squares(y,A,W)", type, n, 2*n, 0, "none", "", ""},
+		                  [&]{ QPSolver<DataType>::least_squares(y,A,Wy); return 0u; });
+		
+		benchmark.measure({"redundant_least_squares(xd,W,A,y)", type, n, m, 0, "equality", "", ""},
+		                  [&]{ QPSolver<DataType>::redundant_least_squares(xd,W,Ar,yr); return 0u; });
+		
+		// Functions with inequality constraints
+		for(const std::string &algorithm : algorithms)
+		{
+			QPSolver<DataType> solver;
+			
+			set_algorithm(solver, algorithm);
+			
+			benchmark.measure({"solve(H,f,B,z,x0)", type, n, 0, c, "generic", algorithm, ""},
+			                  [&]{ solver.solve(H,f,B,z,x0); return solver.num_steps(); });
+			
+			benchmark.measure({"constrained_least_squares(y,A,W,xMin,xMax,x0)", type, n, 2*n, 2*n, "bounds", algorithm, ""},
+			                  [&]{ solver.constrained_least_squares(y,A,Wy,xMin,xMax,x0); return solver.num_steps(); });
+			
+			for(const std::string &method : methods)
+			{
+				set_method(solver, method);
+				
+				benchmark.measure({"constrained_least_squares(xd,W,A,y,xMin,xMax,x0)", type, n, m, 2*n, "bounds", algorithm, method},
+				                  [&]{ solver.constrained_least_squares(xd,W,Ar,yr,xMin,xMax,x0); return solver.num_steps(); });
+				
+				benchmark.measure({"constrained_least_squares(xd,W,A,y,B,z,x0)", type, n, m, c, "generic", algorithm, method},
+				                  [&]{ solver.constrained_least_squares(xd,W,Ar,yr,B,z,x0); return solver.num_steps(); });
+				
+				// Only the vectors change, so the decompositions of W and A are reused
+				QPProblem<DataType> problem(xd,W,Ar,yr,B,z);
+				
+				set_algorithm(problem, algorithm);
+				set_method(problem, method);
+				
+				benchmark.measure({"QPProblem::solve(x0)", type, n, m, c, "generic", algorithm, method},
+				                  [&]{ problem.update_y(yr); problem.update_xd(xd); problem.solve(x0); return problem.num_steps(); });
+			}
+		}
+		
+		// Sparse versions
+		{
+			QPSolver<DataType> solver;
+			
+			Eigen::SparseMatrix<DataType> HSparse = H.sparseView();
+			Eigen::SparseMatrix<DataType> BSparse = B.sparseView();
+			Eigen::SparseMatrix<DataType> ASparse = Ar.sparseView();
+			Eigen::SparseMatrix<DataType> WSparse = W.sparseView();
+			
+			benchmark.measure({"solve(H,f,B,z,x0) sparse", type, n, 0, c, "generic", "barrier", ""},
+			                  [&]{ solver.solve(HSparse,f,BSparse,z,x0); return solver.num_steps(); });
+			
+			benchmark.measure({"constrained_least_squares(xd,W,A,y,B,z,x0) sparse", type, n, m, c, "generic", "barrier", "primal"},
+			                  [&]{ solver.constrained_least_squares(xd,WSparse,ASparse,yr,BSparse,z,x0); return solver.num_steps(); });
+		}
+		
+		// Batches of 64 of the same problem, timed per batch
+		if(n <= 25)
+		{
+			QPSolver<DataType> solver;
+			
+			std::vector<typename QPSolver<DataType>::Problem> problems(64, {H,f,B,z,x0});
+			std::vector<typename QPSolver<DataType>::LeastSquaresProblem> leastSquaresProblems(64, {xd,W,Ar,yr,B,z,x0});
+			
+			benchmark.measure({"solve_batch(64 problems)", type, n, 0, c, "generic", "barrier", ""},
+			                  [&]{ solver.solve_batch(problems); return 0u; });
+			
+			benchmark.measure({"solve_lockstep(64 problems)", type, n, 0, c, "generic", "barrier", ""},
+			                  [&]{ solver.solve_lockstep(problems); return 0u; });
+			
+			benchmark.measure({"constrained_least_squares_batch(64 problems)", type, n, m, c, "generic", "barrier", "primal"},
+			                  [&]{ solver.constrained_least_squares_batch(leastSquaresProblems); return 0u; });
+		}
+	}
+}
+
+/**
+ * Compare the MPCSolver against the same problem written as one large QP, over a range of horizons.
+ * The system is a point mass moving in the plane, with limits on the velocity and acceleration.
+ */
+template <class DataType>
+void run_mpc(Benchmark &benchmark, const std::string &type)
+{
+	typedef Eigen::Matrix<DataType,Eigen::Dynamic,Eigen::Dynamic> Matrix;
+	typedef Eigen::Matrix<DataType,Eigen::Dynamic,1>              Vector;
+	typedef typename MPCSolver<DataType>::Stage                   Stage;
+	
+	const std::vector<unsigned int> horizons = {10, 20, 50, 100, 200};
+	const unsigned int maxDenseHorizon = 100;                                                   // Takes seconds per call beyond this
+	
+	const unsigned int n = 4;                                                                   // [position; velocity]
+	const unsigned int p = 2;                                                                   // Acceleration
+	const DataType dt = 0.1;
+	
+	Stage stage;
+	stage.A = Matrix::Identity(n,n);
+	stage.A.topRightCorner(2,2) = dt*Matrix::Identity(2,2);
+	stage.B.setZero(n,p);
+	stage.B.topRows(2)    = 0.5*dt*dt*Matrix::Identity(2,2);
+	stage.B.bottomRows(2) = dt*Matrix::Identity(2,2);
+	stage.Q = Matrix::Identity(n,n);
+	stage.Q.bottomRightCorner(2,2) *= 0.1;
+	stage.R = 0.01*Matrix::Identity(p,p);
+	stage.D.setZero(2*n,n);                                                                     // -1 <= velocity <= 1
+	stage.D.block(0,2,2,2) =  Matrix::Identity(2,2);
+	stage.D.block(2,2,2,2) = -Matrix::Identity(2,2);
+	stage.E.setZero(2*n,p);                                                                     // -1 <= acceleration <= 1
+	stage.E.block(4,0,2,2) =  Matrix::Identity(2,2);
+	stage.E.block(6,0,2,2) = -Matrix::Identity(2,2);
+	stage.e = Vector::Ones(2*n);
+	
+	Vector x0(n);
+	x0 << 1, -1, 0, 0;
+	
+	for(unsigned int T : horizons)
+	{
+		std::vector<Stage> stages(T+1, stage);
+		stages[T].Q *= 10;                                                                  // Terminal cost
+		stages[T].D  = stage.D.topRows(n);
+		stages[T].e  = Vector::Ones(n);
+		
+		unsigned int dim = T*(n+p);                                                         // [u_0; x_1; u_1; ... ; x_T]
+		unsigned int c   = T*2*n + n;
+		
+		MPCSolver<DataType> mpc;
+		
+		benchmark.measure({"MPCSolver::solve(stages,x0)", type, dim, T*n, c, "generic", "primal-dual", "riccati"},
+		                  [&]{ mpc.solve(stages,x0); return mpc.num_steps(); });
+		
+		if(T > maxDenseHorizon) continue;
+		
+		// The same problem as min 0.5*(xd - x)'*W*(xd - x) subject to A*x = y, B*x <= z
+		Matrix W = Matrix::Zero(dim,dim), A = Matrix::Zero(T*n,dim), B = Matrix::Zero(c,dim);
+		Vector y = Vector::Zero(T*n), z(c);
+		
+		for(unsigned int k = 0; k < T; k++)
+		{
+			unsigned int u = k*(n+p);                                                   // Index of u_k
+			unsigned int x = u + p;                                                     // Index of x_k+1
+			
+			W.block(u,u,p,p) = stages[k].R;
+			W.block(x,x,n,n) = stages[k+1].Q;
+			
+			// x_k+1 - A*x_k - B*u_k = 0, with x_0 given
+			A.block(k*n,x,n,n).setIdentity();
+			A.block(k*n,u,n,p) = -stage.B;
+			if(k == 0) y.head(n) = stage.A*x0;
+			else       A.block(k*n,u-n,n,n) = -stage.A;
+			
+			// D*x_k + E*u_k <= e, and D*x_k+1 <= e on the last stage
+			B.block(2*n*k,u,2*n,p) = stage.E;
+			z.segment(2*n*k,2*n)   = stage.e;
+			if(k == 0) z.head(2*n) -= stage.D*x0;
+			else       B.block(2*n*k,u-n,2*n,n) = stage.D;
+		}
+		
+		B.bottomRightCorner(n,n) = stages[T].D;
+		z.tail(n) = stages[T].e;
+		
+		Vector xd = Vector::Zero(dim);                                                      // There is no linear cost
+		Vector xStart = Vector::Zero(dim);
+		
+		QPSolver<DataType> solver;
+		
+		solver.use_primal_dual_method();
+		solver.use_null_space();                                                            // Fastest of the dense methods here
+		
+		benchmark.measure({"constrained_least_squares(xd,W,A,y,B,z,x0) MPC", type, dim, T*n, c, "generic", "primal-dual", "null space"},
+		                  [&]{ solver.constrained_least_squares(xd,W,A,y,B,z,xStart); return solver.num_steps(); });
+	}
+}
+
+/**
+ * Compare the serial and parallel assembly of the barrier for large numbers of constraints.
+ */
+template <class DataType>
+void run_parallel_assembly(Benchmark &benchmark, const std::string &type)
+{
+	typedef Eigen::Matrix<DataType,Eigen::Dynamic,Eigen::Dynamic> Matrix;
+	typedef Eigen::Matrix<DataType,Eigen::Dynamic,1>              Vector;
+	
+	const unsigned int n = 50;
+	
+	for(unsigned int c : {500, 2000, 8000})
+	{
+		srand(c);
+		
+		Matrix R = Matrix::Random(n,n);
+		Matrix H = R*R.transpose() + Matrix::Identity(n,n);
+		Vector f = 10*Vector::Random(n);
+		Matrix B = Matrix::Random(c,n);
+		Vector z = Vector::Ones(c);
+		Vector x0 = Vector::Zero(n);
+		
+		for(const std::string &assembly : {"serial assembly", "parallel assembly"})
+		{
+			for(const std::string &algorithm : {"barrier", "primal-dual"})
+			{
+				QPSolver<DataType> solver;
+				
+				set_algorithm(solver, algorithm);
+				
+				if(assembly == "parallel assembly") solver.use_parallel_assembly();
+				
+				benchmark.measure({"solve(H,f,B,z,x0)", type, n, 0, c, "generic", algorithm, assembly},
+				                  [&]{ solver.solve(H,f,B,z,x0); return solver.num_steps(); });
+			}
+		}
+	}
+}
+
+/**
+ * Compare the fixed and adaptive barrier schedules. The steps column shows the iterations saved.
+ */
+template <class DataType>
+void run_adaptive_barrier(Benchmark &benchmark, const std::string &type)
+{
+	typedef Eigen::Matrix<DataType,Eigen::Dynamic,Eigen::Dynamic> Matrix;
+	typedef Eigen::Matrix<DataType,Eigen::Dynamic,1>              Vector;
+	
+	for(unsigned int n : {10, 50, 200})
+	{
+		unsigned int c = 2*n;
+		
+		srand(n);
+		
+		Matrix R = Matrix::Random(n,n);
+		Matrix H = R*R.transpose() + Matrix::Identity(n,n);
+		Vector f = 10*Vector::Random(n);
+		Matrix B = Matrix::Random(c,n);
+		Vector z = Vector::Ones(c);
+		Vector x0 = Vector::Zero(n);
+		
+		for(const std::string &schedule : {"fixed barrier", "adaptive barrier"})
+		{
+			QPSolver<DataType> solver;
+			
+			if(schedule == "adaptive barrier") solver.use_adaptive_barrier();
+			
+			benchmark.measure({"solve(H,f,B,z,x0)", type, n, 0, c, "generic", "barrier", schedule},
+			                  [&]{ solver.solve(H,f,B,z,x0); return solver.num_steps(); });
+		}
+	}
+}
+
+/**
+ * Time phase I from a start point outside the constraints, and on constraints that cannot be satisfied.
+ */
+template <class DataType>
+void run_phase_one(Benchmark &benchmark, const std::string &type)
+{
+	typedef Eigen::Matrix<DataType,Eigen::Dynamic,Eigen::Dynamic> Matrix;
+	typedef Eigen::Matrix<DataType,Eigen::Dynamic,1>              Vector;
+	
+	for(unsigned int n : {10, 50, 200})
+	{
+		unsigned int c = 2*n;
+		
+		srand(n);
+		
+		Matrix R = Matrix::Random(n,n);
+		Matrix H = R*R.transpose() + Matrix::Identity(n,n);
+		Vector f = 10*Vector::Random(n);
+		Matrix B = Matrix::Random(c+2,n);
+		Vector z = Vector::Ones(c+2);
+		Vector x0 = 10*Vector::Ones(n);                                                     // Outside the constraints
+		
+		for(const std::string &start : {"infeasible start", "infeasible problem"})
+		{
+			if(start == "infeasible problem")                                                 // x(0) <= -1 and x(0) >= 1
+			{
+				B.bottomRows(2).setZero();
+				B(c,0)   =  1;
+				B(c+1,0) = -1;
+				z(c)     = -1;
+				z(c+1)   = -1;
+			}
+			
+			for(const std::string &algorithm : {"barrier", "primal-dual"})
+			{
+				QPSolver<DataType> solver;
+				
+				set_algorithm(solver, algorithm);
+				
+				benchmark.measure({"solve(H,f,B,z,x0)", type, n, 0, c+2, "generic", algorithm, start},
+				                  [&]{ solver.solve(H,f,B,z,x0); return solver.num_steps(); });
+			}
+		}
+	}
+}
+
+/**
+ * Compare equality constraints in the Newton step with the same equalities as pairs of inequalities,
+ * which need a small band because an exact pair leaves no interior for the barrier.
+ */
+template <class DataType>
+void run_equality(Benchmark &benchmark, const std::string &type)
+{
+	typedef Eigen::Matrix<DataType,Eigen::Dynamic,Eigen::Dynamic> Matrix;
+	typedef Eigen::Matrix<DataType,Eigen::Dynamic,1>              Vector;
+	
+	const DataType band = 1e-04;
+	
+	for(unsigned int n : {10, 50, 200})
+	{
+		unsigned int m = n/5;
+		unsigned int c = 2*n;
+		
+		srand(n);
+		
+		Matrix R = Matrix::Random(n,n);
+		Matrix H = R*R.transpose() + Matrix::Identity(n,n);
+		Vector f = Vector::Random(n);
+		Matrix A = Matrix::Random(m,n);
+		Vector y = A*(0.5*Vector::Random(n));
+		Matrix B = Matrix::Random(c,n);
+		Vector z = Vector::Ones(c) + Vector::Random(c).cwiseAbs();
+		Vector x0 = Vector::Zero(n);
+		
+		Matrix BPaired(c+2*m,n);
+		BPaired << B, A, -A;
+		Vector zPaired(c+2*m);
+		zPaired << z, y + band*Vector::Ones(m), -y + band*Vector::Ones(m);
+		
+		for(const std::string &algorithm : {"barrier", "primal-dual"})
+		{
+			QPSolver<DataType> solver;
+			
+			set_algorithm(solver, algorithm);
+			
+			for(const std::string &method : {"primal", "null space"})
+			{
+				set_method(solver, method);
+				
+				benchmark.measure({"solve(H,f,A,y,B,z,x0)", type, n, m, c, "generic", algorithm, method},
+				                  [&]{ solver.solve(H,f,A,y,B,z,x0); return solver.num_steps(); });
+				
+				std::cout << "  ||y - A*x|| = " << (y - A*solver.last_solution()).norm() << "\n";
+			}
+			
+			benchmark.measure({"solve(H,f,B,z,x0)", type, n, m, c+2*m, "paired equality", algorithm, ""},
+			                  [&]{ solver.solve(H,f,BPaired,zPaired,x0); return solver.num_steps(); });
+			
+			std::cout << "  ||y - A*x|| = " << (y - A*solver.last_solution()).norm() << "\n";
+		}
+	}
+}
+
+/**
+ * Compare updating the cached decompositions of a QPProblem after a rank one change with
+ * decomposing them again. Each update is undone on the next call so the problem stays the same.
+ */
+template <class DataType>
+void run_rank_update(Benchmark &benchmark, const std::string &type)
+{
+	typedef Eigen::Matrix<DataType,Eigen::Dynamic,Eigen::Dynamic> Matrix;
+	typedef Eigen::Matrix<DataType,Eigen::Dynamic,1>              Vector;
+	
+	for(unsigned int n : {50, 100, 200})
+	{
+		unsigned int m = n/5;
+		unsigned int c = 2*n;
+		
+		srand(n);
+		
+		Matrix R = Matrix::Random(n,n);
+		Matrix H = R*R.transpose() + Matrix::Identity(n,n);
+		Vector f = Vector::Random(n);
+		Matrix B = Matrix::Random(c,n);
+		Vector z = Vector::Ones(c) + Vector::Random(c).cwiseAbs();
+		Vector x0 = Vector::Zero(n);
+		Vector u = Vector::Random(n);
+		
+		Matrix Ar = Matrix::Random(m,n);
+		Vector yr = Ar*(0.5*Vector::Random(n));
+		Matrix W = (Vector::Ones(n) + Vector::Random(n).cwiseAbs()).asDiagonal();
+		Vector xd = Vector::Random(n);
+		
+		Matrix A = Matrix::Random(2*n,n);
+		Vector y = A*Vector::Random(n);
+		Matrix Wy = Matrix::Identity(2*n,2*n);
+		Vector xMin = -Vector::Ones(n);
+		Vector xMax =  Vector::Ones(n);
+		
+		for(const std::string &method : {"decompose", "rank update"})
+		{
+			bool update = (method == std::string("rank update"));
+			
+			// H + u*u' for the active set method, which keeps a Cholesky decomposition of H
+			{
+				QPProblem<DataType> problem(H,f,B,z);
+				problem.use_active_set_method();
+				
+				Matrix Hu = H + u*u.transpose();
+				DataType sigma = 1;
+				
+				benchmark.measure({"QPProblem::solve(x0) after H += u*u'", type, n, 0, c, "generic", "active set", method},
+				                  [&]
+				                  {
+				                  	if(update) problem.rank_update_H(u, sigma);
+				                  	else       problem.update_H(sigma > 0 ? Hu : H);
+				                  	sigma = -sigma;
+				                  	problem.solve(x0);
+				                  	return problem.num_steps();
+				                  });
+			}
+			
+			// W + u*u' for a redundant problem, which decomposes W and A*W^-1*A'
+			{
+				QPProblem<DataType> problem(xd,W,Ar,yr,B,z);
+				problem.use_dual();
+				
+				Matrix Wu = W + u*u.transpose();
+				DataType sigma = 1;
+				
+				benchmark.measure({"QPProblem::solve(x0) after W += u*u'", type, n, m, c, "generic", "barrier", "dual " + method},
+				                  [&]
+				                  {
+				                  	if(update) problem.rank_update_W(u, sigma);
+				                  	else       problem.update_W(sigma > 0 ? Wu : W);
+				                  	sigma = -sigma;
+				                  	problem.solve(x0);
+				                  	return problem.num_steps();
+				                  });
+			}
+			
+			// Replace the oldest measurement of a least squares problem, which forms A'*W*A
+			{
+				QPProblem<DataType> problem(y,A,Wy,xMin,xMax);
+				problem.use_active_set_method();
+				
+				unsigned int oldest = 0;                                                    // The rows of A cycle through the problem
+				
+				benchmark.measure({"QPProblem::solve(x0) after a new row of A", type, n, 2*n, 2*n, "bounds", "active set", method},
+				                  [&]
+				                  {
+				                  	if(update)
+				                  	{
+				                  		problem.add_row(A.row(oldest).transpose(), y(oldest));
+				                  		problem.remove_row(0);
+				                  		oldest = (oldest + 1) % A.rows();
+				                  	}
+				                  	else
+				                  	{
+				                  		problem.update_A(A);
+				                  		problem.update_y(y);
+				                  	}
+				                  	problem.solve(x0);
+				                  	return problem.num_steps();
+				                  });
+			}
+		}
+	}
+}
+
+/**
+ * Compare factorising the barrier in full precision with single precision and iterative refinement.
+ */
+template <class DataType>
+void run_mixed_precision(Benchmark &benchmark, const std::string &type)
+{
+	typedef Eigen::Matrix<DataType,Eigen::Dynamic,Eigen::Dynamic> Matrix;
+	typedef Eigen::Matrix<DataType,Eigen::Dynamic,1>              Vector;
+	
+	for(unsigned int n : {100, 200, 400})
+	{
+		unsigned int c = 2*n;
+		
+		srand(n);
+		
+		Matrix R = Matrix::Random(n,n);
+		Matrix H = R*R.transpose() + Matrix::Identity(n,n);
+		Vector f = 10*Vector::Random(n);
+		Matrix B = Matrix::Random(c,n);
+		Vector z = Vector::Ones(c);
+		Vector x0 = Vector::Zero(n);
+		
+		for(const std::string &precision : {"full precision", "mixed precision"})
+		{
+			for(const std::string &algorithm : {"barrier", "primal-dual"})
+			{
+				QPSolver<DataType> solver;
+				
+				set_algorithm(solver, algorithm);
+				
+				if(precision == "mixed precision") solver.use_mixed_precision();
+				
+				benchmark.measure({"solve(H,f,B,z,x0)", type, n, 0, c, "generic", algorithm, precision},
+				                  [&]{ solver.solve(H,f,B,z,x0); return solver.num_steps(); });
+			}
+		}
+	}
+}
+
+/**
+ * Compare solving the Newton step in the full space and in the space of the constraints, for a
+ * fixed number of variables and a range of constraints either side of the crossover at n = 2c.
+ */
+template <class DataType>
+void run_constraint_space(Benchmark &benchmark, const std::string &type)
+{
+	typedef Eigen::Matrix<DataType,Eigen::Dynamic,Eigen::Dynamic> Matrix;
+	typedef Eigen::Matrix<DataType,Eigen::Dynamic,1>              Vector;
+	
+	for(unsigned int n : {100, 500})
+	{
+		for(unsigned int c : {n/50, n/10, n/4, n/2, n, 2*n})
+		{
+			srand(n + c);
+			
+			Matrix R = Matrix::Random(n,n);
+			Matrix H = R*R.transpose() + Matrix::Identity(n,n);
+			Vector f = 10*Vector::Random(n);
+			Matrix B = Matrix::Random(c,n);
+			Vector z = Vector::Ones(c);
+			Vector x0 = Vector::Zero(n);
+			
+			for(const std::string &space : {"full space", "constraint space", "automatic space"})
+			{
+				for(const std::string &algorithm : {"barrier", "primal-dual"})
+				{
+					QPSolver<DataType> solver;
+					
+					set_algorithm(solver, algorithm);
+					
+					if(space == "full space")            solver.use_full_space();
+					else if(space == "constraint space") solver.use_constraint_space();
+					
+					benchmark.measure({"solve(H,f,B,z,x0)", type, n, 0, c, "generic", algorithm, space},
+					                  [&]{ solver.solve(H,f,B,z,x0); return solver.num_steps(); });
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Compare solving with no limit to solving with a time budget, and print how far the objective of
+ * the anytime result is from the optimum. Also measure the cost of solving on another thread.
+ */
+template <class DataType>
+void run_deadline(Benchmark &benchmark, const std::string &type)
+{
+	typedef Eigen::Matrix<DataType,Eigen::Dynamic,Eigen::Dynamic> Matrix;
+	typedef Eigen::Matrix<DataType,Eigen::Dynamic,1>              Vector;
+	
+	for(unsigned int n : {100, 300})
+	{
+		unsigned int c = 2*n;
+		
+		srand(n);
+		
+		Matrix R = Matrix::Random(n,n);
+		Matrix H = R*R.transpose() + Matrix::Identity(n,n);
+		Vector f = 10*Vector::Random(n);
+		Matrix B = Matrix::Random(c,n);
+		Vector z = Vector::Ones(c);
+		Vector x0 = Vector::Zero(n);
+		
+		auto objective = [&](const Vector &x){ return 0.5*x.dot(H*x) + f.dot(x); };
+		
+		for(const std::string &algorithm : {"barrier", "primal-dual"})
+		{
+			QPSolver<DataType> solver;
+			
+			set_algorithm(solver, algorithm);
+			
+			Vector x = solver.solve(H,f,B,z,x0);
+			
+			DataType optimum = objective(x);
+			
+			benchmark.measure({"solve(H,f,B,z,x0)", type, n, 0, c, "generic", algorithm, "no limit"},
+			                  [&]{ solver.solve(H,f,B,z,x0); return solver.num_steps(); });
+			
+			for(double budget : {1e-3, 5e-3})
+			{
+				solver.set_time_budget(budget);
+				
+				std::ostringstream label;
+				label << budget*1000 << " ms budget";
+				
+				benchmark.measure({"solve(H,f,B,z,x0)", type, n, 0, c, "generic", algorithm, label.str()},
+				                  [&]{ x = solver.solve(H,f,B,z,x0); return solver.num_steps(); });
+				
+				std::cout << "Objective above the optimum with a " << label.str() << ": "
+				          << objective(x) - optimum << "\n";
+			}
+			
+			solver.set_time_budget(0);
+			
+			benchmark.measure({"solve_async(H,f,B,z,x0)", type, n, 0, c, "generic", algorithm, "no limit"},
+			                  [&]{ return solver.solve_async(H,f,B,z,x0).get().numSteps; });
+		}
+	}
+}
+
+/**
+ * Compare each configuration on its own with racing them all in a portfolio, and print how often
+ * each configuration won.
+ */
+template <class DataType>
+void run_portfolio(Benchmark &benchmark, const std::string &type)
+{
+	typedef Eigen::Matrix<DataType,Eigen::Dynamic,Eigen::Dynamic> Matrix;
+	typedef Eigen::Matrix<DataType,Eigen::Dynamic,1>              Vector;
+	
+	const std::vector<std::string> algorithms = {"barrier", "primal-dual", "active set"};
+	const std::vector<std::string> methods    = {"primal", "dual", "null space"};
+	
+	std::vector<typename QPSolver<DataType>::Configuration> byAlgorithm, byMethod;
+	
+	for(const std::string &algorithm : algorithms)
+	{
+		byAlgorithm.push_back([algorithm](QPSolver<DataType> &solver)
+		{
+			set_algorithm(solver, algorithm);
+			if(algorithm == "barrier") solver.use_adaptive_barrier();                   // Stops on the KKT tolerance, as the others do
+		});
+	}
+	
+	for(const std::string &method : methods)
+	{
+		byMethod.push_back([method](QPSolver<DataType> &solver)
+		{
+			set_method(solver, method);
+			solver.use_adaptive_barrier();                                              // Stops on the KKT tolerance
+		});
+	}
+	
+	auto print_wins = [](const QPSolver<DataType> &solver, const std::vector<std::string> &names)
+	{
+		std::cout << "Wins:";
+		for(unsigned int i = 0; i < names.size(); i++) std::cout << " " << names[i] << " " << solver.portfolio_wins()[i];
+		std::cout << "\n";
+	};
+	
+	for(unsigned int n : {20, 50, 100, 200})
+	{
+		unsigned int m = n/2;
+		unsigned int c = 2*n;
+		
+		srand(n);
+		
+		Matrix R = Matrix::Random(n,n);
+		Matrix H = R*R.transpose() + Matrix::Identity(n,n);
+		Vector f = 10*Vector::Random(n);
+		Matrix B = Matrix::Random(c,n);
+		Vector z = Vector::Ones(c);
+		Vector x0 = Vector::Zero(n);
+		
+		Matrix A  = Matrix::Random(m,n);
+		Vector y  = A*(0.5*Vector::Random(n));
+		Matrix W  = (Vector::Ones(n) + Vector::Random(n).cwiseAbs()).asDiagonal();
+		Vector xd = Vector::Random(n);
+		
+		for(unsigned int i = 0; i < algorithms.size(); i++)
+		{
+			QPSolver<DataType> solver;
+			byAlgorithm[i](solver);
+			
+			benchmark.measure({"solve(H,f,B,z,x0)", type, n, 0, c, "generic", algorithms[i], (i == 0) ? "adaptive barrier" : ""},
+			                  [&]{ solver.solve(H,f,B,z,x0); return solver.num_steps(); });
+		}
+		
+		{
+			QPSolver<DataType> solver;
+			solver.set_portfolio(byAlgorithm);
+			
+			benchmark.measure({"solve_portfolio(H,f,B,z,x0)", type, n, 0, c, "generic", "portfolio", ""},
+			                  [&]{ solver.solve_portfolio(H,f,B,z,x0); return solver.num_steps(); });
+			
+			print_wins(solver, algorithms);
+		}
+		
+		for(unsigned int i = 0; i < methods.size(); i++)
+		{
+			QPSolver<DataType> solver;
+			byMethod[i](solver);
+			
+			benchmark.measure({"constrained_least_squares(xd,W,A,y,B,z,x0)", type, n, m, c, "generic", "barrier", methods[i] + " adaptive barrier"},
+			                  [&]{ solver.constrained_least_squares(xd,W,A,y,B,z,x0); return solver.num_steps(); });
+		}
+		
+		{
+			QPSolver<DataType> solver;
+			solver.set_portfolio(byMethod);
+			
+			benchmark.measure({"constrained_least_squares_portfolio(xd,W,A,y,B,z,x0)", type, n, m, c, "generic", "barrier", "portfolio adaptive barrier"},
+			                  [&]{ solver.constrained_least_squares_portfolio(xd,W,A,y,B,z,x0); return solver.num_steps(); });
+			
+			print_wins(solver, methods);
+		}
+	}
+}
+
+/**
+ * Compare the factorisations for the functions that use them, over a range of problem sizes.
+ */
+template <class DataType, template <class> class Factorisation>
+void run_factorisation(Benchmark &benchmark, const std::string &type, const std::string &factorisation)
+{
+	typedef Eigen::Matrix<DataType,Eigen::Dynamic,Eigen::Dynamic> Matrix;
+	typedef Eigen::Matrix<DataType,Eigen::Dynamic,1>              Vector;
+	typedef QPSolver<DataType,Eigen::Dynamic,Eigen::Dynamic,Eigen::Dynamic,Factorisation> Solver;
+	
+	const std::vector<unsigned int> sizes = {10, 50, 100, 200};
+	
+	for(unsigned int n : sizes)
+	{
+		unsigned int m = n/2;
+		unsigned int c = 2*n;
+		
+		srand(n);                                                                           // Same problems for every factorisation
+		
+		Matrix R = Matrix::Random(n,n);
+		Matrix H = R*R.transpose() + Matrix::Identity(n,n);
+		Vector f = Vector::Random(n);
+		Matrix B = Matrix::Random(c,n);
+		Vector z = Vector::Ones(c) + Vector::Random(c).cwiseAbs();
+		Vector x0 = Vector::Zero(n);
+		
+		Matrix A  = Matrix::Random(2*n,n);
+		Vector y  = A*Vector::Random(n);
+		Matrix Wy = Matrix::Identity(2*n,2*n);
+		
+		Matrix Ar = Matrix::Random(m,n);
+		Vector yr = Ar*(0.5*Vector::Random(n));
+		Matrix W  = (Vector::Ones(n) + Vector::Random(n).cwiseAbs()).asDiagonal();
+		Vector xd = Vector::Random(n);
+		
+		benchmark.measure({"least_squares(y,A,W)", type, n, 2*n, 0, "none", "", "", factorisation},
+		                  [&]{ Solver::least_squares(y,A,Wy); return 0u; });
+		
+		benchmark.measure({"redundant_least_squares(xd,W,A,y)", type, n, m, 0, "equality", "", "", factorisation},
+		                  [&]{ Solver::redundant_least_squares(xd,W,Ar,yr); return 0u; });
+		
+		Solver solver;
+		
+		benchmark.measure({"solve(H,f,B,z,x0)", type, n, 0, c, "generic", "barrier", "", factorisation},
+		                  [&]{ solver.solve(H,f,B,z,x0); return solver.num_steps(); });
+		
+		solver.use_dual();
+		
+		benchmark.measure({"constrained_least_squares(xd,W,A,y,B,z,x0)", type, n, m, c, "generic", "barrier", "dual", factorisation},
+		                  [&]{ solver.constrained_least_squares(xd,W,Ar,yr,B,z,x0); return solver.num_steps(); });
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	std::string fileName = (argc > 1) ? argv[1] : "benchmark.json";
+	
+	if(argc > 2)
+	{
+		maxRepetitions = std::max(1, atoi(argv[2]));
+		minRepetitions = std::min(minRepetitions, maxRepetitions);
+	}
+	
+	Benchmark benchmark;
+	
+	run<float>(benchmark, "float");
+	run<double>(benchmark, "double");
+	
+	run_mpc<float>(benchmark, "float");
+	run_mpc<double>(benchmark, "double");
+	
+	run_parallel_assembly<double>(benchmark, "double");
+	
+	run_mixed_precision<double>(benchmark, "double");
+	
+	run_constraint_space<double>(benchmark, "double");
+	
+	run_portfolio<double>(benchmark, "double");
+	
+	run_deadline<double>(benchmark, "double");
+	
+	run_phase_one<double>(benchmark, "double");
+	
+	run_equality<double>(benchmark, "double");
+	
+	run_rank_update<double>(benchmark, "double");
+	
+	run_adaptive_barrier<float>(benchmark, "float");
+	run_adaptive_barrier<double>(benchmark, "double");
+	
+	run_factorisation<double,LDLTFactorisation>(benchmark, "double", "ldlt");
+	run_factorisation<double,LLTFactorisation>(benchmark, "double", "llt");
+	run_factorisation<double,QRFactorisation>(benchmark, "double", "qr");
+	run_factorisation<double,CODFactorisation>(benchmark, "double", "cod");
+#ifdef QP_SOLVER_USE_LAPACK
+	run_factorisation<double,LapackLLTFactorisation>(benchmark, "double", "lapack llt");
+#endif
+	
+	if(not benchmark.write(fileName))
+	{
+		std::cerr << "[ERROR] [BENCHMARK] Unable to write to " << fileName << ".\n";
+		
+		return 1;
+	}
+	
+	std::cout << "\nResults were written to " << fileName << ".\n";
+	
+	return 0;
+}
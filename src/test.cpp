@@ -10,9 +10,12 @@
  * @see https://github.com/Woolfrey/SimpleQPSolver
  */
 
+#include <chrono>                                                                                   // std::chrono::steady_clock
 #include <iostream>                                                                                 // std::cout
 #include <fstream>                                                                                  // std::ofstream
-#include <QPSolver.h>                                                                               // Custom cass
+#include <future>                                                                                   // std::future
+#include <MPCSolver.h>                                                                              // Custom class
+#include <QPProblem.h>                                                                              // Custom class
 #include <time.h>                                                                                   // clock_t
 
 int main(int argc, char *argv[])
@@ -311,11 +314,941 @@ int main(int argc, char *argv[])
 		
 		if(error1 > error2) std::cout << "The dual method was " << error1/error2 << " times more accurate.\n";
 		else                std::cout << "The primal method was " << error2/error1 << " times more accurate.\n";
+		
+		solver.use_null_space();
+		
+		timer = clock();
+		x = solver.constrained_least_squares(xd,Eigen::MatrixXf::Identity(n,n),A,y,xMin,xMax,x0);
+		timer = clock() - timer;
+		float t3  = (float)timer/CLOCKS_PER_SEC;
+		
+		std::cout << "\nUsing the null space method, the error ||y - A*x|| is: " << (y - A*x).norm()/y.norm() << ", "
+		          <<   "and it took " << t3*1000 << " ms and " << solver.num_steps() << " steps to solve (" << 1/t3 << " Hz).\n";
+		
+		std::cout << "\nThe null space method was " << t1/t3 << " times faster than the primal method.\n";
 	}
 	catch(const std::exception &exception)
 	{
 		std::cout << exception.what() << std::endl;
-	}   
-
+	}
+	
+	std::cout << "\n**********************************************************************\n"
+	          <<   "*                     FIXED SIZE VERSUS DYNAMIC                      *\n"
+	          <<   "**********************************************************************\n" << std::endl;
+	
+	const unsigned int numTrials = 1000;                                                        // Number of times to solve each problem
+	
+	const int nFixed = 7;                                                                       // Must be known at compile time
+	
+	std::cout << "\nIf the problem size is known at compile time, it can be given as template arguments, "
+	          << "e.g. `QPSolver<float," << nFixed << "," << 2*nFixed << "> solver;' for "
+	          << nFixed << " variables and " << 2*nFixed << " inequality constraints.\n"
+	          << "\nHere we solve min 0.5*x'*H*x + x'*f subject to: -1 <= x <= 1, "
+	          << numTrials << " times with each.\n";
+	
+	temp = Eigen::MatrixXf::Random(nFixed,nFixed);
+	H = temp*temp.transpose() + Eigen::MatrixXf::Identity(nFixed,nFixed);                       // Positive definite
+	f = 10*Eigen::VectorXf::Random(nFixed);                                                     // Large enough to push on the constraints
+	
+	Eigen::MatrixXf B(2*nFixed,nFixed);
+	B << Eigen::MatrixXf::Identity(nFixed,nFixed),
+	    -Eigen::MatrixXf::Identity(nFixed,nFixed);
+	
+	Eigen::VectorXf z  = Eigen::VectorXf::Ones(2*nFixed);
+	x0 = Eigen::VectorXf::Zero(nFixed);
+	
+	Eigen::Matrix<float,nFixed,nFixed>   HFixed  = H;
+	Eigen::Matrix<float,nFixed,1>        fFixed  = f;
+	Eigen::Matrix<float,2*nFixed,nFixed> BFixed  = B;
+	Eigen::Matrix<float,2*nFixed,1>      zFixed  = z;
+	Eigen::Matrix<float,nFixed,1>        x0Fixed = x0;
+	Eigen::Matrix<float,nFixed,1>        xFixed;
+	
+	QPSolver<float> dynamicSolver;
+	QPSolver<float,nFixed,2*nFixed> fixedSolver;
+	
+	try
+	{
+		timer = clock();
+		for(int i = 0; i < numTrials; i++) x = dynamicSolver.solve(H,f,B,z,x0);
+		timer = clock() - timer;
+		float t1 = (float)timer/(CLOCKS_PER_SEC*numTrials);
+		
+		timer = clock();
+		for(int i = 0; i < numTrials; i++) xFixed = fixedSolver.solve(HFixed,fFixed,BFixed,zFixed,x0Fixed);
+		timer = clock() - timer;
+		float t2 = (float)timer/(CLOCKS_PER_SEC*numTrials);
+		
+		std::cout << "\nThe dynamic solver took " << t1*1e6 << " us per solve (" << 1/t1 << " Hz).\n"
+		          << "\nThe fixed size solver took " << t2*1e6 << " us per solve (" << 1/t2 << " Hz).\n"
+		          << "\nThe fixed size solver was " << t1/t2 << " times faster. "
+		          << "The difference in solutions was " << (x - xFixed).norm() << ".\n\n";
+	}
+	catch(const std::exception &exception)
+	{
+		std::cout << exception.what() << std::endl;
+	}
+	
+	std::cout << "\n**********************************************************************\n"
+	          <<   "*                  BARRIER VERSUS PRIMAL-DUAL METHOD                 *\n"
+	          <<   "**********************************************************************\n" << std::endl;
+	
+	std::cout << "\nInequality constraints can also be solved with a primal-dual interior point method "
+	          << "by calling `solver.use_primal_dual_method();'. It stops when the optimality conditions "
+	          << "are satisfied, rather than after a fixed barrier schedule.\n"
+	          << "\nHere we solve the same problem as above with both methods.\n";
+	
+	QPSolver<float> primalDualSolver;
+	primalDualSolver.use_primal_dual_method();
+	
+	try
+	{
+		timer = clock();
+		for(int i = 0; i < numTrials; i++) x = dynamicSolver.solve(H,f,B,z,x0);
+		timer = clock() - timer;
+		float t1 = (float)timer/(CLOCKS_PER_SEC*numTrials);
+		
+		Eigen::VectorXf x2;
+		
+		timer = clock();
+		for(int i = 0; i < numTrials; i++) x2 = primalDualSolver.solve(H,f,B,z,x0);
+		timer = clock() - timer;
+		float t2 = (float)timer/(CLOCKS_PER_SEC*numTrials);
+		
+		float objective1 = 0.5*x.dot(H*x)   + x.dot(f);
+		float objective2 = 0.5*x2.dot(H*x2) + x2.dot(f);
+		
+		std::cout << "\nThe barrier method took " << dynamicSolver.num_steps() << " steps and "
+		          << t1*1e6 << " us to solve. The objective function was " << objective1 << ".\n"
+		          << "\nThe primal-dual method took " << primalDualSolver.num_steps() << " steps and "
+		          << t2*1e6 << " us to solve. The objective function was " << objective2 << ".\n"
+		          << "\nThe maximum constraint violation for the primal-dual method was "
+		          << (B*x2 - z).maxCoeff() << ".\n\n";
+	}
+	catch(const std::exception &exception)
+	{
+		std::cout << exception.what() << std::endl;
+	}
+	
+	std::cout << "\n**********************************************************************\n"
+	          <<   "*                         ACTIVE SET METHOD                          *\n"
+	          <<   "**********************************************************************\n" << std::endl;
+	
+	std::cout << "\nFor small, dense problems with a positive definite Hessian the dual active set method "
+	          << "can be used by calling `solver.use_active_set_method();'. It finds the exact solution "
+	          << "in a finite number of steps, and with `solver.use_warm_start();' it starts from the "
+	          << "active set of the last solution.\n"
+	          << "\nHere we solve the same problem as above, then a sequence of problems where f changes "
+	          << "slightly each time.\n";
+	
+	QPSolver<float> activeSetSolver;
+	activeSetSolver.use_active_set_method();
+	
+	try
+	{
+		Eigen::VectorXf x3;
+		
+		timer = clock();
+		for(int i = 0; i < numTrials; i++) x3 = activeSetSolver.solve(H,f,B,z,x0);
+		timer = clock() - timer;
+		float t3 = (float)timer/(CLOCKS_PER_SEC*numTrials);
+		
+		float objective3 = 0.5*x3.dot(H*x3) + x3.dot(f);
+		
+		std::cout << "\nThe active set method took " << activeSetSolver.num_steps() << " steps and "
+		          << t3*1e6 << " us to solve. The objective function was " << objective3 << ".\n"
+		          << "\nThe active constraints were:";
+		
+		for(unsigned int j : activeSetSolver.active_set()) std::cout << " " << j;
+		
+		std::cout << ".\n" << std::endl;
+		
+		// Slowly varying sequence of problems, as in model predictive control
+		std::vector<Eigen::VectorXf> sequence(numTrials);
+		for(int i = 0; i < numTrials; i++) sequence[i] = f + 2*sin(0.01*i)*Eigen::VectorXf::Ones(nFixed);
+		
+		unsigned int coldSteps = 0, warmSteps = 0;
+		
+		timer = clock();
+		for(int i = 0; i < numTrials; i++)
+		{
+			x3 = activeSetSolver.solve(H,sequence[i],B,z,x0);
+			coldSteps += activeSetSolver.num_steps();
+		}
+		timer = clock() - timer;
+		float t4 = (float)timer/(CLOCKS_PER_SEC*numTrials);
+		
+		activeSetSolver.use_warm_start();
+		
+		timer = clock();
+		for(int i = 0; i < numTrials; i++)
+		{
+			x3 = activeSetSolver.solve(H,sequence[i],B,z,x0);
+			warmSteps += activeSetSolver.num_steps();
+		}
+		timer = clock() - timer;
+		float t5 = (float)timer/(CLOCKS_PER_SEC*numTrials);
+		
+		std::cout << "\nFor the sequence, a cold start took " << (float)coldSteps/numTrials << " steps and "
+		          << t4*1e6 << " us per solve on average.\n"
+		          << "\nA warm start took " << (float)warmSteps/numTrials << " steps and "
+		          << t5*1e6 << " us per solve on average.\n\n";
+	}
+	catch(const std::exception &exception)
+	{
+		std::cout << exception.what() << std::endl;
+	}
+	
+	std::cout << "\n**********************************************************************\n"
+	          <<   "*                        SPARSE VERSUS DENSE                         *\n"
+	          <<   "**********************************************************************\n" << std::endl;
+	
+	n = 500;
+	
+	std::cout << "\nFor large problems where each constraint only involves a few variables, the matrices "
+	          << "can be given as Eigen::SparseMatrix. The symbolic analysis of the sparse decomposition "
+	          << "is reused for every step, and for every call with the same sparsity pattern.\n"
+	          << "\nHere we solve a problem with " << n << " variables, a banded Hessian and "
+	          << 2*n << " constraints -1 <= x <= 1.\n";
+	
+	std::vector<Eigen::Triplet<float>> triplets;
+	for(int i = 0; i < n; i++)
+	{
+		triplets.emplace_back(i,i,3.0);                                                     // Diagonally dominant, so positive definite
+		if(i > 0)   triplets.emplace_back(i,i-1,-1.0);
+		if(i < n-1) triplets.emplace_back(i,i+1,-1.0);
+	}
+	Eigen::SparseMatrix<float> HSparse(n,n);
+	HSparse.setFromTriplets(triplets.begin(), triplets.end());
+	
+	triplets.clear();
+	for(int i = 0; i < n; i++)
+	{
+		triplets.emplace_back(i,i,1.0);
+		triplets.emplace_back(n+i,i,-1.0);
+	}
+	Eigen::SparseMatrix<float> BSparse(2*n,n);
+	BSparse.setFromTriplets(triplets.begin(), triplets.end());
+	
+	H  = Eigen::MatrixXf(HSparse);
+	B  = Eigen::MatrixXf(BSparse);
+	f  = 10*Eigen::VectorXf::Random(n);
+	z  = Eigen::VectorXf::Ones(2*n);
+	x0 = Eigen::VectorXf::Zero(n);
+	
+	QPSolver<float> denseSolver, sparseSolver;
+	
+	try
+	{
+		const unsigned int numSparseTrials = 10;
+		
+		timer = clock();
+		for(int i = 0; i < numSparseTrials; i++) x = denseSolver.solve(H,f,B,z,x0);
+		timer = clock() - timer;
+		float t1 = (float)timer/(CLOCKS_PER_SEC*numSparseTrials);
+		
+		Eigen::VectorXf x2;
+		
+		timer = clock();
+		for(int i = 0; i < numSparseTrials; i++) x2 = sparseSolver.solve(HSparse,f,BSparse,z,x0);
+		timer = clock() - timer;
+		float t2 = (float)timer/(CLOCKS_PER_SEC*numSparseTrials);
+		
+		std::cout << "\nThe dense solver took " << t1*1000 << " ms per solve (" << 1/t1 << " Hz).\n"
+		          << "\nThe sparse solver took " << t2*1000 << " ms per solve (" << 1/t2 << " Hz).\n"
+		          << "\nThe sparse solver was " << t1/t2 << " times faster. "
+		          << "The difference in solutions was " << (x - x2).norm() << ".\n\n";
+	}
+	catch(const std::exception &exception)
+	{
+		std::cout << exception.what() << std::endl;
+	}
+	
+	std::cout << "\n**********************************************************************\n"
+	          <<   "*                               BATCH                                *\n"
+	          <<   "**********************************************************************\n" << std::endl;
+	
+	n = 10;
+	m = 2*n;
+	const unsigned int numBatch = 2000;
+	
+	std::cout << "Many independent problems can be solved in parallel with `solver.solve_batch(problems);'. "
+	          << "Each thread in the pool has its own workspace.\n"
+	          << "\nHere we solve " << numBatch << " problems with " << n << " variables and "
+	          << m << " constraints, one at a time and then as a batch.\n";
+	
+	std::vector<Eigen::MatrixXf> HBatch(numBatch);
+	std::vector<Eigen::VectorXf> fBatch(numBatch);
+	std::vector<QPSolver<float>::Problem> problems;
+	
+	B.resize(m,n);
+	B << Eigen::MatrixXf::Identity(n,n), -Eigen::MatrixXf::Identity(n,n);
+	z  = Eigen::VectorXf::Ones(m);
+	x0 = Eigen::VectorXf::Zero(n);
+	
+	for(int i = 0; i < numBatch; i++)
+	{
+		Eigen::MatrixXf R = Eigen::MatrixXf::Random(n,n);
+		HBatch[i] = R*R.transpose() + Eigen::MatrixXf::Identity(n,n);
+		fBatch[i] = 5*Eigen::VectorXf::Random(n);
+		problems.push_back({HBatch[i], fBatch[i], B, z, x0});
+	}
+	
+	QPSolver<float> serialSolver, batchSolver;
+	
+	std::vector<Eigen::VectorXf> serialSolutions(numBatch);
+	
+	auto start = std::chrono::steady_clock::now();                                              // clock() adds up the time on every thread
+	for(int i = 0; i < numBatch; i++) serialSolutions[i] = serialSolver.solve(HBatch[i],fBatch[i],B,z,x0);
+	float tSerial = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+	
+	start = std::chrono::steady_clock::now();
+	QPSolver<float>::SolutionList solutions = batchSolver.solve_batch(problems);
+	float tBatch = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+	
+	float error = 0;
+	unsigned int numSolved = 0;
+	for(int i = 0; i < numBatch; i++)
+	{
+		if(solutions[i].status == QPSolver<float>::solved)
+		{
+			numSolved++;
+			error = std::max(error, (solutions[i].x - serialSolutions[i]).norm());
+		}
+	}
+	
+	std::cout << "\nOne at a time took " << tSerial*1000 << " ms.\n"
+	          << "\nThe batch took " << tBatch*1000 << " ms with " << std::thread::hardware_concurrency()
+	          << " hardware threads, which was " << tSerial/tBatch << " times faster.\n"
+	          << "\n" << numSolved << " of " << numBatch << " problems were solved. "
+	          << "The largest difference in solutions was " << error << ".\n\n";
+	
+	std::cout << "\n**********************************************************************\n"
+	          <<   "*                              LOCKSTEP                              *\n"
+	          <<   "**********************************************************************\n" << std::endl;
+	
+	std::cout << "When the problems are tiny and all the same size, `solver.solve_lockstep(problems);' "
+	          << "steps 8 of them at a time together, so that each operation uses the full SIMD width.\n"
+	          << "\nHere we solve the same " << numBatch << " problems with the batch and lockstep functions.\n";
+	
+	start = std::chrono::steady_clock::now();
+	QPSolver<float>::SolutionList lockstepSolutions = batchSolver.solve_lockstep(problems);
+	float tLockstep = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+	
+	error = 0;
+	numSolved = 0;
+	for(int i = 0; i < numBatch; i++)
+	{
+		if(lockstepSolutions[i].status == QPSolver<float>::solved)
+		{
+			numSolved++;
+			error = std::max(error, (lockstepSolutions[i].x - serialSolutions[i]).norm());
+		}
+	}
+	
+	std::cout << "\nThe lockstep batch took " << tLockstep*1000 << " ms, which was " << tBatch/tLockstep
+	          << " times faster than the batch, and " << tSerial/tLockstep << " times faster than one at a time.\n"
+	          << "\n" << numSolved << " of " << numBatch << " problems were solved. "
+	          << "The largest difference in solutions was " << error << ".\n\n";
+	
+	std::cout << "\n**********************************************************************\n"
+	          <<   "*                   START POINTS AND INFEASIBILITY                   *\n"
+	          <<   "**********************************************************************\n" << std::endl;
+	
+	std::cout << "If x0 is outside the constraints, a phase I step first looks for a point inside them. "
+	          << "If there is none, `solver.status()' is QPSolver<float>::infeasible instead of an exception, "
+	          << "and `solver.infeasibility_certificate()' gives lambda >= 0 with B'*lambda = 0 and z'*lambda < 0.\n";
+	
+	n = 10;
+	
+	Eigen::MatrixXf RPhase = Eigen::MatrixXf::Random(n,n);
+	Eigen::MatrixXf HPhase = RPhase*RPhase.transpose() + Eigen::MatrixXf::Identity(n,n);
+	Eigen::VectorXf fPhase = Eigen::VectorXf::Random(n);
+	Eigen::MatrixXf BPhase(2*n+2,n);
+	BPhase << Eigen::MatrixXf::Random(2*n,n), Eigen::MatrixXf::Zero(2,n);
+	BPhase(2*n,0) = 1; BPhase(2*n+1,0) = -1;                                                    // -1 <= x(0) <= 1
+	Eigen::VectorXf zPhase = Eigen::VectorXf::Ones(2*n+2);
+	Eigen::VectorXf x0Phase = 10*Eigen::VectorXf::Ones(n);                                      // Outside the constraints
+	
+	QPSolver<float> phaseSolver;
+	phaseSolver.record_statistics(true);
+	
+	x = phaseSolver.solve(HPhase,fPhase,BPhase,zPhase,x0Phase);
+	
+	std::cout << "\nStarting from x0 = 10 for every variable, phase I took " << phaseSolver.statistics().phaseOneSteps
+	          << " steps, the status was " << ((phaseSolver.status() == QPSolver<float>::solved) ? "solved" : "infeasible")
+	          << ", and the largest constraint violation was " << (BPhase*x - zPhase).maxCoeff() << ".\n";
+	
+	zPhase(2*n) = zPhase(2*n+1) = -1;                                                           // x(0) <= -1 and x(0) >= 1
+	
+	start = std::chrono::steady_clock::now();
+	x = phaseSolver.solve(HPhase,fPhase,BPhase,zPhase,x0Phase);
+	float tInfeasible = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+	
+	const Eigen::VectorXf &certificate = phaseSolver.infeasibility_certificate();
+	
+	std::cout << "\nWith x(0) <= -1 and x(0) >= 1 the status was "
+	          << ((phaseSolver.status() == QPSolver<float>::infeasible) ? "infeasible" : "solved")
+	          << " after " << tInfeasible*1e6 << " us. For the certificate, ||B'*lambda|| = "
+	          << (BPhase.transpose()*certificate).norm() << " and z'*lambda = " << zPhase.dot(certificate)
+	          << ". The solution minimises the largest violation, which was " << (BPhase*x - zPhase).maxCoeff() << ".\n\n";
+	
+	std::cout << "\n**********************************************************************\n"
+	          <<   "*                       THOUSANDS OF CONSTRAINTS                     *\n"
+	          <<   "**********************************************************************\n" << std::endl;
+	
+	std::cout << "Calling `solver.use_parallel_assembly();' shares the rows of B between the threads "
+	          << "when computing the gradient, Hessian and step length. The partial sums are added in "
+	          << "a fixed order, so the solution is the same for any number of threads.\n";
+	
+	n = 50;
+	unsigned int numConstraints = 4000;
+	
+	Eigen::MatrixXf RLarge = Eigen::MatrixXf::Random(n,n);
+	Eigen::MatrixXf HLarge = RLarge*RLarge.transpose() + Eigen::MatrixXf::Identity(n,n);
+	Eigen::VectorXf fLarge = 10*Eigen::VectorXf::Random(n);
+	Eigen::MatrixXf BLarge = Eigen::MatrixXf::Random(numConstraints,n);
+	Eigen::VectorXf zLarge = Eigen::VectorXf::Ones(numConstraints);
+	Eigen::VectorXf x0Large = Eigen::VectorXf::Zero(n);
+	
+	QPSolver<float> serialAssemblySolver, parallelAssemblySolver, twoThreadSolver;
+	parallelAssemblySolver.use_parallel_assembly();
+	twoThreadSolver.use_parallel_assembly();
+	twoThreadSolver.set_num_threads(2);
+	
+	start = std::chrono::steady_clock::now();
+	Eigen::VectorXf xSerial = serialAssemblySolver.solve(HLarge,fLarge,BLarge,zLarge,x0Large);
+	float tSerialAssembly = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+	
+	start = std::chrono::steady_clock::now();
+	Eigen::VectorXf xParallel = parallelAssemblySolver.solve(HLarge,fLarge,BLarge,zLarge,x0Large);
+	float tParallelAssembly = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+	
+	Eigen::VectorXf xTwoThreads = twoThreadSolver.solve(HLarge,fLarge,BLarge,zLarge,x0Large);
+	
+	std::cout << "\nWith " << n << " variables and " << numConstraints << " constraints, the serial assembly took "
+	          << tSerialAssembly*1000 << " ms, and the parallel assembly took " << tParallelAssembly*1000 << " ms "
+	          << "(including starting the threads).\n"
+	          << "\nThe difference between the serial and parallel solutions was " << (xSerial - xParallel).norm()
+	          << ". With " << std::max(1u, std::thread::hardware_concurrency()) << " threads and 2 threads the solutions were "
+	          << ((xParallel == xTwoThreads) ? "identical" : "different") << ".\n\n";
+	
+	std::cout << "\n**********************************************************************\n"
+	          <<   "*                             STATISTICS                             *\n"
+	          <<   "**********************************************************************\n" << std::endl;
+	
+	std::cout << "Calling `solver.record_statistics(true);' records where the time went, and the "
+	          << "progress of every iteration. Here is the first problem from the batch:\n";
+	
+	QPSolver<float> statisticsSolver;
+	statisticsSolver.record_statistics(true);
+	
+	x = statisticsSolver.solve(HBatch[0],fBatch[0],B,z,x0);
+	
+	const QPSolver<float>::Statistics &statistics = statisticsSolver.statistics();
+	
+	std::cout << "\n   Step   Barrier   Step size   Min. slack   Objective\n";
+	for(const auto &iteration : statistics.iterations)
+	{
+		std::cout << "   " << iteration.step << "      " << iteration.barrier << "      " << iteration.stepNorm
+		          << "      " << iteration.minSlack << "      " << iteration.objective << "\n";
+	}
+	
+	std::cout << "\nIt took " << statistics.totalTime*1e6 << " us in total: " << statistics.assemblyTime*1e6
+	          << " us assembling the gradient and Hessian, " << statistics.factorisationTime*1e6 << " us on "
+	          << statistics.numFactorisations << " decompositions, and " << statistics.stepLengthTime*1e6
+	          << " us on the step length.\n\n";
+	
+	std::cout << "\n**********************************************************************\n"
+	          <<   "*                   PROBLEMS WITH CONSTANT MATRICES                  *\n"
+	          <<   "**********************************************************************\n" << std::endl;
+	
+	std::cout << "When only the vectors change between calls, e.g. xd and y in task space control, a "
+	          << "`QPProblem<float> problem(xd,W,A,y,B,z);' keeps the decompositions of W and A. "
+	          << "Call `problem.update_y(y);' and `problem.update_xd(xd);', then `problem.solve(x0);'.\n";
+	
+	n = 20;
+	m = 8;
+	
+	Eigen::MatrixXf WProblem = Eigen::MatrixXf::Identity(n,n);
+	Eigen::MatrixXf AProblem = Eigen::MatrixXf::Random(m,n);
+	Eigen::MatrixXf BProblem = Eigen::MatrixXf::Random(2*n,n);
+	Eigen::VectorXf zProblem = Eigen::VectorXf::Ones(2*n);
+	Eigen::VectorXf x0Problem = Eigen::VectorXf::Zero(n);
+	Eigen::VectorXf xdProblem = 0.1*Eigen::VectorXf::Random(n);
+	Eigen::VectorXf yProblem  = AProblem*(0.1*Eigen::VectorXf::Random(n));
+	
+	QPSolver<float> constantSolver;
+	QPProblem<float> problem(xdProblem,WProblem,AProblem,yProblem,BProblem,zProblem);
+	
+	constantSolver.use_dual();
+	problem.use_dual();
+	
+	float tSolver = 0.0, tProblem = 0.0, difference = 0.0;
+	
+	for(int i = 0; i < numTrials; i++)
+	{
+		xdProblem = 0.1*Eigen::VectorXf::Random(n);
+		yProblem  = AProblem*(0.1*Eigen::VectorXf::Random(n));
+		
+		auto tStart  = std::chrono::steady_clock::now();
+		Eigen::VectorXf xSolver = constantSolver.constrained_least_squares(xdProblem,WProblem,AProblem,yProblem,BProblem,zProblem,x0Problem);
+		auto tMiddle = std::chrono::steady_clock::now();
+		problem.update_xd(xdProblem);
+		problem.update_y(yProblem);
+		Eigen::VectorXf xProblem = problem.solve(x0Problem);
+		auto tEnd    = std::chrono::steady_clock::now();
+		
+		tSolver  += std::chrono::duration<float>(tMiddle - tStart).count();
+		tProblem += std::chrono::duration<float>(tEnd - tMiddle).count();
+		difference = std::max(difference, (xSolver - xProblem).norm());
+	}
+	
+	std::cout << "\nFor " << numTrials << " redundant problems with " << n << " variables and " << m << " equality constraints, "
+	          << "the solver took " << tSolver*1e6/numTrials << " us per solve, and the problem took "
+	          << tProblem*1e6/numTrials << " us per solve. That was " << tSolver/tProblem << " times faster.\n";
+	
+	std::cout << "\nThe largest difference in solutions was " << difference << ".\n";
+	
+	std::cout << "\nIf W changes by a few terms, `problem.rank_update_W(U);' adds U*U' to the decomposition "
+	          << "instead of computing it again, and `problem.add_constraint(b,z);' appends b'*x <= z without "
+	          << "decomposing anything.\n";
+	
+	Eigen::VectorXf uProblem = Eigen::VectorXf::Random(n);
+	Eigen::VectorXf bProblem = Eigen::VectorXf::Random(n);
+	
+	problem.rank_update_W(uProblem);
+	problem.add_constraint(bProblem, 0.5);
+	
+	WProblem += uProblem*uProblem.transpose();
+	BProblem.conservativeResize(2*n+1,n);
+	BProblem.row(2*n) = bProblem.transpose();
+	zProblem.conservativeResize(2*n+1);
+	zProblem(2*n) = 0.5;
+	
+	Eigen::VectorXf xUpdated = problem.solve(x0Problem);
+	Eigen::VectorXf xDecomposed = constantSolver.constrained_least_squares(xdProblem,WProblem,AProblem,yProblem,BProblem,zProblem,x0Problem);
+	
+	std::cout << "\nAfter W + u*u' and a new constraint, the difference from decomposing W again was "
+	          << (xUpdated - xDecomposed).norm() << ".\n";
+	
+	problem.rank_update_W(uProblem, -1);                                                        // Downdate back to W
+	problem.remove_constraint(2*n);
+	
+	WProblem -= uProblem*uProblem.transpose();
+	BProblem.conservativeResize(2*n,n);
+	zProblem.conservativeResize(2*n);
+	
+	xUpdated    = problem.solve(x0Problem);
+	xDecomposed = constantSolver.constrained_least_squares(xdProblem,WProblem,AProblem,yProblem,BProblem,zProblem,x0Problem);
+	
+	std::cout << "After removing them again it was " << (xUpdated - xDecomposed).norm() << ".\n\n";
+	
+	std::cout << "\n**********************************************************************\n"
+	          <<   "*                       CHOOSING A FACTORISATION                     *\n"
+	          <<   "**********************************************************************\n" << std::endl;
+	
+	std::cout << "The last template parameter chooses how the Newton step and the least squares problems "
+	          << "are factorised. LDLT is the default. `QPSolver<float,Eigen::Dynamic,Eigen::Dynamic,Eigen::Dynamic,LLTFactorisation>' "
+	          << "is faster when the matrices are positive definite, and QRFactorisation or CODFactorisation "
+	          << "are more robust when they are ill-conditioned.\n";
+	
+	QPSolver<float,Eigen::Dynamic,Eigen::Dynamic,Eigen::Dynamic,LLTFactorisation> lltSolver;
+	lltSolver.use_dual();
+	
+	float tLDLT = 0.0, tLLT = 0.0;
+	difference = 0.0;
+	
+	for(int i = 0; i < numTrials; i++)
+	{
+		auto tStart  = std::chrono::steady_clock::now();
+		Eigen::VectorXf xLDLT = constantSolver.constrained_least_squares(xdProblem,WProblem,AProblem,yProblem,BProblem,zProblem,x0Problem);
+		auto tMiddle = std::chrono::steady_clock::now();
+		Eigen::VectorXf xLLT  = lltSolver.constrained_least_squares(xdProblem,WProblem,AProblem,yProblem,BProblem,zProblem,x0Problem);
+		auto tEnd    = std::chrono::steady_clock::now();
+		
+		tLDLT += std::chrono::duration<float>(tMiddle - tStart).count();
+		tLLT  += std::chrono::duration<float>(tEnd - tMiddle).count();
+		difference = std::max(difference, (xLDLT - xLLT).norm());
+	}
+	
+	std::cout << "\nFor the same redundant problem, LDLT took " << tLDLT*1e6/numTrials << " us per solve, "
+	          << "and LLT took " << tLLT*1e6/numTrials << " us per solve. "
+	          << "The largest difference in solutions was " << difference << ".\n\n";
+	
+	std::cout << "\n**********************************************************************\n"
+	          <<   "*                           MIXED PRECISION                          *\n"
+	          <<   "**********************************************************************\n" << std::endl;
+	
+	std::cout << "Calling `solver.use_mixed_precision();' on a QPSolver<double> factorises the Hessian "
+	          << "in float, then corrects every Newton step with iterative refinement in double. "
+	          << "It is for large problems that need more accuracy than QPSolver<float> can give.\n";
+	
+	n = 300;
+	numConstraints = 600;
+	
+	Eigen::MatrixXd RMixed = Eigen::MatrixXd::Random(n,n);
+	Eigen::MatrixXd HMixed = RMixed*RMixed.transpose() + Eigen::MatrixXd::Identity(n,n);
+	Eigen::VectorXd fMixed = 10*Eigen::VectorXd::Random(n);
+	Eigen::MatrixXd BMixed = Eigen::MatrixXd::Random(numConstraints,n);
+	Eigen::VectorXd zMixed = Eigen::VectorXd::Ones(numConstraints);
+	Eigen::VectorXd x0Mixed = Eigen::VectorXd::Zero(n);
+	
+	QPSolver<double> doubleSolver, mixedSolver;
+	mixedSolver.use_mixed_precision();
+	mixedSolver.record_statistics(true);
+	
+	QPSolver<float> singleSolver;
+	
+	start = std::chrono::steady_clock::now();
+	Eigen::VectorXd xDouble = doubleSolver.solve(HMixed,fMixed,BMixed,zMixed,x0Mixed);
+	float tDouble = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+	
+	start = std::chrono::steady_clock::now();
+	Eigen::VectorXd xMixed = mixedSolver.solve(HMixed,fMixed,BMixed,zMixed,x0Mixed);
+	float tMixed = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+	
+	start = std::chrono::steady_clock::now();
+	Eigen::VectorXf xSingle = singleSolver.solve(HMixed.cast<float>(),fMixed.cast<float>(),BMixed.cast<float>(),
+	                                             zMixed.cast<float>(),x0Mixed.cast<float>());
+	float tSingle = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+	
+	std::cout << "\nWith " << n << " variables and " << numConstraints << " constraints, double took "
+	          << tDouble*1000 << " ms, mixed precision took " << tMixed*1000 << " ms with "
+	          << mixedSolver.statistics().numRefinements << " refinement steps, and float took "
+	          << tSingle*1000 << " ms.\n"
+	          << "\nThe difference from the double solution was " << (xMixed - xDouble).norm()
+	          << " for mixed precision, and " << (xSingle.cast<double>() - xDouble).norm() << " for float.\n\n";
+	
+	std::cout << "\n**********************************************************************\n"
+	          <<   "*                          CONSTRAINT SPACE                          *\n"
+	          <<   "**********************************************************************\n" << std::endl;
+	
+	std::cout << "With many variables and few constraints, the interior point algorithms factorise H "
+	          << "once and solve every Newton step in the space of the constraints. This is chosen "
+	          << "automatically when there are at least twice as many variables as constraints. "
+	          << "Call `solver.use_full_space();' or `solver.use_constraint_space();' to choose.\n";
+	
+	n = 500;
+	numConstraints = 10;
+	
+	Eigen::MatrixXd RSpace = Eigen::MatrixXd::Random(n,n);
+	Eigen::MatrixXd HSpace = RSpace*RSpace.transpose() + Eigen::MatrixXd::Identity(n,n);
+	Eigen::VectorXd fSpace = 10*Eigen::VectorXd::Random(n);
+	Eigen::MatrixXd BSpace = Eigen::MatrixXd::Random(numConstraints,n);
+	Eigen::VectorXd zSpace = Eigen::VectorXd::Ones(numConstraints);
+	Eigen::VectorXd x0Space = Eigen::VectorXd::Zero(n);
+	
+	QPSolver<double> fullSolver, constraintSolver;
+	fullSolver.use_full_space();
+	
+	start = std::chrono::steady_clock::now();
+	Eigen::VectorXd xFull = fullSolver.solve(HSpace,fSpace,BSpace,zSpace,x0Space);
+	float tFull = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+	
+	start = std::chrono::steady_clock::now();
+	Eigen::VectorXd xConstraint = constraintSolver.solve(HSpace,fSpace,BSpace,zSpace,x0Space);
+	float tConstraint = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+	
+	std::cout << "\nWith " << n << " variables and " << numConstraints << " constraints, the full space took "
+	          << tFull*1000 << " ms and the constraint space took " << tConstraint*1000 << " ms. "
+	          << "The difference in solutions was " << (xFull - xConstraint).norm() << ".\n\n";
+	
+	std::cout << "\n**********************************************************************\n"
+	          <<   "*                              PORTFOLIO                             *\n"
+	          <<   "**********************************************************************\n" << std::endl;
+	
+	std::cout << "Rather than comparing the methods by hand, `solver.set_portfolio(configurations);' "
+	          << "gives each configuration its own solver, and `solver.solve_portfolio(H,f,B,z,x0);' "
+	          << "races them on the thread pool. The first to reach the KKT tolerance is returned, "
+	          << "and the others are told to stop.\n";
+	
+	n = 100;
+	numConstraints = 200;
+	
+	Eigen::MatrixXd RRace = Eigen::MatrixXd::Random(n,n);
+	Eigen::MatrixXd HRace = RRace*RRace.transpose() + Eigen::MatrixXd::Identity(n,n);
+	Eigen::MatrixXd BRace = Eigen::MatrixXd::Random(numConstraints,n);
+	Eigen::VectorXd zRace = Eigen::VectorXd::Ones(numConstraints);
+	Eigen::VectorXd x0Race = Eigen::VectorXd::Zero(n);
+	
+	const std::vector<std::string> names = {"adaptive barrier", "primal-dual", "active set"};
+	
+	QPSolver<double> portfolioSolver;
+	portfolioSolver.set_portfolio({[](QPSolver<double> &solver){ solver.use_adaptive_barrier(); },
+	                               [](QPSolver<double> &solver){ solver.use_primal_dual_method(); },
+	                               [](QPSolver<double> &solver){ solver.use_active_set_method(); }});
+	
+	std::cout << "\n";
+	
+	for(int problem = 0; problem < 5; problem++)
+	{
+		Eigen::VectorXd fRace = 10*Eigen::VectorXd::Random(n);
+		
+		start = std::chrono::steady_clock::now();
+		Eigen::VectorXd xRace = portfolioSolver.solve_portfolio(HRace,fRace,BRace,zRace,x0Race);
+		float tRace = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+		
+		std::cout << "The " << names[portfolioSolver.portfolio_winner()] << " method won in "
+		          << tRace*1000 << " ms, with " << portfolioSolver.num_steps() << " steps.\n";
+		
+		if((BRace*xRace - zRace).maxCoeff() > 0) std::cerr << "\n[FLAGRANT SYSTEM ERROR] CONSTRAINT VIOLATED!\n";
+	}
+	
+	std::cout << "\nThe wins were:";
+	for(unsigned int i = 0; i < names.size(); i++) std::cout << " " << names[i] << " " << portfolioSolver.portfolio_wins()[i];
+	std::cout << ".\n\n";
+	
+	std::cout << "\n**********************************************************************\n"
+	          <<   "*                              DEADLINE                              *\n"
+	          <<   "**********************************************************************\n" << std::endl;
+	
+	std::cout << "A controller has a fixed time for each tick. `solver.set_time_budget(seconds);' "
+	          << "stops the interior point and active set methods when it runs out, and returns the "
+	          << "best point inside the constraints found so far. `solver.status()' is then `timedOut'.\n";
+	
+	n = 300;
+	numConstraints = 600;
+	
+	Eigen::MatrixXd RTick = Eigen::MatrixXd::Random(n,n);
+	Eigen::MatrixXd HTick = RTick*RTick.transpose() + Eigen::MatrixXd::Identity(n,n);
+	Eigen::VectorXd fTick = 10*Eigen::VectorXd::Random(n);
+	Eigen::MatrixXd BTick = Eigen::MatrixXd::Random(numConstraints,n);
+	Eigen::VectorXd zTick = Eigen::VectorXd::Ones(numConstraints);
+	Eigen::VectorXd x0Tick = Eigen::VectorXd::Zero(n);
+	
+	QPSolver<double> tickSolver;
+	tickSolver.use_primal_dual_method();
+	
+	start = std::chrono::steady_clock::now();
+	Eigen::VectorXd xTick = tickSolver.solve(HTick,fTick,BTick,zTick,x0Tick);
+	float tTick = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+	
+	std::cout << "\nWith no limit, the primal-dual method took " << tTick*1000 << " ms and "
+	          << tickSolver.num_steps() << " steps.\n";
+	
+	tickSolver.set_time_budget(0.3*tTick);
+	
+	start = std::chrono::steady_clock::now();
+	xTick = tickSolver.solve(HTick,fTick,BTick,zTick,x0Tick);
+	tTick = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+	
+	std::cout << "With 30% of that time, it stopped after " << tTick*1000 << " ms and "
+	          << tickSolver.num_steps() << " steps";
+	if(tickSolver.status() == QPSolver<double>::timedOut) std::cout << ", and reported that it ran out of time";
+	std::cout << ".\n";
+	
+	if((BTick*xTick - zTick).maxCoeff() > 0) std::cerr << "\n[FLAGRANT SYSTEM ERROR] CONSTRAINT VIOLATED!\n";
+	
+	tickSolver.set_time_budget(0);                                                              // No limit
+	
+	std::cout << "\n`solver.solve_async(H,f,B,z,x0);' solves on another thread and returns a std::future. "
+	          << "Calling `solver.cancel();' stops it on its next step.\n";
+	
+	std::future<QPSolver<double>::Solution> future = tickSolver.solve_async(HTick,fTick,BTick,zTick,x0Tick);
+	
+	tickSolver.cancel();
+	
+	QPSolver<double>::Solution tickSolution = future.get();
+	
+	std::cout << "\nThe cancelled solve took " << tickSolution.numSteps << " steps";
+	if(tickSolution.status == QPSolver<double>::cancelled) std::cout << " and reported that it was cancelled";
+	std::cout << ".\n\n";
+	
+	std::cout << "\n**********************************************************************\n"
+	          <<   "*                          ADAPTIVE BARRIER                          *\n"
+	          <<   "**********************************************************************\n" << std::endl;
+	
+	std::cout << "Calling `solver.use_adaptive_barrier();' reduces the barrier according to how close "
+	          << "the solver is to the central path, and stops once the duality gap is within "
+	          << "`set_kkt_tolerance()'. With a fixed rate below 0.5, a Newton step overshoots the "
+	          << "active constraints and stalls against them, and with a rate above it the barrier is "
+	          << "reduced more slowly than it could be.\n";
+	
+	n = 20;
+	numConstraints = 40;
+	
+	QPSolver<double> exactSolver, defaultSolver, adaptiveSolver, halfSolver;
+	exactSolver.use_active_set_method();                                                        // For the optimal objective
+	adaptiveSolver.use_adaptive_barrier();
+	
+	// Run a fixed rate of 0.5 for long enough, and count the steps until it is as accurate
+	halfSolver.set_barrier_reduction_rate(0.5);
+	halfSolver.set_tolerance(1e-12);
+	halfSolver.set_max_steps(100);
+	halfSolver.record_statistics(true);
+	
+	std::cout << "\n";
+	
+	for(int problem = 0; problem < 5; problem++)
+	{
+		Eigen::MatrixXd RAdaptive = Eigen::MatrixXd::Random(n,n);
+		Eigen::MatrixXd HAdaptive = RAdaptive*RAdaptive.transpose() + Eigen::MatrixXd::Identity(n,n);
+		Eigen::VectorXd fAdaptive = 10*Eigen::VectorXd::Random(n);
+		Eigen::MatrixXd BAdaptive = Eigen::MatrixXd::Random(numConstraints,n);
+		Eigen::VectorXd zAdaptive = Eigen::VectorXd::Ones(numConstraints);
+		Eigen::VectorXd x0Adaptive = Eigen::VectorXd::Zero(n);
+		
+		Eigen::VectorXd xExact = exactSolver.solve(HAdaptive,fAdaptive,BAdaptive,zAdaptive,x0Adaptive);
+		
+		double optimum = 0.5*xExact.dot(HAdaptive*xExact) + fAdaptive.dot(xExact);
+		
+		auto error = [&](const Eigen::VectorXd &x)                                          // Relative error in the objective
+		{
+			return (0.5*x.dot(HAdaptive*x) + fAdaptive.dot(x) - optimum)/(1 + std::abs(optimum));
+		};
+		
+		Eigen::VectorXd xDefault  = defaultSolver.solve(HAdaptive,fAdaptive,BAdaptive,zAdaptive,x0Adaptive);
+		Eigen::VectorXd xAdaptive = adaptiveSolver.solve(HAdaptive,fAdaptive,BAdaptive,zAdaptive,x0Adaptive);
+		
+		halfSolver.solve(HAdaptive,fAdaptive,BAdaptive,zAdaptive,x0Adaptive);
+		
+		unsigned int halfSteps = halfSolver.num_steps();
+		for(const QPSolver<double>::Iteration &iteration : halfSolver.statistics().iterations)
+		{
+			if((iteration.objective - optimum)/(1 + std::abs(optimum)) <= std::abs(error(xAdaptive)))
+			{
+				halfSteps = iteration.step - 1;                                     // Objective is before the step
+				break;
+			}
+		}
+		
+		std::cout << "Problem " << problem+1 << ": the default fixed rate took " << defaultSolver.num_steps()
+		          << " steps with a relative error in the objective of " << error(xDefault)
+		          << ". The adaptive barrier took " << adaptiveSolver.num_steps() << " steps with an error of "
+		          << error(xAdaptive) << ". A fixed rate of 0.5 took " << halfSteps << " steps to get as close, "
+		          << "so the adaptive barrier saved " << (int)halfSteps - (int)adaptiveSolver.num_steps() << ".\n";
+	}
+	
+	std::cout << "\n";
+	
+	std::cout << "\n**********************************************************************\n"
+	          <<   "*                EQUALITY AND INEQUALITY CONSTRAINTS                 *\n"
+	          <<   "**********************************************************************\n" << std::endl;
+	
+	std::cout << "Calling `solver.solve(H,f,A,y,B,z,x0)' solves:\n"
+	          << "\n      min 0.5*x'*H*x + x'*f\n"
+	          << "     subject to: A*x  = y\n"
+	          << "                 B*x <= z\n"
+	          << "\nThe equalities are part of the Newton step rather than the inequality constraints. "
+	          << "Writing them as the pair A*x <= y, -A*x <= -y leaves no interior for the barrier, "
+	          << "so they must be loosened by a small band instead.\n\n";
+	
+	n = 30;
+	m = 5;
+	numConstraints = 2*n;
+	
+	Eigen::MatrixXd REquality = Eigen::MatrixXd::Random(n,n);
+	Eigen::MatrixXd HEquality = REquality*REquality.transpose() + Eigen::MatrixXd::Identity(n,n);
+	Eigen::VectorXd fEquality = Eigen::VectorXd::Random(n);
+	Eigen::MatrixXd AEquality = Eigen::MatrixXd::Random(m,n);
+	Eigen::VectorXd yEquality = 0.1*Eigen::VectorXd::Random(m);
+	Eigen::MatrixXd BEquality(numConstraints,n);
+	BEquality << Eigen::MatrixXd::Identity(n,n), -Eigen::MatrixXd::Identity(n,n);
+	Eigen::VectorXd zEquality = Eigen::VectorXd::Ones(numConstraints);
+	Eigen::VectorXd x0Equality = Eigen::VectorXd::Zero(n);
+	
+	// Same problem with the equalities as pairs of inequalities, loosened by a band
+	const double band = 1e-04;
+	Eigen::MatrixXd BPaired(numConstraints+2*m,n);
+	BPaired << BEquality, AEquality, -AEquality;
+	Eigen::VectorXd zPaired(numConstraints+2*m);
+	zPaired << zEquality, yEquality + band*Eigen::VectorXd::Ones(m), -yEquality + band*Eigen::VectorXd::Ones(m);
+	
+	QPSolver<double> equalitySolver, pairedSolver, referenceSolver;
+	referenceSolver.use_active_set_method();
+	
+	Eigen::VectorXd xReference = referenceSolver.solve(HEquality,fEquality,AEquality,yEquality,BEquality,zEquality,x0Equality);
+	
+	std::cout << "\nUsing the active set method as the reference solution x*, the error ||y - A*x*|| is "
+	          << (yEquality - AEquality*xReference).norm() << ".\n";
+	
+	for(int algorithm = 0; algorithm < 2; algorithm++)
+	{
+		if(algorithm == 0)
+		{
+			equalitySolver.use_adaptive_barrier();
+			pairedSolver.use_adaptive_barrier();
+		}
+		else
+		{
+			equalitySolver.use_primal_dual_method();
+			pairedSolver.use_primal_dual_method();
+		}
+		
+		Eigen::VectorXd xEquality = equalitySolver.solve(HEquality,fEquality,AEquality,yEquality,BEquality,zEquality,x0Equality);
+		unsigned int equalitySteps = equalitySolver.num_steps();
+		
+		equalitySolver.use_null_space();
+		Eigen::VectorXd xNullSpace = equalitySolver.solve(HEquality,fEquality,AEquality,yEquality,BEquality,zEquality,x0Equality);
+		equalitySolver.use_primal();
+		
+		Eigen::VectorXd xPaired = pairedSolver.solve(HEquality,fEquality,BPaired,zPaired,x0Equality);
+		
+		std::cout << (algorithm == 0 ? "\nWith the adaptive barrier" : "\nWith the primal-dual method")
+		          << ", the KKT formulation took " << equalitySteps << " steps with ||y - A*x|| = "
+		          << (yEquality - AEquality*xEquality).norm() << " and ||x - x*|| = " << (xEquality - xReference).norm()
+		          << ". The null space formulation took " << equalitySolver.num_steps() << " steps with ||y - A*x|| = "
+		          << (yEquality - AEquality*xNullSpace).norm() << " and ||x - x*|| = " << (xNullSpace - xReference).norm()
+		          << ". The paired inequalities took " << pairedSolver.num_steps() << " steps with ||y - A*x|| = "
+		          << (yEquality - AEquality*xPaired).norm() << ".\n";
+		
+		if((BEquality*xEquality - zEquality).maxCoeff() > 0 or (BEquality*xNullSpace - zEquality).maxCoeff() > 0)
+		{
+			std::cerr << "\n[FLAGRANT SYSTEM ERROR] CONSTRAINT VIOLATED!\n";
+		}
+	}
+	
+	std::cout << "\n";
+	
+	std::cout << "\n**********************************************************************\n"
+	          <<   "*                   OPTIMAL CONTROL OVER A HORIZON                   *\n"
+	          <<   "**********************************************************************\n" << std::endl;
+	
+	std::cout << "A point mass in the plane moves to the origin, with the speed and acceleration "
+	          << "limited to 1 in each direction. The stages are solved with a Riccati recursion, so the "
+	          << "time grows linearly with the horizon.\n\n";
+	
+	const float dt = 0.1;
+	
+	MPCSolver<float>::Stage stage;
+	stage.A = Eigen::MatrixXf::Identity(4,4);                                                   // State is [position; velocity]
+	stage.A.topRightCorner(2,2) = dt*Eigen::MatrixXf::Identity(2,2);
+	stage.B.setZero(4,2);                                                                       // Control is acceleration
+	stage.B.topRows(2)    = 0.5*dt*dt*Eigen::MatrixXf::Identity(2,2);
+	stage.B.bottomRows(2) = dt*Eigen::MatrixXf::Identity(2,2);
+	stage.Q = Eigen::MatrixXf::Identity(4,4);
+	stage.R = 0.01*Eigen::MatrixXf::Identity(2,2);
+	stage.D.setZero(8,4);
+	stage.D.block(0,2,2,2) =  Eigen::MatrixXf::Identity(2,2);
+	stage.D.block(2,2,2,2) = -Eigen::MatrixXf::Identity(2,2);
+	stage.E.setZero(8,2);
+	stage.E.block(4,0,2,2) =  Eigen::MatrixXf::Identity(2,2);
+	stage.E.block(6,0,2,2) = -Eigen::MatrixXf::Identity(2,2);
+	stage.e = Eigen::VectorXf::Ones(8);
+	
+	Eigen::VectorXf x0MPC(4);
+	x0MPC << 1, -1, 0, 0;
+	
+	MPCSolver<float> mpc;
+	
+	for(unsigned int T : {10, 50, 200})
+	{
+		std::vector<MPCSolver<float>::Stage> stages(T+1, stage);
+		stages[T].D = stage.D.topRows(4);                                                   // No control on the terminal stage
+		stages[T].e = Eigen::VectorXf::Ones(4);
+		
+		auto tStart = std::chrono::steady_clock::now();
+		for(int i = 0; i < 100; i++) mpc.solve(stages, x0MPC);
+		auto tEnd   = std::chrono::steady_clock::now();
+		
+		std::cout << "With " << T << " stages it took " << std::chrono::duration<float>(tEnd - tStart).count()*1e4 << " us "
+		          << "and " << mpc.num_steps() << " steps. The first control was "
+		          << mpc.control(0).transpose() << ", and the final position was "
+		          << mpc.state(T).head(2).transpose() << ".\n";
+	}
+	
+	std::cout << "\n";
+	
 	return 0; 
 }